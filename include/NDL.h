@@ -154,16 +154,74 @@ void NDL_AddSpriteComponent(NDL_Entity *entity, Vector2 size, NDL_Color spriteCo
 
 void NDL_AddColliderComponent(NDL_Entity* entity, Vector2 size, NDL_Color colliderColor);
 
+/*
+ * Function: NDL_AddCircleColliderComponent
+ * ----------------------------------------
+ * Adds a circle collider of the given radius; its bounding box is the circle's diameter square.
+ */
+void NDL_AddCircleColliderComponent(NDL_Entity* entity, float radius, NDL_Color colliderColor);
+
+/*
+ * Function: NDL_AddCapsuleColliderComponent
+ * -----------------------------------------
+ * Adds a capsule collider filling size, with rounded caps on the shorter axis.
+ */
+void NDL_AddCapsuleColliderComponent(NDL_Entity* entity, Vector2 size, NDL_Color colliderColor);
+
 void NDL_RemComponent(NDL_Entity* e, Components component);
 
 bool NDL_HasComponent(NDL_Entity* e, Components component);
 
 void NDL_AddSpriteTexture(Renderer ren, NDL_Entity* e, const char* fp);
 
+/*
+ * Function: NDL_AddSpriteTextureMask
+ * ----------------------------------
+ * Loads an image as the entity's texture and builds its collider's pixel mask from the same
+ * pixels, reading the file once. The entity needs a collider component for the mask.
+ */
+void NDL_AddSpriteTextureMask(Renderer ren, NDL_Entity* e, const char* fp, Uint8 alphaThreshold);
+
+/*
+ * Function: NDL_AddSpriteTextureAtlas
+ * -----------------------------------
+ * Packs an image into atlas and points the entity's sprite at the packed region.
+ */
+void NDL_AddSpriteTextureAtlas(NDL_Atlas* atlas, NDL_Entity* e, const char* fp);
+
+/*
+ * Function: NDL_SetSpriteRegion
+ * -----------------------------
+ * Points the sprite at an atlas region, e.g. one filled by NDL_AtlasAddImage.
+ */
+void NDL_SetSpriteRegion(NDL_SpriteComponent* sprite, const NDL_AtlasRegion* region);
+
+/*
+ * Function: NDL_SetSpriteLayer
+ * ----------------------------
+ * Sets the draw layer; the render queue draws lower layers first.
+ */
+void NDL_SetSpriteLayer(NDL_Entity* e, Uint8 layer);
+
+/*
+ * Function: NDL_SetSpriteStatic
+ * -----------------------------
+ * Marks a sprite that never moves, so the render system's static layer can cache it while
+ * it is unrotated.
+ */
+void NDL_SetSpriteStatic(NDL_Entity* e, bool isStatic);
+
 void NDL_SetEntityTag(NDL_Entity* entity, const char* tag);
 
 void NDL_SetEntityDynamic(NDL_Entity* entity, bool set);
 
+/*
+ * Function: NDL_SetEntitySleeping
+ * -------------------------------
+ * Puts an entity to sleep or wakes it. Sleeping entities are skipped by integration.
+ */
+void NDL_SetEntitySleeping(NDL_Entity* entity, bool sleeping);
+
 void NDL_SetEntityMass(NDL_Entity* e, float mass);
 
 void NDL_RemEntityTag(NDL_Entity* entity);
@@ -174,12 +232,79 @@ void NDL_RemColliderComponent(NDL_Entity* entity);
 
 void NDL_UpdateSystem(NDL_RenderSystem* renSys, NDL_PhysicsSystem* physicsSystem, float deltaTime, int UPF);
 
+/*
+ * Function: NDL_StepPhysicsFixed
+ * ------------------------------
+ * Runs NDL_UpdateSystem in ticks of the physics system's fixed step for as much of deltaTime as
+ * has accumulated, then sets the render system's interpolation alpha to the fraction of a tick
+ * left over. Sprites are drawn that far between their last two ticks, so physics can tick at
+ * 30 Hz while rendering stays smooth at any frame rate. Sprites moved outside the physics system
+ * should be placed with NDL_SnapSpriteTransform so they do not blend from a stale position.
+ *
+ * Returns:
+ *   int: The number of ticks run this frame.
+ */
+int NDL_StepPhysicsFixed(NDL_RenderSystem* renSys, NDL_PhysicsSystem* physicsSystem, float deltaTime, int UPF);
+
+// Copies the entity's simulated position to its sprite, keeping the old one for interpolation
+void NDL_SyncSpriteTransform(NDL_Entity* entity);
+
+// Syncs without interpolating from the old position, for teleports and spawns
+void NDL_SnapSpriteTransform(NDL_Entity* entity);
+
+/*
+ * Function: NDL_SetSpritePosition
+ * -------------------------------
+ * Places a sprite at a float position, writing position, previousPosition and imageRect together
+ * so it draws there with sub-pixel precision and without blending from where it was. Sprites only
+ * ever moved through imageRect keep drawing at imageRect, as before.
+ */
+void NDL_SetSpritePosition(NDL_SpriteComponent* sprite, Vector2F position);
+
+/*
+ * Function: NDL_GetPhysicsStats
+ * -----------------------------
+ * Returns the counters and stage timings gathered during the last NDL_UpdateSystem call:
+ * bodies integrated and sleeping, broadphase pairs, narrowphase tests, resolved contacts,
+ * pixel-mask sensor overlaps, grid cell occupancy and the time spent reordering, applying
+ * forces, integrating and colliding. Stage timings other than reorder and total stay zero
+ * unless NDL_SetPhysicsSystemProfiling is on.
+ *
+ * Returns:
+ *   NDL_PhysicsStats: A copy of the latest statistics.
+ */
+NDL_PhysicsStats NDL_GetPhysicsStats(NDL_PhysicsSystem* phys);
+
+/*
+ * Function: NDL_PrintPhysicsStats
+ * -------------------------------
+ * Prints the counters and timings of the last NDL_UpdateSystem call; see NDL_GetPhysicsStats.
+ */
+void NDL_PrintPhysicsStats(NDL_PhysicsSystem* phys);
+
 void NDL_SetPhysicsSystemGravity(NDL_PhysicsSystem* phys, float gravity);
 
 void NDL_SetPhysicsSystemFrictionX(NDL_PhysicsSystem* phys, float frictionX);
 
 void NDL_SetPhysicsSystemFrictionY(NDL_PhysicsSystem* phys, float frictionY);
 
+/*
+ * Function: NDL_SetPhysicsSystemReorderInterval
+ * ---------------------------------------------
+ * Runs NDL_ReorderPhysicsGrid every frames updates; 0 turns reordering off.
+ */
+void NDL_SetPhysicsSystemReorderInterval(NDL_PhysicsSystem* phys, int frames);
+
+// Enables the forces, integrate and collision timings in NDL_PhysicsStats; counters are always kept
+void NDL_SetPhysicsSystemProfiling(NDL_PhysicsSystem* phys, bool profileStages);
+
+/*
+ * Function: NDL_SetPhysicsSystemTickRate
+ * --------------------------------------
+ * Steps physics at a fixed ticksPerSecond rate, carrying leftover frame time to the next update.
+ */
+void NDL_SetPhysicsSystemTickRate(NDL_PhysicsSystem* phys, float ticksPerSecond);
+
 bool NDL_EnablePhysicsSystemFrictionX(NDL_PhysicsSystem* phys, bool frictionX);
 
 bool NDL_EnablePhysicsSystemFrictionY(NDL_PhysicsSystem* phys, bool frictionY);
@@ -192,10 +317,189 @@ void NDL_SetRenderSystemShowColliders(NDL_RenderSystem* renSys, bool showCollide
 
 void NDL_SetRenderSystemClearColor(NDL_RenderSystem* renSys, NDL_Color clearColor);
 
+/*
+ * Function: NDL_SetRenderSystemBatching
+ * -------------------------------------
+ * Draws sprites through a sprite batch grouped by texture instead of one SDL call each.
+ */
+void NDL_SetRenderSystemBatching(NDL_RenderSystem* renSys, bool useBatching);
+
+/*
+ * Function: NDL_GetRenderSystemDrawCalls
+ * --------------------------------------
+ * Returns:
+ *   int: The number of draw calls the last NDL_Render call issued.
+ */
+int NDL_GetRenderSystemDrawCalls(NDL_RenderSystem* renSys);
+
+/*
+ * Function: NDL_SetRenderSystemYSort
+ * ----------------------------------
+ * Sorts sprites within a layer by the bottom edge of their rect, for top-down scenes.
+ */
+void NDL_SetRenderSystemYSort(NDL_RenderSystem* renSys, bool ySort);
+
+/*
+ * Function: NDL_SetRenderSystemCamera
+ * -----------------------------------
+ * Draws through camera, or in world coordinates when camera is NULL.
+ */
+void NDL_SetRenderSystemCamera(NDL_RenderSystem* renSys, NDL_Camera* camera);
+
+/*
+ * Function: NDL_SetRenderSystemCullGrid
+ * -------------------------------------
+ * Culls through grid's cells instead of testing every entity against the view.
+ *
+ * The grid rebins after each physics step. Entities moved by hand outside NDL_UpdateSystem
+ * need NDL_RebinPhysicsGrid before the next render, or they are culled from their old cell.
+ */
+void NDL_SetRenderSystemCullGrid(NDL_RenderSystem* renSys, NDL_PhysicsGrid* grid);
+
+/*
+ * Function: NDL_SetRenderSystemTilemap
+ * ------------------------------------
+ * Draws tilemap under the sprites each frame, or nothing when NULL.
+ */
+void NDL_SetRenderSystemTilemap(NDL_RenderSystem* renSys, NDL_Tilemap* tilemap);
+
+/*
+ * Function: NDL_SetRenderSystemStaticCaching
+ * ------------------------------------------
+ * Caches static sprites in a render-target layer that is only redrawn where it changes.
+ * Turning caching off frees the layer.
+ */
+void NDL_SetRenderSystemStaticCaching(NDL_RenderSystem* renSys, bool enable);
+
+/*
+ * Function: NDL_SetRenderSystemScheduler
+ * --------------------------------------
+ * Keeps an idle-mode scheduler rendering while anything drawn animates. NDL_Render requests the
+ * next frame while a visible legacy animation runs, as does NDL_UpdateAnimationSystem when it is
+ * given this render system and advanced anything. NULL stops the requests.
+ */
+void NDL_SetRenderSystemScheduler(NDL_RenderSystem* renSys, NDL_FrameScheduler* scheduler);
+
+// Records culling, sort keys and vertices on the caller's pool, which must outlive it; SDL calls stay on this thread
+void NDL_SetRenderSystemThreading(NDL_RenderSystem* renSys, bool enable, NDL_ThreadPool* pool);
+
+// Draws through a CPU rasterizer instead of SDL; the tilemap and static layer are skipped meanwhile
+void NDL_SetRenderSystemSoftRenderer(NDL_RenderSystem* renSys, NDL_SoftRenderer* soft);
+
 void NDL_AddAnimationComponent(NDL_Entity *entity, NDL_ImageSet* images, bool loop, int flipRate);
 
 void NDL_SetAnimationImageSet(NDL_ImageSet* imageSet, NDL_AnimationComponent* anim);
 
+/*
+ * Function: NDL_SetAnimationRate
+ * ------------------------------
+ * Sets the playback rate in frames per second, also in the animation system if it is in one.
+ */
+void NDL_SetAnimationRate(NDL_AnimationComponent* anim, float framesPerSecond);
+
+/*
+ * Function: NDL_SetAnimationMode
+ * ------------------------------
+ * Sets whether the animation loops, plays once or ping-pongs.
+ */
+void NDL_SetAnimationMode(NDL_AnimationComponent* anim, NDL_ANIMATION_MODES mode);
+
+/*
+ * Function: NDL_SetAnimationEvents
+ * --------------------------------
+ * Calls onEvent when the animation enters frame n for each bit n set in eventFrames, as well as
+ * when it loops or finishes.
+ */
+void NDL_SetAnimationEvents(NDL_AnimationComponent* anim, Uint64 eventFrames, AnimEventMethod onEvent);
+
+/*
+ * Function: NDL_SetAnimationClock
+ * -------------------------------
+ * Follows a shared clock instead of the component's own timing, or its own again when NULL.
+ */
+void NDL_SetAnimationClock(NDL_AnimationComponent* anim, NDL_AnimationClock* clock);
+
+/*
+ * Function: NDL_RestartAnimation
+ * ------------------------------
+ * Rewinds the animation to frame 0 and clears its finished flag.
+ */
+void NDL_RestartAnimation(NDL_AnimationComponent* anim);
+
+// Starts the entity as a root at its current position, unrotated and unscaled
+void NDL_AddTransformComponent(NDL_Entity* entity);
+
+/*
+ * Function: NDL_CreateTransformSystem
+ * -----------------------------------
+ * Creates an empty transform system with room for capacity transforms; it grows as needed.
+ */
+NDL_TransformSystem* NDL_CreateTransformSystem(int capacity);
+
+/*
+ * Function: NDL_DestroyTransformSystem
+ * ------------------------------------
+ * Frees the system and detaches its transforms; the entities are left alone.
+ */
+void NDL_DestroyTransformSystem(NDL_TransformSystem* system);
+
+/*
+ * Function: NDL_AddToTransformSystem
+ * ----------------------------------
+ * Adds an entity's transform component, to be resolved by the next system update.
+ */
+void NDL_AddToTransformSystem(NDL_TransformSystem* system, NDL_Entity* e);
+
+// Any children are kept in place as new roots
+void NDL_RemoveFromTransformSystem(NDL_TransformSystem* system, NDL_Entity* e);
+
+/*
+ * Function: NDL_SetTransformParent
+ * --------------------------------
+ * Attaches an entity's transform under parent's, or makes it a root when parent is NULL. Both
+ * must already be in the same transform system. Its local position then becomes an offset from
+ * the parent's origin, and children should not be dynamic since the system writes their position.
+ */
+void NDL_SetTransformParent(NDL_Entity* e, NDL_Entity* parent);
+
+/*
+ * Function: NDL_SetTransformPosition
+ * ----------------------------------
+ * Sets the local position. Roots move the entity and its sprite at once; children follow on the
+ * next system update.
+ */
+void NDL_SetTransformPosition(NDL_Entity* e, float x, float y);
+
+/*
+ * Function: NDL_SetTransformRotation
+ * ----------------------------------
+ * Sets the local rotation in degrees.
+ */
+void NDL_SetTransformRotation(NDL_Entity* e, float degrees);
+
+/*
+ * Function: NDL_SetTransformScale
+ * -------------------------------
+ * Sets the local scale; children inherit it on the next system update.
+ */
+void NDL_SetTransformScale(NDL_Entity* e, float scaleX, float scaleY);
+
+/*
+ * Function: NDL_UpdateTransformSystem
+ * -----------------------------------
+ * Recomputes world transforms for dirty subtrees in depth order and writes them to the entities
+ * and their sprites. Roots are marked dirty when their entity moved, so call it after the physics
+ * step and before NDL_Render. Children keep their root's interpolation lag, so hierarchies stay
+ * together when sprites are drawn between ticks.
+ *
+ * Parameters:
+ *   system: The transform system.
+ *
+ * Returns:
+ *   void: This function does not return a value.
+ */
+void NDL_UpdateTransformSystem(NDL_TransformSystem* system);
+
 #include "NDL_P.h"
 #include "NDL_G.h"
 #include "NDL_M.h"
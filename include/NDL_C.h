@@ -33,6 +33,13 @@
 #include "SDL_image.h"
 #undef main
 
+#if defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
+#include <immintrin.h>
+#define NDL_SIMD_X86
+#define NDL_TARGET_SSE2 __attribute__((target("sse2")))
+#define NDL_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
 
 #define NDL_KEY_UP_ARROW SDL_SCANCODE_UP
 #define NDL_KEY_DOWN_ARROW SDL_SCANCODE_DOWN
@@ -137,6 +144,7 @@ typedef struct NDL_PhysicsSystem NDL_PhysicsSystem;
 typedef struct NDL_RenderSystem NDL_RenderSystem;
 typedef struct NDL_PhysicsGrid NDL_PhysicsGrid;
 typedef struct NDL_Clock NDL_Clock;
+typedef struct NDL_FrameScheduler NDL_FrameScheduler;
 typedef struct NDL_Entity NDL_Entity;
 typedef struct Keybinds Keybinds;
 typedef struct NDL_Rect NDL_Rect;
@@ -144,12 +152,61 @@ typedef enum Components Components;
 typedef struct NDL_ImageSet NDL_ImageSet;
 typedef struct NDL_AnimationComponent NDL_AnimationComponent;
 typedef NDL_Texture* (*AnimFlipMethod) (NDL_AnimationComponent*, float);
+typedef enum NDL_ANIMATION_MODES NDL_ANIMATION_MODES;
+typedef enum NDL_ANIMATION_EVENTS NDL_ANIMATION_EVENTS;
+typedef struct NDL_AnimationClock NDL_AnimationClock;
+typedef struct NDL_AnimationSystem NDL_AnimationSystem;
+typedef struct NDL_ThreadPool NDL_ThreadPool;
+typedef void (*NDL_JobMethod) (void*, int);
+typedef struct NDL_SoftCommand NDL_SoftCommand;
+typedef struct NDL_SoftRenderer NDL_SoftRenderer;
+typedef struct NDL_RenderCommandBuffer NDL_RenderCommandBuffer;
+typedef struct NDL_RenderRecorder NDL_RenderRecorder;
+typedef struct NDL_PixelBuffer NDL_PixelBuffer;
+typedef struct NDL_PixelBufferPool NDL_PixelBufferPool;
+typedef struct NDL_StreamingTexture NDL_StreamingTexture;
+typedef struct NDL_RenderStats NDL_RenderStats;
+typedef struct NDL_RenderState NDL_RenderState;
+typedef struct NDL_Viewport NDL_Viewport;
+typedef struct NDL_TextureLOD NDL_TextureLOD;
+typedef struct NDL_Glyph NDL_Glyph;
+typedef struct NDL_Kerning NDL_Kerning;
+typedef struct NDL_LayoutGlyph NDL_LayoutGlyph;
+typedef struct NDL_TextLayout NDL_TextLayout;
+typedef struct NDL_Font NDL_Font;
+typedef struct NDL_GuiCommand NDL_GuiCommand;
+typedef struct NDL_GuiPanel NDL_GuiPanel;
+typedef struct NDL_GuiText NDL_GuiText;
+typedef struct NDL_GuiContext NDL_GuiContext;
+typedef void (*AnimEventMethod) (NDL_Entity*, NDL_AnimationComponent*, NDL_ANIMATION_EVENTS, int);
 typedef struct NDL_SpriteComponent NDL_SpriteComponent;
+typedef struct NDL_TransformComponent NDL_TransformComponent;
+typedef struct NDL_TransformSystem NDL_TransformSystem;
 typedef enum NDL_COLLISION_TYPES NDL_COLLISION_TYPES;
 typedef struct NDL_ColliderComponent NDL_ColliderComponent;
+typedef enum NDL_COLLIDER_SHAPES NDL_COLLIDER_SHAPES;
+typedef struct NDL_ShapePairs NDL_ShapePairs;
+typedef struct NDL_CollisionMask NDL_CollisionMask;
+typedef struct NDL_VerletSystem NDL_VerletSystem;
+typedef struct NDL_ParticleEmitter NDL_ParticleEmitter;
+typedef struct NDL_PhysicsStats NDL_PhysicsStats;
+typedef struct NDL_SpriteBatch NDL_SpriteBatch;
+typedef struct NDL_SpriteBatchGroup NDL_SpriteBatchGroup;
+typedef struct NDL_AtlasRegion NDL_AtlasRegion;
+typedef struct NDL_AtlasPage NDL_AtlasPage;
+typedef struct NDL_Atlas NDL_Atlas;
+typedef struct NDL_RenderQueue NDL_RenderQueue;
+typedef struct NDL_TileChunk NDL_TileChunk;
+typedef struct NDL_Tilemap NDL_Tilemap;
+typedef struct NDL_StaticEntry NDL_StaticEntry;
+typedef struct NDL_StaticPlane NDL_StaticPlane;
+typedef struct NDL_StaticLayer NDL_StaticLayer;
+typedef struct NDL_PrimitiveGroup NDL_PrimitiveGroup;
+typedef struct NDL_PrimitiveBatch NDL_PrimitiveBatch;
 typedef struct NDL_Pool NDL_Pool;
 typedef enum NDL_PlayerActions NDL_PlayerActions;
 typedef struct Cell Cell;
+typedef struct NDL_CellBody NDL_CellBody;
 typedef void (*ForceMethod) (NDL_Entity*, NDL_PhysicsSystem*);
 typedef void (*PosMethod) (NDL_PhysicsSystem*, NDL_Entity*, float, int);
 typedef bool (*ColMethod) (NDL_PhysicsGrid*);
@@ -197,7 +254,8 @@ enum Components
     NO_COMPONENT = 0,
     SPRITE_COMPONENT = 1<<0,    //0001
     COLLIDER_COMPONENT = 1<<1,  //0010
-    ANIMATION_COMPONENT = 1<<2  //0100
+    ANIMATION_COMPONENT = 1<<2, //0100
+    TRANSFORM_COMPONENT = 1<<3  //1000
 };
 
 struct NDL_SpriteComponent
@@ -207,6 +265,61 @@ struct NDL_SpriteComponent
     NDL_Texture* image;
     Vector2 imageOffset;
     NDL_AnimationComponent* animation;
+    Rect srcRect;       // Region of image to draw; w == 0 draws the whole texture
+    SDL_FRect uv;       // srcRect normalised to the texture size, used by the sprite batch
+    Uint8 layer;        // Higher layers draw on top
+    Vector2F position;  // Float world position of imageRect's origin, used for sub-pixel drawing
+    Vector2F previousPosition;  // position as of the previous physics tick; drawn blended towards position
+    bool interpolated;  // position is kept by physics or a transform; otherwise imageRect is drawn as placed
+    bool isStatic;      // Drawn into the render system's cached static layer when it is enabled
+    Uint32 visibleFrame;    // Render system frame this sprite was last drawn in
+    Uint8 viewMask;     // Split-screen only: bit v set when viewport v saw the sprite in visibleFrame
+    float angle;        // Degrees clockwise about the centre
+    Vector2F scale;     // Applied to imageRect's size, growing from its origin
+};
+
+/*
+ * Struct: NDL_TransformComponent
+ * ------------------------------
+ * Local position, rotation and scale relative to a parent. Rotation and scale act about the
+ * centres of the entities' sprites. A root (no parent) takes its position from its entity, so
+ * physics can move whole hierarchies. Children write their world position back to the entity
+ * and their sprite.
+ */
+struct NDL_TransformComponent
+{
+    NDL_Entity* entity;
+    NDL_TransformComponent* parent;
+    Vector2F localPosition;     // Offset of the origin from the parent's origin, in parent units
+    float localRotation;        // Degrees
+    Vector2F localScale;
+    Vector2F worldPosition;
+    Vector2F worldCentre;
+    float worldRotation;
+    Vector2F worldScale;
+    Vector2F lag;               // Root sprite's previousPosition - position, so children interpolate with it
+    int depth;                  // 0 for roots
+    bool dirty;                 // Local values changed since the last update
+    bool changed;               // World values were recomputed by the last pass that ran
+    NDL_TransformSystem* system;
+};
+
+/*
+ * Struct: NDL_TransformSystem
+ * ---------------------------
+ * Transforms kept in depth order, so every parent is updated before its children. An update
+ * with nothing dirty only checks whether the roots moved, so hierarchies at rest cost almost
+ * nothing.
+ */
+struct NDL_TransformSystem
+{
+    int count;
+    int capacity;
+    NDL_TransformComponent** order;     // Sorted by depth
+    int rootCount;                      // order[0, rootCount) are the roots
+    bool orderDirty;                    // A transform was added, removed or reparented
+    int dirtyCount;
+    int updated;                        // Transforms recomputed by the last update
 };
 
 enum NDL_COLLISION_TYPES
@@ -218,6 +331,13 @@ enum NDL_COLLISION_TYPES
     None
 };
 
+enum NDL_COLLIDER_SHAPES
+{
+    BOX_COLLIDER,
+    CIRCLE_COLLIDER,
+    CAPSULE_COLLIDER    // Segment along the long axis of r, swept by radius
+};
+
 struct NDL_ColliderComponent
 {
     const char* tag;
@@ -226,18 +346,60 @@ struct NDL_ColliderComponent
     float mass;
     Vector2F position;
     Vector2F velocity;
-    NDL_Rect r;
+    NDL_Rect r;     // Bounding box for every shape, used by the grid and AABB path
+    NDL_COLLIDER_SHAPES shape;
+    float radius;
+    NDL_CollisionMask* mask;   // Optional pixel mask, tested after the bounding boxes overlap
+};
+
+/*
+ * Struct: NDL_CollisionMask
+ * -------------------------
+ * One bit per pixel, set where the source image alpha passes the threshold.
+ *
+ * Rows are packed least-significant-bit first into 64-bit words. Every row carries one
+ * extra zero word of padding so shifted reads past the last pixel never leave the row.
+ */
+struct NDL_CollisionMask
+{
+    int w, h;
+    int stride;     // Words per row, padding included
+    Uint64* bits;
+};
+
+/*
+ * Struct: NDL_ShapePairs
+ * ----------------------
+ * Structure-of-arrays batch of candidate pairs for one narrowphase test.
+ *
+ * Shape A is described by (ax, ay, ax2, ay2, ar) and shape B by (bx, by, bx2, by2, br).
+ * Circles use (x, y, r) as their centre and radius, capsules use (x, y)-(x2, y2) as their
+ * segment plus r, and boxes use (x, y)-(x2, y2) as their min/max corners.
+ * The batch kernels write the contact normal (pointing from B to A) and the penetration
+ * depth; depth is <= 0 for pairs that do not touch.
+ */
+struct NDL_ShapePairs
+{
+    int count;
+    int capacity;
+    NDL_Entity** a;
+    NDL_Entity** b;
+    float* ax; float* ay; float* ax2; float* ay2; float* ar;
+    float* bx; float* by; float* bx2; float* by2; float* br;
+    float* nx; float* ny; float* depth;
 };
 
 struct NDL_Entity
 {
     const char* tag;
     bool isDynamic;
+    bool isSleeping;    // Skipped by the physics step until woken
     Vector2F position;
     Vector2F velocity;
     unsigned int componentFlags;
     NDL_SpriteComponent* sprite;
     NDL_ColliderComponent* collider;
+    NDL_TransformComponent* transform;
 };
 
 struct NDL_Pool
@@ -252,6 +414,410 @@ struct NDL_Camera
     Vector2F position;
     float cameraSpeed;
     float scrollInterpolation;
+    float zoom;         // Screen pixels per world unit; position stays the view's top-left corner
+};
+
+#define NDL_MAX_TEXTURE_LODS 4
+
+/*
+ * Struct: NDL_TextureLOD
+ * ----------------------
+ * Pre-filtered half, quarter and eighth size copies of a texture, attached to it as SDL texture
+ * user data. Sprites that are drawn small pick the closest level instead of minifying the full
+ * image every frame. UVs stay normalised, so a sub-rect maps to the same area on every level.
+ *
+ * Level k averages 2^k x 2^k blocks, which would blend atlas regions packed a pixel apart into
+ * each other, so atlas pages carry a single-level entry with atlasPage set and refuse levels.
+ */
+struct NDL_TextureLOD
+{
+    NDL_Texture* levels[NDL_MAX_TEXTURE_LODS];  // levels[0] is the full-size texture
+    int levelCount;
+    bool atlasPage;     // Owned by an NDL_Atlas page; never gets smaller levels
+};
+
+struct NDL_SpriteBatchGroup
+{
+    NDL_Texture* texture;   // NULL for colour-only quads
+    int quadCount;
+    int quadCapacity;
+    SDL_Vertex* vertices;
+};
+
+/*
+ * Struct: NDL_SpriteBatch
+ * -----------------------
+ * Accumulates quads per texture and draws each texture's quads with one SDL_RenderGeometry call.
+ *
+ * By default the batch flushes whenever the texture changes, so quads are painted in the order
+ * they were submitted. A grouped batch instead keeps one group per texture and flushes them in
+ * first-use order, which keeps order within a texture but not between textures; it is only
+ * correct for quads that do not overlap, such as a tile grid. Groups and their vertex storage
+ * are reused from frame to frame.
+ */
+struct NDL_SpriteBatch
+{
+    Renderer sdlRenderer;
+    int groupCount;
+    int groupCapacity;
+    NDL_SpriteBatchGroup* groups;
+    int activeCount;
+    int* active;        // Indices of the groups used since the last flush, in first-use order
+    int lastGroup;
+    int indexCapacity;  // In quads
+    int* indices;       // Shared 0,1,2, 2,3,0 quad pattern
+    int drawCalls;      // Since the last NDL_ResetSpriteBatchStats
+    int quadCapacityHint;
+    bool ordered;       // Flush on every texture change, keeping submission order; false groups by texture
+    NDL_SoftRenderer* soft;     // When set, quads are queued on the CPU rasterizer instead
+};
+
+#define NDL_RENDER_KEY_LAYER_SHIFT 56
+#define NDL_RENDER_KEY_Y_SHIFT 36
+#define NDL_RENDER_KEY_TEXTURE_SHIFT 20
+#define NDL_RENDER_KEY_SEQUENCE_MASK 0xFFFFFull
+
+/*
+ * Struct: NDL_RenderQueue
+ * -----------------------
+ * Sprites to draw this frame, ordered by a 64-bit key:
+ *
+ *   layer (8) | y (20) | texture id (16) | submission index (20)
+ *
+ * The texture is the LOD level the sprite will be drawn with at zoom, so minified sprites sharing
+ * a level batch together.
+ * The submission index doubles as the handle back into `entities`, so only the keys are sorted.
+ * When the same entities are submitted as last frame the previous order is re-keyed and fixed up
+ * with an insertion sort; otherwise the keys are radix sorted.
+ */
+struct NDL_RenderQueue
+{
+    int count;
+    int capacity;
+    NDL_Entity** entities;      // In submission order
+    Uint64* keys;               // Sorted order after NDL_SortRenderQueue
+    Uint64* scratch;
+    int lastCount;
+    NDL_Entity** lastEntities;  // Last frame's submissions, to detect an unchanged set
+    bool ySort;                 // Include the sprite's bottom edge in the key
+    float zoom;                 // Picks each sprite's LOD level for the key; 0 keys the full-size image
+    int textureIdCapacity;      // Open-addressed texture -> id table, power of two
+    int textureIdCount;
+    NDL_Texture** textureIdKeys;
+    Uint16* textureIds;
+    int incrementalSorts;
+    int radixSorts;
+};
+
+struct NDL_RenderCommandBuffer
+{
+    int count;
+    NDL_Entity** entities;      // Visible entities found by this job, in candidate order
+    int missCount;
+    int* misses;                // Queue positions whose texture has no id yet, keyed on the main thread
+};
+
+/*
+ * Struct: NDL_RenderRecorder
+ * --------------------------
+ * Builds the frame's draw list on worker threads. Culling, sort keys and vertices are each split
+ * into jobs of jobSize entities over disjoint ranges, and each job writes only to its own command
+ * buffer or its own slice of vertices. Buffers are merged in job order on the main thread, so the
+ * result matches the serial path, and every SDL call stays on the main thread.
+ */
+struct NDL_RenderRecorder
+{
+    NDL_ThreadPool* pool;       // Borrowed from the caller; NULL records on the calling thread
+    int jobSize;
+    int bufferCount;
+    NDL_RenderCommandBuffer* buffers;   // One per job; each holds up to jobSize entries
+    int vertexCapacity;         // In quads
+    SDL_Vertex* vertices;       // Four per queued sprite, in sorted order
+    // Inputs of the current pass, read by the jobs
+    NDL_RenderSystem* renSys;
+    NDL_Entity** candidates;
+    int candidateCount;
+    SDL_FRect view;
+    Vector2F camera;
+    float zoom;
+};
+
+struct NDL_TileChunk
+{
+    Uint16* tiles;          // chunkTiles*chunkTiles tile ids, row-major; 0 is empty
+    int tileCount;          // Non-empty tiles, empty chunks are never baked or drawn
+    NDL_Texture* texture;   // Baked chunk, NULL when not resident
+    bool dirty;             // Tiles changed since the last bake
+    Uint32 lastUsedFrame;
+};
+
+/*
+ * Struct: NDL_Tilemap
+ * -------------------
+ * A tile grid split into square chunks. Each visible chunk is baked once into a render target
+ * texture and drawn with a single copy; a chunk is re-baked only when one of its tiles changes.
+ *
+ * At most maxResidentChunks baked textures are kept. When a chunk needs baking and the budget is
+ * spent, the least recently drawn chunk that is not on screen gives up its texture.
+ *
+ * Tile id n (n > 0) is the (n-1)th tileW x tileH cell of the tileset, read left to right and top
+ * to bottom.
+ */
+struct NDL_Tilemap
+{
+    Renderer sdlRenderer;
+    NDL_Texture* tileset;
+    int tilesetColumns;
+    int tileW, tileH;
+    int widthTiles, heightTiles;
+    int chunkTiles;
+    int chunksX, chunksY;
+    NDL_TileChunk* chunks;
+    Uint16* tileData;       // Storage for every chunk's tiles, chunk after chunk
+    int residentChunks;
+    int maxResidentChunks;
+    Uint32 frame;
+    int chunksDrawn;        // Last NDL_RenderTilemap
+    int chunksBaked;        // Last NDL_RenderTilemap
+};
+
+/*
+ * Struct: NDL_ThreadPool
+ * ----------------------
+ * A fixed set of SDL worker threads for parallel-for style work. NDL_RunParallel hands out job
+ * indices through an atomic counter; the calling thread takes jobs too and returns once all are done.
+ */
+struct NDL_ThreadPool
+{
+    int threadCount;
+    SDL_Thread** threads;
+    SDL_sem* start;
+    SDL_sem* done;
+    SDL_atomic_t next;
+    SDL_atomic_t quit;
+    int jobCount;
+    NDL_JobMethod job;
+    void* userData;
+};
+
+struct NDL_SoftCommand
+{
+    NDL_Surface* texture;   // ARGB8888 copy, NULL for a colour fill
+    SDL_FRect dst;
+    SDL_FRect src;          // In texels
+    NDL_Color color;
+};
+
+/*
+ * Struct: NDL_SoftRenderer
+ * ------------------------
+ * CPU render backend drawing into an ARGB8888 surface, for machines without a GPU.
+ *
+ * Quads are recorded during NDL_Render and rasterized by NDL_SoftFlush in horizontal bands, one
+ * band per job on the thread pool, so every pixel is still written in submission order. Spans
+ * are drawn by SSE2 or AVX2 kernels when the CPU has them, with scalar kernels producing the same
+ * bits otherwise. Blending follows SDL_BLENDMODE_BLEND and colour modulation follows SDL's vertex
+ * colours, with exact /255 rounding.
+ *
+ * SDL textures cannot be read back, so each texture drawn must first be registered with the
+ * pixels it was made from (NDL_RegisterSoftTexture or NDL_LoadSoftTexture).
+ */
+struct NDL_SoftRenderer
+{
+    NDL_Surface* target;
+    NDL_ThreadPool* pool;       // Borrowed from the caller; NULL rasterizes on the calling thread
+    int bandHeight;
+    bool bilinear;
+    int simdLevel;          // 0 scalar, 1 SSE2, 2 AVX2
+    NDL_Color clearColor;
+    bool clearPending;
+    int commandCount, commandCapacity;
+    NDL_SoftCommand* commands;
+    int textureCount, textureCapacity;  // Open-addressed NDL_Texture* -> surface table
+    NDL_Texture** textureKeys;
+    NDL_Surface** textureSurfaces;
+    int missingTextures;    // Quads dropped since creation because their texture was not registered
+};
+
+struct NDL_PrimitiveGroup
+{
+    NDL_Color color;
+    int outlineCount, outlineCapacity;
+    SDL_FRect* outlines;
+    int fillCount, fillCapacity;
+    SDL_FRect* fills;
+};
+
+struct NDL_RenderStats
+{
+    int drawCalls;          // Clears, copies, fills, lines and geometry submitted to SDL
+    int stateChanges;       // Draw colour, blend mode and target changes passed on to SDL
+    int redundantStates;    // State changes skipped because the value was already set
+    int textureSwitches;    // Draws using a different texture (or none) than the draw before
+    int vertices;           // Vertices submitted; a rect counts as four, a line as two
+};
+
+/*
+ * Struct: NDL_RenderState
+ * -----------------------
+ * What NDL_G last set on an SDL renderer, so repeated state calls can be skipped. Values are only
+ * trusted while valid; code that changes renderer state through SDL directly must call
+ * NDL_InvalidateRenderState. Counters gather in frame and move to last on NDL_SendFrame.
+ */
+struct NDL_RenderState
+{
+    Renderer renderer;
+    bool colorValid;
+    NDL_Color color;
+    bool blendValid;
+    SDL_BlendMode blend;
+    bool targetValid;
+    NDL_Texture* target;
+    bool textureValid;
+    NDL_Texture* texture;   // Texture of the last draw, NULL for untextured draws
+    NDL_RenderStats frame;
+    NDL_RenderStats last;
+};
+
+struct NDL_PixelBuffer
+{
+    Uint32* pixels;     // ARGB8888, pitch of w*4 bytes
+    int w, h;
+    int capacity;       // In pixels; a buffer is reused for any size that fits
+    NDL_PixelBuffer* next;
+};
+
+// Recycles CPU-side images so procedural content does not allocate every frame
+struct NDL_PixelBufferPool
+{
+    NDL_PixelBuffer* free;  // Released buffers, most recent first
+    int allocated;          // Buffers created over the pool's lifetime
+    int reused;             // Acquires served from the free list
+};
+
+#define NDL_STREAM_MAX_DIRTY 8
+
+/*
+ * Struct: NDL_StreamingTexture
+ * ----------------------------
+ * A texture rewritten from the CPU, backed by SDL_TEXTUREACCESS_STREAMING textures. Writes go to
+ * the shadow image and mark their rect dirty on every buffer. NDL_UnlockStreamingTexture uploads
+ * only the back buffer's dirty rects, then swaps it to the front. With two buffers, the texture
+ * the GPU may still be reading is never locked. A buffer with more rects than
+ * NDL_STREAM_MAX_DIRTY merges them into their bounding box.
+ */
+struct NDL_StreamingTexture
+{
+    Renderer sdlRenderer;
+    int w, h;
+    int bufferCount;            // 1 or 2
+    NDL_Texture* textures[2];
+    int front;                  // Index of the texture to draw
+    Uint32* shadow;             // Full ARGB8888 image, w*4 bytes per row
+    int dirtyCount[2];
+    SDL_Rect dirty[2][NDL_STREAM_MAX_DIRTY];  // Rects each buffer is missing
+    int uploadedPixels;         // By the last unlock, for profiling
+};
+
+/*
+ * Struct: NDL_PrimitiveBatch
+ * --------------------------
+ * Collects debug and UI primitives for the frame and draws them with as few calls as possible:
+ *
+ *   filled circles and triangles: one SDL_RenderGeometry call for all colours (colour per vertex)
+ *   filled rects: one SDL_RenderFillRectsF per colour
+ *   rect outlines: one SDL_RenderDrawRectsF per colour
+ *   lines, circle and capsule outlines: one-pixel-wide quads in a second SDL_RenderGeometry call
+ *   for all colours, drawn last
+ */
+struct NDL_PrimitiveBatch
+{
+    Renderer sdlRenderer;
+    int groupCount, groupCapacity;
+    NDL_PrimitiveGroup* groups;
+    int lastGroup;
+    int vertexCount, vertexCapacity;
+    SDL_Vertex* vertices;
+    int indexCount, indexCapacity;
+    int* indices;
+    int lineVertexCount, lineVertexCapacity;
+    SDL_Vertex* lineVertices;   // Four per line segment
+    int lineIndexCount, lineIndexCapacity;
+    int* lineIndices;
+    int drawCalls;              // Issued by the last NDL_FlushPrimitiveBatch
+    NDL_SoftRenderer* soft;     // When set, rects are rasterized on the CPU; lines and circles are dropped
+};
+
+struct NDL_StaticEntry
+{
+    NDL_Entity* entity;
+    SDL_FRect dst;          // Plane space: screen space at the baked camera, shifted by the margin
+    NDL_Texture* image;
+    SDL_FRect uv;
+    NDL_Color color;
+    Uint8 layer;
+};
+
+#define NDL_STATIC_LAYER_PLANES 8     // Sprite layers with static content; static sprites on more layers draw dynamically
+#define NDL_STATIC_LAYER_MARGIN 128   // Pixels baked beyond each screen edge, so small scrolls only shift the composite
+
+// The baked static sprites of one sprite layer
+struct NDL_StaticPlane
+{
+    Uint8 layer;
+    NDL_Texture* target;
+    bool valid;
+    int count;              // Static sprites on this layer this frame
+    int dirtyCount, dirtyCapacity;
+    SDL_Rect* dirty;
+};
+
+/*
+ * Struct: NDL_StaticLayer
+ * -----------------------
+ * Persistent targets holding the visible static sprites, one plane per sprite layer. Each plane
+ * is composited between the dynamic sprites at its layer's place in the draw order, so static
+ * and dynamic sprites keep the layering NDL_SortRenderQueue gives them.
+ *
+ * Planes are baked NDL_STATIC_LAYER_MARGIN pixels past every screen edge. While the camera stays
+ * within that margin of where the planes were baked, they are only drawn offset by the camera
+ * delta; scrolling further, zooming or resizing rebakes them.
+ *
+ * Each frame the static sprites are diffed against last frame's by entity pointer; a sprite that
+ * moved, changed image, colour or layer, appeared or disappeared marks its old and new rects
+ * dirty on the planes involved, and only those rects are cleared and redrawn. The planes hold
+ * premultiplied colour, so they are composited with a premultiplied blend mode.
+ */
+struct NDL_StaticLayer
+{
+    int w, h;               // Plane size: the view plus the margin on each side
+    Vector2F camera;        // Camera position the planes were baked at
+    float zoom;             // Camera zoom the planes were baked at
+    bool valid;
+    SDL_BlendMode compositeMode;
+    NDL_StaticPlane planes[NDL_STATIC_LAYER_PLANES];  // Sorted by layer
+    int planeCount;
+    NDL_RenderQueue* queue; // Static sprites in draw order
+    int count, capacity;
+    NDL_StaticEntry* entries;   // Sorted by entity pointer
+    int previousCount, previousCapacity;
+    NDL_StaticEntry* previous;
+    int spritesRedrawn;     // Last frame
+    int dirtyRects;         // Last frame, over all planes
+};
+
+#define NDL_MAX_VIEWPORTS 4
+
+/*
+ * Struct: NDL_Viewport
+ * --------------------
+ * One split-screen view: the part of the output it draws to and the camera it looks through.
+ */
+struct NDL_Viewport
+{
+    SDL_Rect rect;          // Output pixels
+    NDL_Camera* camera;     // NULL looks at the world origin
+    int drawn;              // Sprites that fell inside this view in the last NDL_Render
 };
 
 struct NDL_RenderSystem
@@ -262,11 +828,72 @@ struct NDL_RenderSystem
     NDL_Pool* pool;
     NDL_Color clearColor;
     RenderMethod render;
+    bool useBatching;
+    NDL_SpriteBatch* batch;
+    NDL_RenderQueue* queue;
+    NDL_Camera* camera;         // NULL draws in world space
+    NDL_PhysicsGrid* cullGrid;  // When set, visible entities come from this grid instead of the pool
+    int visibleCapacity;
+    NDL_Entity** visible;
+    int visibleCount;           // Sprites that passed culling in the last NDL_Render
+    int viewCandidateCapacity;
+    NDL_Entity** viewCandidates;    // Scratch for the per-viewport grid queries
+    NDL_Tilemap* tilemap;       // Drawn under the sprites, NULL for none
+    NDL_StaticLayer* staticLayer;   // NULL draws static sprites like any other
+    NDL_PrimitiveBatch* primitives; // Collider outlines and other debug shapes, flushed after the sprites
+    Uint32 frame;               // Incremented by every NDL_Render
+    int drawCalls;      // Draw calls issued by the last NDL_Render
+    NDL_SoftRenderer* soft;     // NULL renders through SDL
+    NDL_RenderRecorder* recorder;   // NULL records the draw list on the calling thread
+    float interpolationAlpha;   // Blend from previousPosition (0) to position (1), set by NDL_StepPhysicsFixed
+    NDL_Viewport viewports[NDL_MAX_VIEWPORTS];
+    int viewportCount;          // 0 draws one full-output view through camera
+    int activeViewport;         // -1 outside NDL_BeginRenderViewport
+    NDL_Camera* mainCamera;     // camera to restore at NDL_EndRenderViewport
+    NDL_FrameScheduler* scheduler;  // Kept rendering while visible sprites animate, NULL for none
+};
+
+// Broadphase copy of one entity's collider bounds, gathered contiguously per cell each pass
+struct NDL_CellBody
+{
+    float minX, minY, maxX, maxY;
+    bool box;
+    bool masked;
 };
 
 struct Cell
 {
     NDL_Pool* pool;
+    NDL_CellBody* bodies;   // Parallel to pool->entities, sized to the pool's capacity
+};
+
+/*
+ * Struct: NDL_PhysicsStats
+ * ------------------------
+ * Work counters and stage timings for the most recent NDL_UpdateSystem step.
+ *
+ * Pair and contact counts are summed over every sub-step, since the narrowphase runs once
+ * per sub-step. Occupancy figures are sampled once at the start of the step, and the average
+ * only counts cells holding at least one entity. Timings are in milliseconds. The forces,
+ * integrate and collision timings are only measured while stage profiling is enabled, since
+ * they are taken around every entity and every narrowphase pass.
+ */
+struct NDL_PhysicsStats
+{
+    int bodiesIntegrated;
+    int sleepingBodies;
+    int broadphasePairs;
+    int narrowphaseTests;
+    int contactsResolved;
+    int maskOverlaps;       // Pixel-mask sensor hits, reported but not resolved
+    int occupiedCells;
+    int maxCellOccupancy;
+    float avgCellOccupancy;
+    double reorderMs;
+    double forcesMs;
+    double integrateMs;
+    double collisionMs;
+    double totalMs;
 };
 
 struct NDL_PhysicsGrid
@@ -275,6 +902,15 @@ struct NDL_PhysicsGrid
     int r,c;
     int cellSize;
     Cell** cells;
+    NDL_ShapePairs* circleCircle;
+    NDL_ShapePairs* circleBox;
+    NDL_ShapePairs* circleCapsule;
+    NDL_ShapePairs* capsuleBox;
+    NDL_ShapePairs* capsuleCapsule;
+    NDL_PhysicsStats* stats;    // Filled by the narrowphase when the grid belongs to a physics system
+    bool profileStages;         // Also time each narrowphase pass into stats->collisionMs
+    float maxExtent;            // Largest sprite or collider diagonal binned, pads NDL_QueryGridRect
+    bool binsStale;             // Entities moved since the last NDL_RebinPhysicsGrid
 };
 
 struct NDL_PhysicsSystem
@@ -288,6 +924,99 @@ struct NDL_PhysicsSystem
     ForceMethod handleForces;
     PosMethod handlePositions;
     ColMethod handleCollisions;
+    int reorderInterval;        // Frames between Morton reorders of the grid, 0 disables it
+    int framesSinceReorder;
+    NDL_PhysicsStats stats;
+    bool profileStages;         // Time forces, integration and collision; off by default
+    float fixedStep;            // Seconds per tick run by NDL_StepPhysicsFixed
+    float accumulator;          // Frame time not yet simulated
+    int maxStepsPerFrame;       // Ticks per frame before the backlog is dropped, to avoid a spiral of death
+};
+
+/*
+ * Struct: NDL_VerletSystem
+ * ------------------------
+ * Point masses and distance constraints for ropes, chains and cloth.
+ *
+ * Points live in structure-of-arrays form (x, y, previous x/y and inverse mass, 0 for
+ * pinned points). Constraints are grouped into colours whose members share no point,
+ * so each colour can be relaxed four constraints at a time without write conflicts.
+ * Strips list the point indices drawn as one connected line each.
+ */
+struct NDL_VerletSystem
+{
+    int pointCount;
+    int maxPoints;
+    float* x;
+    float* y;
+    float* px;
+    float* py;
+    float* invMass;
+
+    int constraintCount;
+    int maxConstraints;
+    int* ca;
+    int* cb;
+    float* restLength;
+    int colorCount;
+    int* colorStart;
+    bool constraintsDirty;
+
+    int stripCount;
+    int* stripStart;
+    int* stripLength;
+    int stripIndexCount;
+    int* stripIndices;
+    SDL_FPoint* stripPoints;
+
+    Vector2F gravity;
+    float damping;
+    int iterations;
+    NDL_PhysicsGrid* collisionGrid;
+    NDL_Color color;
+};
+
+/*
+ * Struct: NDL_ParticleEmitter
+ * ---------------------------
+ * Particles that are not entities, stored as structure-of-arrays lanes padded to a multiple of 4
+ * so the update runs four particles per SSE2 step. age runs from 0 to 1 over a particle's
+ * lifetime and drives the colour blend from startColor to endColor. Dead particles are removed by
+ * moving the last one into their slot, so particle order is not stable. Colours are packed as
+ * SDL_Color bytes, ready to copy into vertices.
+ */
+struct NDL_ParticleEmitter
+{
+    int count;
+    int capacity;
+    float* x;
+    float* y;
+    float* vx;
+    float* vy;
+    float* age;
+    float* ageRate;     // 1 / lifetime
+    float* size;
+    Uint32* color;
+
+    Vector2F position;  // Where new particles spawn
+    float rate;         // Particles spawned per second by NDL_UpdateParticleEmitter
+    float spawnDebt;    // Fractional particles carried over to the next update
+    float angle;        // Launch direction in radians, 0 is +x
+    float spread;       // Launch angles fall within angle +- spread/2
+    float speedMin, speedMax;
+    float lifeMin, lifeMax;
+    float sizeMin, sizeMax;
+    NDL_Color startColor;
+    NDL_Color endColor;
+    Vector2F gravity;
+    float drag;         // Fraction of velocity lost per second
+    Uint32 seed;
+
+    NDL_Texture* texture;   // NULL draws untextured squares
+    SDL_FRect uv;
+    int vertexCapacity;     // In particles
+    SDL_Vertex* vertices;
+    int* indices;
 };
 
 struct NDL_CollisionData
@@ -314,6 +1043,28 @@ struct NDL_Clock
     Uint32 currentTime;
 };
 
+#define NDL_SCHEDULER_TIMERS 8
+
+/*
+ * Struct: NDL_FrameScheduler
+ * --------------------------
+ * Decides when an idle-mode loop may skip rendering. In continuous mode every frame renders as
+ * before. In idle mode the first event read of a frame blocks until input arrives or the next
+ * timer or animation frame is due, and a frame renders only if something asked for it.
+ */
+struct NDL_FrameScheduler
+{
+    bool idle;              // Block between frames instead of polling
+    bool dirty;             // Input arrived or NDL_RequestRedraw was called
+    bool waited;            // This frame's blocking wait has already happened
+    Uint32 animateUntil;    // Render continuously until this tick
+    Uint32 timers[NDL_SCHEDULER_TIMERS];    // Ticks scheduled redraws are due, earliest first
+    int timerCount;
+    Uint32 idleTime;        // Milliseconds spent blocked before the current frame
+    int renderedFrames;
+    int skippedFrames;
+};
+
 /*
  * Enum: PlayerActions
  * --------------------
@@ -373,6 +1124,205 @@ struct NDL_ImageSet
 {
     int imageCount;
     NDL_Texture** images;
+    NDL_AtlasRegion* regions;   // Per-frame atlas regions, NULL when every frame is its own texture
+};
+
+struct NDL_AtlasRegion
+{
+    NDL_Texture* texture;   // The atlas page holding the image
+    Rect src;
+    SDL_FRect uv;
+};
+
+struct NDL_AtlasPage
+{
+    NDL_Texture* texture;
+    int nodeCount;
+    SDL_Point* skyline;     // Left edge and height of each skyline segment, sorted by x
+    int* skylineWidth;
+};
+
+/*
+ * Struct: NDL_Atlas
+ * -----------------
+ * Packs images into shared RGBA32 pages with a bottom-left skyline packer.
+ *
+ * Each packed image is surrounded by `padding` transparent pixels on its right and bottom so
+ * neighbours never bleed into each other. A new page is opened when an image does not fit any
+ * existing page.
+ */
+struct NDL_Atlas
+{
+    Renderer sdlRenderer;
+    int pageWidth;
+    int pageHeight;
+    int padding;
+    int pageCount;
+    int pageCapacity;
+    NDL_AtlasPage* pages;
+};
+
+#define NDL_FONT_GLYPHS 256          // Strings are bytes, so fonts cover ASCII/Latin-1
+#define NDL_FONT_MAX_PAGES 16
+#define NDL_TEXT_CACHE_SETS 32      // Power of two
+#define NDL_TEXT_CACHE_WAYS 4
+
+struct NDL_Glyph
+{
+    NDL_AtlasRegion region;     // region.texture is NULL for blank glyphs such as space
+    float w, h;
+    float xOffset, yOffset;     // From the pen position to the glyph's top-left
+    float xAdvance;
+    bool defined;
+};
+
+struct NDL_Kerning
+{
+    Uint16 pair;        // first << 8 | second
+    Sint16 amount;
+};
+
+struct NDL_LayoutGlyph
+{
+    const NDL_Glyph* glyph;
+    float x, y;         // Relative to the top-left of the text
+};
+
+struct NDL_TextLayout
+{
+    Uint32 hash;        // FNV-1a of text
+    int length;
+    char* text;         // Copy of the string, to rule out hash collisions
+    int textCapacity;
+    int glyphCount;
+    int glyphCapacity;
+    NDL_LayoutGlyph* glyphs;
+    Vector2F size;
+    Uint32 lastUsed;
+};
+
+/*
+ * Struct: NDL_Font
+ * ----------------
+ * A BMFont (text .fnt) font whose glyphs were packed into an NDL_Atlas, so text shares pages and
+ * draw calls with sprites. Laid-out strings are kept in a small set-associative cache keyed by
+ * their content hash, so HUD text that did not change since the last frame is only hashed.
+ */
+struct NDL_Font
+{
+    float lineHeight;
+    float base;         // Baseline, from the top of a line
+    NDL_Glyph glyphs[NDL_FONT_GLYPHS];
+    int kerningCount;
+    NDL_Kerning* kernings;  // Sorted by pair
+    NDL_TextLayout cache[NDL_TEXT_CACHE_SETS*NDL_TEXT_CACHE_WAYS];
+    Uint32 useCounter;
+    int layoutHits;
+    int layoutMisses;
+};
+
+#define NDL_GUI_MAX_PANELS 64
+#define NDL_GUI_TEXT_INPUT 64
+
+// A run of quads sharing one texture inside one panel, drawn with a single SDL_RenderGeometry
+struct NDL_GuiCommand
+{
+    NDL_Texture* texture;
+    int firstQuad;
+    int quadCount;
+};
+
+// Panel state kept between frames, so position, scroll and stacking survive immediate mode
+struct NDL_GuiPanel
+{
+    Uint32 id;
+    SDL_FRect rect;
+    float contentHeight;    // Measured at the previous NDL_GuiEndPanel, bounds the scroll
+    float scroll;
+    int order;              // Higher is drawn later, on top
+    Uint32 lastFrame;       // GUI frame the panel was last begun in
+    int firstCommand;
+    int commandCount;
+};
+
+// A widget's text layout, kept across frames and only redone when the widget's text changes
+struct NDL_GuiText
+{
+    Uint32 key;             // Widget id, or panel and row for labels; 0 marks an empty slot
+    Uint32 lastFrame;       // GUI frame the text was last drawn in
+    NDL_TextLayout layout;
+};
+
+/*
+ * Struct: NDL_GuiContext
+ * ----------------------
+ * Immediate-mode GUI state. Widgets are called every frame between NDL_GuiBeginFrame and
+ * NDL_GuiRender and record quads into one vertex list. Fills sample a white texel packed into
+ * the font's atlas, so a panel's backgrounds and text usually form a single command and the
+ * whole GUI costs about one draw call per visible panel.
+ *
+ * Text layouts live in the context's own table, one per widget, rather than in the font's fixed
+ * cache, so a GUI with more labels than that cache holds still lays out only changed strings.
+ */
+struct NDL_GuiContext
+{
+    Renderer sdlRenderer;
+    NDL_Font* font;
+    SDL_FRect whiteUV;
+    NDL_Texture* whiteTexture;
+    NDL_Color panelColor, titleColor, widgetColor, hotColor, activeColor, textColor;
+    float padding, spacing, rowHeight;
+
+    Vector2F mouse;
+    bool mouseDown, mousePressed, mouseReleased;
+    float wheel;
+    char textInput[NDL_GUI_TEXT_INPUT];
+    int textLength;
+    int backspaces;
+    bool enterPressed;
+
+    Uint32 hot;             // Widget under the mouse this frame
+    Uint32 active;          // Widget being pressed or dragged
+    Uint32 focused;         // Text field receiving typed text
+    Vector2F dragOffset;
+    Uint32 frame;
+
+    NDL_GuiPanel panels[NDL_GUI_MAX_PANELS];
+    int panelCount;
+    NDL_GuiPanel* current;
+    const char* title;      // Current panel's title, drawn at NDL_GuiEndPanel
+    Uint32 hoveredPanel;    // Topmost panel under the mouse, from last frame's rects
+    int topOrder;
+    SDL_FRect content;      // Current panel's area below the title bar
+    float cursorY;
+    int row;                // Rows claimed in the current panel, keys label text
+
+    int textCount;
+    int textCapacity;       // Power of two, open addressing
+    NDL_GuiText* texts;
+
+    int quadCount;
+    int quadCapacity;
+    SDL_Vertex* vertices;
+    int* indices;
+    int commandCount;
+    int commandCapacity;
+    NDL_GuiCommand* commands;
+    int drawCalls;          // Issued by the last NDL_GuiRender
+};
+
+enum NDL_ANIMATION_MODES
+{
+    ANIMATION_ONCE,
+    ANIMATION_LOOP,
+    ANIMATION_PINGPONG
+};
+
+enum NDL_ANIMATION_EVENTS
+{
+    ANIMATION_EVENT_FRAME,      // Entered a frame whose bit is set in eventFrames
+    ANIMATION_EVENT_LOOP,       // Wrapped back to the first frame, or turned around in ping-pong
+    ANIMATION_EVENT_FINISHED    // A one-shot animation reached its last frame
 };
 
 struct NDL_AnimationComponent
@@ -382,6 +1332,61 @@ struct NDL_AnimationComponent
     int currentFrame;
     int flipRate;
     AnimFlipMethod flip;
+    float time;                 // Seconds accumulated towards the next frame
+    float rate;                 // Frames per second
+    NDL_ANIMATION_MODES mode;
+    int direction;              // +1 or -1, ping-pong only
+    bool finished;
+    Uint64 eventFrames;         // Bit n set: onEvent fires when frame n is entered
+    AnimEventMethod onEvent;
+    NDL_AnimationClock* clock;  // Shared timeline, NULL for the component's own
+    NDL_AnimationSystem* system;    // Owning bulk pass, NULL when animated by NDL_Render
+    int slot;
+};
+
+/*
+ * Struct: NDL_AnimationClock
+ * --------------------------
+ * A timeline shared by any number of identical animations. It is advanced once per
+ * NDL_UpdateAnimationSystem pass, and every component using it shows the same frame.
+ */
+struct NDL_AnimationClock
+{
+    float rate;
+    float time;
+    int frame;
+    int frameCount;
+    NDL_ANIMATION_MODES mode;
+    int direction;
+    bool finished;
+    Uint32 pass;                // Last pass that advanced the clock
+    int events;                 // NDL_ANIMATION_EVENTS bits raised by that pass
+};
+
+/*
+ * Struct: NDL_AnimationSystem
+ * ---------------------------
+ * Packed animation state for a set of entities, advanced in one pass by NDL_UpdateAnimationSystem.
+ *
+ * While a component is registered, the arrays below are its live state; the component's
+ * currentFrame and finished are written back whenever they change. The pass only touches animation
+ * state and the sprite's image/srcRect/uv, so it may run alongside the physics step.
+ */
+struct NDL_AnimationSystem
+{
+    int count, capacity;
+    NDL_Entity** entities;
+    NDL_AnimationComponent** components;
+    float* time;
+    float* frameDuration;
+    int* frame;
+    int* frameCount;
+    Uint8* mode;
+    Sint8* direction;
+    NDL_AnimationClock** clocks;
+    Uint32 pass;
+    int advanced;               // Last pass
+    int skipped;                // Last pass: culled, sleeping or finished
 };
 
 
@@ -70,6 +70,56 @@ Renderer NDL_CreateRenderer(Window window, Uint32 flags);
  */
 void NDL_ClearScreen(Renderer renderer, int color[4]);
 
+/*
+ * Function: NDL_GetRenderState
+ * ----------------------------
+ * Returns the state cache for an SDL renderer, creating it on first use. NDL_SetDrawColor,
+ * NDL_SetDrawBlendMode and NDL_SetRenderTarget skip the SDL call when the value is already set.
+ * Every draw NDL_G issues is counted in the cache's per-frame NDL_RenderStats.
+ *
+ * Returns:
+ *   NDL_RenderState*: The renderer's cache.
+ */
+NDL_RenderState* NDL_GetRenderState(Renderer renderer);
+
+// Forgets cached state, after SDL state was changed directly or a renderer was destroyed
+void NDL_InvalidateRenderState(Renderer renderer);
+
+/*
+ * Function: NDL_SetDrawColor
+ * --------------------------
+ * Sets the renderer's draw color, skipping the SDL call when it is already current.
+ */
+void NDL_SetDrawColor(Renderer renderer, NDL_Color color);
+
+/*
+ * Function: NDL_SetDrawBlendMode
+ * ------------------------------
+ * Sets the renderer's draw blend mode, skipping the SDL call when it is already current.
+ */
+void NDL_SetDrawBlendMode(Renderer renderer, SDL_BlendMode mode);
+
+/*
+ * Function: NDL_SetRenderTarget
+ * -----------------------------
+ * Sets the render target, or the window when target is NULL, skipping redundant changes.
+ *
+ * Returns:
+ *   bool: false if SDL refused the target.
+ */
+bool NDL_SetRenderTarget(Renderer renderer, NDL_Texture* target);
+
+/*
+ * Function: NDL_GetRenderTarget
+ * -----------------------------
+ * Returns:
+ *   NDL_Texture*: The current render target, or NULL for the window.
+ */
+NDL_Texture* NDL_GetRenderTarget(Renderer renderer);
+
+// Counters for the frame ended by the last NDL_SendFrame
+NDL_RenderStats NDL_GetRenderStats(Renderer renderer);
+
 /*
  * Function: NDL_SendFrame
  * -----------------------------------------
@@ -103,14 +153,748 @@ void NDL_FillRect(Renderer ren, Rect* rect, NDL_Color color);
 
 void NDL_BlitColliderComponent(Renderer ren, NDL_ColliderComponent* collider, NDL_Color color);
 
+/*
+ * Function: NDL_CreateSpriteBatch
+ * -------------------------------
+ * Creates a sprite batch that collects textured and colour-only quads and submits each run of
+ * one texture with a single SDL_RenderGeometry call. Submission order is kept; see
+ * NDL_SetSpriteBatchGrouped to trade it for fewer calls.
+ *
+ * Parameters:
+ *   renderer: The SDL_Renderer the batch draws with.
+ *   quadCapacity: Initial number of quads reserved per texture group; groups grow as needed.
+ *
+ * Returns:
+ *   NDL_SpriteBatch*: The new, empty batch.
+ */
+NDL_SpriteBatch* NDL_CreateSpriteBatch(Renderer renderer, int quadCapacity);
+
+/*
+ * Function: NDL_DestroySpriteBatch
+ * --------------------------------
+ * Frees the batch; anything queued and not flushed is dropped.
+ */
+void NDL_DestroySpriteBatch(NDL_SpriteBatch* batch);
+
+// Groups quads by texture across the whole flush; only for callers whose quads never overlap
+void NDL_SetSpriteBatchGrouped(NDL_SpriteBatch* batch, bool grouped);
+
+/*
+ * Function: NDL_BatchSprite
+ * -------------------------
+ * Queues a quad of texture at dst, tinted by color. uv is normalised, and NULL uses the whole
+ * texture.
+ */
+void NDL_BatchSprite(NDL_SpriteBatch* batch, NDL_Texture* texture, const SDL_FRect* uv, const SDL_FRect* dst, NDL_Color color);
+
+// Batches the quad turned angle degrees clockwise about dst's centre; a NULL texture fills it
+void NDL_BatchSpriteEx(NDL_SpriteBatch* batch, NDL_Texture* texture, const SDL_FRect* uv, const SDL_FRect* dst, NDL_Color color, float angle);
+
+/*
+ * Function: NDL_BatchFillRect
+ * ---------------------------
+ * Queues a solid rect, drawn in the same calls as untextured quads.
+ */
+void NDL_BatchFillRect(NDL_SpriteBatch* batch, const SDL_FRect* dst, NDL_Color color);
+
+/*
+ * Function: NDL_FlushSpriteBatch
+ * ------------------------------
+ * Draws everything queued with one SDL_RenderGeometry call per texture.
+ *
+ * Returns:
+ *   int: The number of draw calls issued.
+ */
+int NDL_FlushSpriteBatch(NDL_SpriteBatch* batch);
+
+/*
+ * Function: NDL_ResetSpriteBatchStats
+ * -----------------------------------
+ * Zeroes the draw call count that flushes add to.
+ */
+void NDL_ResetSpriteBatchStats(NDL_SpriteBatch* batch);
+
+/*
+ * Function: NDL_CreateRenderQueue
+ * -------------------------------
+ * Creates an empty queue with room for capacity entities; it grows as needed.
+ */
+NDL_RenderQueue* NDL_CreateRenderQueue(int capacity);
+
+/*
+ * Function: NDL_DestroyRenderQueue
+ * --------------------------------
+ * Frees the queue; the entities in it are left alone.
+ */
+void NDL_DestroyRenderQueue(NDL_RenderQueue* queue);
+
+/*
+ * Function: NDL_SubmitRenderQueue
+ * -------------------------------
+ * Adds a sprite entity to the queue. Its key (layer, bottom edge when ySort is on, texture at the
+ * queue's LOD zoom) is computed by NDL_SortRenderQueue. Submit entities in the same order each
+ * frame for the incremental sort to apply.
+ */
+void NDL_SubmitRenderQueue(NDL_RenderQueue* queue, NDL_Entity* e);
+
+/*
+ * Function: NDL_SortRenderQueue
+ * -----------------------------
+ * Sorts the submitted keys. If the submissions match last frame's, last frame's order is re-keyed
+ * and repaired with an insertion sort, falling back to a radix sort once it has moved too many
+ * keys; otherwise a radix sort is used directly.
+ */
+void NDL_SortRenderQueue(NDL_RenderQueue* queue);
+
+/*
+ * Function: NDL_ClearRenderQueue
+ * ------------------------------
+ * Empties the queue, keeping its storage and the last frame's order for the next sort.
+ */
+void NDL_ClearRenderQueue(NDL_RenderQueue* queue);
+
+/*
+ * Function: NDL_CreateRenderRecorder
+ * ----------------------------------
+ * Creates the worker pool and buffers NDL_Render uses to cull, key and build vertices in parallel.
+ * Used while the render system batches, has no static layer and draws through SDL; other setups
+ * fall back to recording on the calling thread.
+ *
+ * Parameters:
+ *   pool: Workers to record on, owned by the caller and not destroyed with the recorder. NULL
+ *         records serially.
+ *
+ * Returns:
+ *   NDL_RenderRecorder*: The recorder.
+ */
+NDL_RenderRecorder* NDL_CreateRenderRecorder(NDL_ThreadPool* pool);
+
+/*
+ * Function: NDL_DestroyRenderRecorder
+ * -----------------------------------
+ * Frees the recorder and its buffers; the thread pool it was given is left running.
+ */
+void NDL_DestroyRenderRecorder(NDL_RenderRecorder* recorder);
+
+/*
+ * Function: NDL_CreatePixelBufferPool
+ * -----------------------------------
+ * Creates an empty pool; buffers are allocated on first acquire and reused once released.
+ */
+NDL_PixelBufferPool* NDL_CreatePixelBufferPool();
+
+/*
+ * Function: NDL_DestroyPixelBufferPool
+ * ------------------------------------
+ * Frees every released buffer and the pool. Buffers still acquired stay the caller's to free.
+ */
+void NDL_DestroyPixelBufferPool(NDL_PixelBufferPool* pool);
+
+// Returns a w x h ARGB8888 buffer with undefined contents, reusing a released one when it fits
+NDL_PixelBuffer* NDL_AcquirePixelBuffer(NDL_PixelBufferPool* pool, int w, int h);
+
+/*
+ * Function: NDL_ReleasePixelBuffer
+ * --------------------------------
+ * Returns buffer to the pool for the next NDL_AcquirePixelBuffer call.
+ */
+void NDL_ReleasePixelBuffer(NDL_PixelBufferPool* pool, NDL_PixelBuffer* buffer);
+
+/*
+ * Function: NDL_CreateStreamingTexture
+ * ------------------------------------
+ * Creates a w x h ARGB8888 texture for content generated on the CPU every frame, such as
+ * minimaps, procedural effects or video. Edit it with NDL_LockStreamingTexture or
+ * NDL_UpdateStreamingTexture, then call NDL_UnlockStreamingTexture once per frame.
+ *
+ * Parameters:
+ *   doubleBuffered: Alternate between two textures so the one being drawn is never locked.
+ *
+ * Returns:
+ *   NDL_StreamingTexture*: The texture, cleared to transparent, or NULL on failure.
+ */
+NDL_StreamingTexture* NDL_CreateStreamingTexture(Renderer renderer, int w, int h, bool doubleBuffered);
+
+/*
+ * Function: NDL_DestroyStreamingTexture
+ * -------------------------------------
+ * Frees every buffered texture and the CPU-side copy.
+ */
+void NDL_DestroyStreamingTexture(NDL_StreamingTexture* stream);
+
+/*
+ * Function: NDL_LockStreamingTexture
+ * ----------------------------------
+ * Gives write access to rect (NULL for the whole texture) and marks it for upload. Unlike
+ * SDL_LockTexture, the pixels keep their previous contents, so only the changed parts need
+ * redrawing. Several rects may be locked before NDL_UnlockStreamingTexture.
+ *
+ * Returns:
+ *   Uint32*: The rect's top-left pixel, with rows pitch bytes apart, or NULL if rect is off the texture.
+ */
+Uint32* NDL_LockStreamingTexture(NDL_StreamingTexture* stream, const SDL_Rect* rect, int* pitch);
+
+// Copies ARGB8888 pixels into rect (NULL for the whole texture) and marks it for upload
+void NDL_UpdateStreamingTexture(NDL_StreamingTexture* stream, const SDL_Rect* rect, const void* pixels, int pitch);
+
+// Uploads the back buffer's changed rects and swaps it to the front; returns the texture to draw
+NDL_Texture* NDL_UnlockStreamingTexture(NDL_StreamingTexture* stream);
+
+/*
+ * Function: NDL_GetStreamingTexture
+ * ---------------------------------
+ * Returns:
+ *   NDL_Texture*: The most recently uploaded texture, ready to draw.
+ */
+NDL_Texture* NDL_GetStreamingTexture(NDL_StreamingTexture* stream);
+
+/*
+ * Function: NDL_CreateTilemap
+ * ---------------------------
+ * Creates an empty chunked tilemap drawn from a tileset texture.
+ *
+ * Parameters:
+ *   renderer: The renderer the chunk textures are created on; it must support render targets.
+ *   tileset: Texture holding the tiles in a grid of tileW x tileH cells.
+ *   tileW, tileH: Tile size in pixels.
+ *   widthTiles, heightTiles: Map size in tiles.
+ *   chunkTiles: Chunk edge in tiles, e.g. 32.
+ *
+ * Returns:
+ *   NDL_Tilemap*: The tilemap, or NULL if the tileset is NULL.
+ */
+NDL_Tilemap* NDL_CreateTilemap(Renderer renderer, NDL_Texture* tileset, int tileW, int tileH, int widthTiles, int heightTiles, int chunkTiles);
+
+/*
+ * Function: NDL_DestroyTilemap
+ * ----------------------------
+ * Frees the map, its tile data and any chunk textures still resident.
+ */
+void NDL_DestroyTilemap(NDL_Tilemap* map);
+
+/*
+ * Function: NDL_SetTile
+ * ---------------------
+ * Sets the tile at (x, y), 0 for empty, and marks its chunk for redraw. Out of range is ignored.
+ */
+void NDL_SetTile(NDL_Tilemap* map, int x, int y, Uint16 tile);
+
+/*
+ * Function: NDL_GetTile
+ * ---------------------
+ * Returns:
+ *   Uint16: The tile at (x, y), or 0 if empty or out of range.
+ */
+Uint16 NDL_GetTile(NDL_Tilemap* map, int x, int y);
+
+/*
+ * Function: NDL_SetTilemapChunkBudget
+ * -----------------------------------
+ * Caps how many chunk textures stay resident. Past the cap, the least recently drawn off-screen
+ * chunk gives up its texture and is redrawn when it comes back into view.
+ */
+void NDL_SetTilemapChunkBudget(NDL_Tilemap* map, int maxResidentChunks);
+
+/*
+ * Function: NDL_InvalidateTilemap
+ * -------------------------------
+ * Marks every chunk for re-baking. Call it on SDL_RENDER_TARGETS_RESET, when the renderer has
+ * dropped the contents of the baked chunk textures.
+ */
+void NDL_InvalidateTilemap(NDL_Tilemap* map);
+
+/*
+ * Function: NDL_RenderTilemap
+ * ---------------------------
+ * Draws the chunks under the render system's camera view, baking the ones that are new or dirty.
+ * NDL_Render calls this before drawing sprites when the render system has a tilemap set.
+ */
+void NDL_RenderTilemap(NDL_RenderSystem* renSys, NDL_Tilemap* map);
+
+/*
+ * Function: NDL_CreateStaticLayer
+ * -------------------------------
+ * Creates an empty static layer; its planes are allocated on the first draw.
+ */
+NDL_StaticLayer* NDL_CreateStaticLayer();
+
+/*
+ * Function: NDL_DestroyStaticLayer
+ * --------------------------------
+ * Frees the layer's plane textures, queue and entry lists.
+ */
+void NDL_DestroyStaticLayer(NDL_StaticLayer* layer);
+
+/*
+ * Function: NDL_InvalidateStaticLayer
+ * -----------------------------------
+ * Forces the static layer to be redrawn in full next frame. Call it on SDL_RENDER_TARGETS_RESET
+ * or after changing a static sprite in a way the diff cannot see (e.g. the pixels of its texture).
+ */
+void NDL_InvalidateStaticLayer(NDL_StaticLayer* layer);
+
+/*
+ * Function: NDL_CreatePrimitiveBatch
+ * ----------------------------------
+ * Creates a batch for lines, rects and circles; see NDL_PrimitiveBatch for how each kind is drawn.
+ * Primitives are drawn in kind order (filled shapes, filled rects, outlines, lines), not in the
+ * order they were added.
+ *
+ * Returns:
+ *   NDL_PrimitiveBatch*: The new, empty batch.
+ */
+NDL_PrimitiveBatch* NDL_CreatePrimitiveBatch(Renderer renderer);
+
+/*
+ * Function: NDL_DestroyPrimitiveBatch
+ * -----------------------------------
+ * Frees the batch; anything queued and not flushed is dropped.
+ */
+void NDL_DestroyPrimitiveBatch(NDL_PrimitiveBatch* batch);
+
+/*
+ * Function: NDL_BatchLine
+ * -----------------------
+ * Queues a 1px line as a thin quad, drawn with every other line in one geometry call.
+ */
+void NDL_BatchLine(NDL_PrimitiveBatch* batch, float x0, float y0, float x1, float y1, NDL_Color color);
+
+/*
+ * Function: NDL_BatchRectOutline
+ * ------------------------------
+ * Queues a rect outline, drawn with the other outlines of the same color in one call.
+ */
+void NDL_BatchRectOutline(NDL_PrimitiveBatch* batch, SDL_FRect rect, NDL_Color color);
+
+/*
+ * Function: NDL_BatchRectFilled
+ * -----------------------------
+ * Queues a filled rect, drawn with the other fills of the same color in one call.
+ */
+void NDL_BatchRectFilled(NDL_PrimitiveBatch* batch, SDL_FRect rect, NDL_Color color);
+
+/*
+ * Function: NDL_BatchCircleOutline
+ * --------------------------------
+ * Queues a circle outline as line quads, with more segments for larger radii.
+ */
+void NDL_BatchCircleOutline(NDL_PrimitiveBatch* batch, float cx, float cy, float radius, NDL_Color color);
+
+/*
+ * Function: NDL_BatchCircleFilled
+ * -------------------------------
+ * Queues a filled circle as a triangle fan, drawn with the other filled shapes in one call.
+ */
+void NDL_BatchCircleFilled(NDL_PrimitiveBatch* batch, float cx, float cy, float radius, NDL_Color color);
+
+/*
+ * Function: NDL_BatchCapsuleOutline
+ * ---------------------------------
+ * Queues the outline of the capsule filling bounds, with its caps on the shorter axis.
+ */
+void NDL_BatchCapsuleOutline(NDL_PrimitiveBatch* batch, SDL_FRect bounds, NDL_Color color);
+
+/*
+ * Function: NDL_BatchColliderOutline
+ * ----------------------------------
+ * Queues the outline of collider's shape, moved by offset, e.g. minus the camera position.
+ */
+void NDL_BatchColliderOutline(NDL_PrimitiveBatch* batch, NDL_ColliderComponent* collider, Vector2F offset, NDL_Color color);
+
+/*
+ * Function: NDL_FlushPrimitiveBatch
+ * ---------------------------------
+ * Draws everything queued: filled shapes in one geometry call, rects in one call per color and
+ * lines in one geometry call. On a soft renderer the shapes are rasterized instead.
+ *
+ * Returns:
+ *   int: The number of draw calls issued, 0 on a soft renderer.
+ */
+int NDL_FlushPrimitiveBatch(NDL_PrimitiveBatch* batch);
+
+/*
+ * Function: NDL_CreateSoftRenderer
+ * --------------------------------
+ * Creates a CPU rasterizer drawing into a w x h ARGB8888 surface. Flushes split the surface into
+ * horizontal bands that run on pool, which the caller owns and may share with the render
+ * recorder; NULL draws every band on the calling thread. Spans are drawn
+ * with AVX2 or SSE2 kernels when the CPU has them and fall back to scalar code otherwise.
+ *
+ * Textures must be registered with NDL_RegisterSoftTexture or NDL_LoadSoftTexture before use, as
+ * SDL textures cannot be read back; quads with unregistered textures are counted and skipped.
+ *
+ * Returns:
+ *   NDL_SoftRenderer*: The renderer, or NULL when the target surface cannot be created.
+ */
+NDL_SoftRenderer* NDL_CreateSoftRenderer(int w, int h, NDL_ThreadPool* pool);
+
+/*
+ * Function: NDL_DestroySoftRenderer
+ * ---------------------------------
+ * Frees the target surface and the registered textures; the thread pool is left running.
+ */
+void NDL_DestroySoftRenderer(NDL_SoftRenderer* soft);
+
+/*
+ * Function: NDL_SetSoftRendererFiltering
+ * --------------------------------------
+ * Samples textures bilinearly instead of nearest-neighbour.
+ */
+void NDL_SetSoftRendererFiltering(NDL_SoftRenderer* soft, bool bilinear);
+
+// 0 = scalar, 1 = SSE2, 2 = AVX2; clamped to what the CPU supports
+void NDL_SetSoftRendererSIMD(NDL_SoftRenderer* soft, int level);
+
+/*
+ * Function: NDL_RegisterSoftTexture
+ * ---------------------------------
+ * Copies pixels as the CPU-side image of texture, replacing any earlier copy. The caller keeps
+ * pixels.
+ *
+ * Returns:
+ *   bool: false if pixels could not be converted to ARGB8888.
+ */
+bool NDL_RegisterSoftTexture(NDL_SoftRenderer* soft, NDL_Texture* texture, NDL_Surface* pixels);
+
+/*
+ * Function: NDL_LoadSoftTexture
+ * -----------------------------
+ * Loads an image file as the CPU-side image of texture.
+ *
+ * Returns:
+ *   bool: false if the file could not be loaded or converted.
+ */
+bool NDL_LoadSoftTexture(NDL_SoftRenderer* soft, NDL_Texture* texture, const char* fp);
+
+/*
+ * Function: NDL_SoftClear
+ * -----------------------
+ * Clears the target to color on the next flush, dropping quads queued before it.
+ */
+void NDL_SoftClear(NDL_SoftRenderer* soft, NDL_Color color);
+
+// uv is normalised like NDL_BatchSprite; a NULL texture queues a solid fill
+void NDL_SoftQueueQuad(NDL_SoftRenderer* soft, NDL_Texture* texture, const SDL_FRect* uv, const SDL_FRect* dst, NDL_Color color);
+
+/*
+ * Function: NDL_SoftFlush
+ * -----------------------
+ * Rasterizes every queued quad into the target surface and empties the queue.
+ */
+void NDL_SoftFlush(NDL_SoftRenderer* soft);
+
+/*
+ * Function: NDL_CompareSurfaces
+ * -----------------------------
+ * Compares two surfaces of the same size channel by channel, e.g. a soft renderer frame against
+ * one read back from SDL with SDL_RenderReadPixels.
+ *
+ * Returns:
+ *   int: The number of pixels with any channel differing by more than tolerance, or -1 when the
+ *        sizes differ or a surface cannot be converted.
+ */
+int NDL_CompareSurfaces(NDL_Surface* a, NDL_Surface* b, Uint8 tolerance);
+
+/*
+ * Function: NDL_BenchmarkSoftRenderer
+ * -----------------------------------
+ * Draws iterations frames of quadCount blended quadSize x quadSize quads at the renderer's current
+ * SIMD level and filtering.
+ *
+ * Returns:
+ *   double: Throughput in megapixels per second, counting covered pixels only.
+ */
+double NDL_BenchmarkSoftRenderer(NDL_SoftRenderer* soft, int quadSize, int quadCount, int iterations);
+
 void NDL_Render(NDL_RenderSystem* renSys, float deltaTime);
 
 NDL_RenderSystem* NDL_CreateRenderSystem(Renderer sdlRenderer, NDL_Color clearColor);
 
+/*
+ * Function: NDL_AddRenderViewport
+ * -------------------------------
+ * Adds a split-screen view drawing to rect through camera. Once a render system has viewports,
+ * NDL_Render culls and sorts once for all of them and draws the shared queue into each.
+ *
+ * Returns:
+ *   int: The viewport's index, or -1 when NDL_MAX_VIEWPORTS are already in use.
+ */
+int NDL_AddRenderViewport(NDL_RenderSystem* renSys, SDL_Rect rect, NDL_Camera* camera);
+
+/*
+ * Function: NDL_SetRenderViewport
+ * -------------------------------
+ * Moves an existing viewport to rect and points it at camera.
+ */
+void NDL_SetRenderViewport(NDL_RenderSystem* renSys, int index, SDL_Rect rect, NDL_Camera* camera);
+
+/*
+ * Function: NDL_ClearRenderViewports
+ * ----------------------------------
+ * Removes every viewport, so NDL_Render draws the whole window through the main camera again.
+ */
+void NDL_ClearRenderViewports(NDL_RenderSystem* renSys);
+
+// Clips drawing to the viewport and makes its camera current, for overlays such as particles
+void NDL_BeginRenderViewport(NDL_RenderSystem* renSys, int index);
+
+/*
+ * Function: NDL_EndRenderViewport
+ * -------------------------------
+ * Undoes NDL_BeginRenderViewport, restoring the main camera and the full window.
+ */
+void NDL_EndRenderViewport(NDL_RenderSystem* renSys);
+
 NDL_ImageSet* NDL_CreateImageSet_PNG(Renderer ren, const char* fp);
 
+/*
+ * Function: NDL_CreateImageSet_PNG_Atlas
+ * --------------------------------------
+ * Loads every .png in a folder into an atlas instead of one texture per frame.
+ *
+ * images[i] is the atlas page holding frame i and regions[i] its source rect, so the frames of
+ * an animation usually share a single texture.
+ *
+ * Returns:
+ *   NDL_ImageSet*: The image set, or NULL if the folder holds no .png files.
+ */
+NDL_ImageSet* NDL_CreateImageSet_PNG_Atlas(NDL_Atlas* atlas, const char* fp);
+
+/*
+ * Function: NDL_CreateAtlas
+ * -------------------------
+ * Creates an empty texture atlas whose pages are pageWidth x pageHeight RGBA32 textures.
+ *
+ * Returns:
+ *   NDL_Atlas*: The atlas. Pages are created on demand as images are added.
+ */
+NDL_Atlas* NDL_CreateAtlas(Renderer renderer, int pageWidth, int pageHeight);
+
+/*
+ * Function: NDL_DestroyAtlas
+ * --------------------------
+ * Frees every page; textures and regions taken from the atlas become invalid.
+ */
+void NDL_DestroyAtlas(NDL_Atlas* atlas);
+
+/*
+ * Function: NDL_AtlasAddSurface
+ * -----------------------------
+ * Packs a surface into the atlas and uploads its pixels to the chosen page.
+ *
+ * Parameters:
+ *   atlas: The atlas to pack into.
+ *   surface: The image; converted to RGBA32 if needed. The caller keeps ownership.
+ *   region: Receives the page texture, source rect and uv of the packed image.
+ *
+ * Returns:
+ *   bool: false if the image is larger than a page.
+ */
+bool NDL_AtlasAddSurface(NDL_Atlas* atlas, NDL_Surface* surface, NDL_AtlasRegion* region);
+
+/*
+ * Function: NDL_AtlasAddImage
+ * ---------------------------
+ * Loads an image file and packs it like NDL_AtlasAddSurface.
+ *
+ * Returns:
+ *   bool: false if the file could not be loaded or is larger than a page.
+ */
+bool NDL_AtlasAddImage(NDL_Atlas* atlas, const char* fp, NDL_AtlasRegion* region);
+
+/*
+ * Function: NDL_BuildTextureLOD
+ * -----------------------------
+ * Box-filters pixels (the texture's source image) on the CPU into up to levels - 1 successively
+ * halved textures and attaches them to texture. The renderer then draws sprites and particles
+ * from the level closest to their on-screen scale, so zoomed-out scenes sample far fewer texels.
+ * Atlas pages are refused: their regions sit a padding apart at arbitrary offsets, and the box
+ * filter would bleed neighbouring regions into each other.
+ *
+ * Parameters:
+ *   ren: The renderer to create the levels on.
+ *   texture: The full-size texture, which stays level 0.
+ *   pixels: The image texture was created from.
+ *   levels: Total levels including the full size, at most NDL_MAX_TEXTURE_LODS.
+ *
+ * Returns:
+ *   bool: true if at least one smaller level was built, false for atlas pages.
+ */
+bool NDL_BuildTextureLOD(Renderer ren, NDL_Texture* texture, NDL_Surface* pixels, int levels);
+
+// Loads an image into a texture with levels LOD levels built from it, or returns NULL
+NDL_Texture* NDL_LoadTextureLOD(Renderer ren, const char* fp, int levels);
+
+// Frees the smaller levels; call before destroying the texture itself
+void NDL_DestroyTextureLOD(NDL_Texture* texture);
+
+// The level of texture closest to scale (1 = full size), or texture itself when it has none
+NDL_Texture* NDL_GetTextureLOD(NDL_Texture* texture, float scale, int* level);
+
+/*
+ * Function: NDL_LoadFont
+ * ----------------------
+ * Loads a BMFont text descriptor and packs each of its glyphs into atlas. Page images are looked
+ * up next to the .fnt file. Characters are single bytes; any undefined one draws as '?'.
+ *
+ * Parameters:
+ *   atlas: The atlas receiving the glyphs.
+ *   fp: Path of the .fnt file.
+ *
+ * Returns:
+ *   NDL_Font*: The font, or NULL if the file or one of its pages could not be read.
+ */
+NDL_Font* NDL_LoadFont(NDL_Atlas* atlas, const char* fp);
+
+// Frees the font and its layout cache; its glyphs stay in the atlas
+void NDL_DestroyFont(NDL_Font* font);
+
+// Lays text out, or returns the cached layout; valid until the string is evicted by later calls
+const NDL_TextLayout* NDL_LayoutText(NDL_Font* font, const char* text);
+
+/*
+ * Function: NDL_MeasureText
+ * -------------------------
+ * Returns:
+ *   Vector2F: The size text would take when drawn with NDL_DrawText.
+ */
+Vector2F NDL_MeasureText(NDL_Font* font, const char* text);
+
+/*
+ * Function: NDL_DrawText
+ * ----------------------
+ * Queues text's glyph quads on batch with its top-left at (x, y) in screen space, tinted by color.
+ * Nothing is drawn until the batch is flushed, which costs one geometry call per atlas page.
+ */
+void NDL_DrawText(NDL_SpriteBatch* batch, NDL_Font* font, const char* text, float x, float y, NDL_Color color);
+
+/*
+ * Function: NDL_CreateGuiContext
+ * ------------------------------
+ * Creates an immediate-mode GUI drawing with font. A white texel is packed into atlas for
+ * backgrounds; passing the atlas the font was loaded into keeps fills and text on one texture.
+ *
+ * Returns:
+ *   NDL_GuiContext*: The context, or NULL if the atlas has no room for the white texel.
+ */
+NDL_GuiContext* NDL_CreateGuiContext(Renderer ren, NDL_Atlas* atlas, NDL_Font* font);
+
+/*
+ * Function: NDL_DestroyGuiContext
+ * -------------------------------
+ * Frees the context and its cached text layouts; the font is left alone.
+ */
+void NDL_DestroyGuiContext(NDL_GuiContext* ctx);
+
+// Feeds typed text, backspace, enter and the mouse wheel to the GUI; call for every polled event
+void NDL_GuiHandleEvent(NDL_GuiContext* ctx, const Event* event);
+
+// Samples the mouse and starts recording a new frame of widgets
+void NDL_GuiBeginFrame(NDL_GuiContext* ctx);
+
+/*
+ * Function: NDL_GuiBeginPanel
+ * ---------------------------
+ * Starts a movable, scrollable panel. rect is only used the first time the title is seen; after
+ * that the panel keeps its own position. Widgets stack top to bottom inside it until
+ * NDL_GuiEndPanel. Labels may end in "##suffix" to tell apart widgets with the same text.
+ */
+void NDL_GuiBeginPanel(NDL_GuiContext* ctx, const char* title, SDL_FRect rect);
+
+/*
+ * Function: NDL_GuiEndPanel
+ * -------------------------
+ * Closes the panel begun by NDL_GuiBeginPanel and draws its title bar over the scrolled rows.
+ */
+void NDL_GuiEndPanel(NDL_GuiContext* ctx);
+
+/*
+ * Function: NDL_GuiLabel
+ * ----------------------
+ * Adds a row of text. Its layout is cached by row, so labels that change every frame stay cheap.
+ */
+void NDL_GuiLabel(NDL_GuiContext* ctx, const char* text);
+
+// Returns true on the frame the button is clicked
+bool NDL_GuiButton(NDL_GuiContext* ctx, const char* label);
+
+// Returns true while dragging changes value
+bool NDL_GuiSlider(NDL_GuiContext* ctx, const char* label, float* value, float min, float max);
+
+// Edits a NUL-terminated buffer in place; returns true on the frame enter is pressed in it
+bool NDL_GuiTextField(NDL_GuiContext* ctx, const char* label, char* buffer, int size);
+
+// Submits the frame's draw list, one geometry call per texture run per panel, back to front.
+// The renderer's clip rect is put back afterwards.
+void NDL_GuiRender(NDL_GuiContext* ctx);
+
 NDL_Texture* NDL_AnimationFlip(NDL_AnimationComponent* anim, float deltaTime);
 
+/*
+ * Function: NDL_CreateAnimationClock
+ * ----------------------------------
+ * Creates a clock shared by the animations that follow it via NDL_SetAnimationClock, so they stay
+ * in step. frameCount comes from imageSet, or is 0 when NULL.
+ */
+NDL_AnimationClock* NDL_CreateAnimationClock(NDL_ImageSet* imageSet, float framesPerSecond, NDL_ANIMATION_MODES mode);
+
+/*
+ * Function: NDL_CreateAnimationSystem
+ * -----------------------------------
+ * Creates an empty animation system with room for capacity animations; it grows as needed.
+ */
+NDL_AnimationSystem* NDL_CreateAnimationSystem(int capacity);
+
+/*
+ * Function: NDL_DestroyAnimationSystem
+ * ------------------------------------
+ * Frees the system and detaches its animations, which keep their state but no longer advance.
+ */
+void NDL_DestroyAnimationSystem(NDL_AnimationSystem* system);
+
+/*
+ * Function: NDL_AddToAnimationSystem
+ * ----------------------------------
+ * Moves an entity's animation into the system's packed arrays. From then on NDL_Render no longer
+ * advances it; NDL_UpdateAnimationSystem does.
+ */
+void NDL_AddToAnimationSystem(NDL_AnimationSystem* system, NDL_Entity* e);
+
+/*
+ * Function: NDL_RemoveFromAnimationSystem
+ * ---------------------------------------
+ * Removes the entity's animation, copying its current frame and time back into the component.
+ */
+void NDL_RemoveFromAnimationSystem(NDL_AnimationSystem* system, NDL_Entity* e);
+
+/*
+ * Function: NDL_UpdateAnimationSystem
+ * -----------------------------------
+ * Advances every registered animation by deltaTime, raises their events and applies the current
+ * frame to each sprite. Shared clocks are advanced once per pass. When anything advanced and
+ * renSys has a scheduler (NDL_SetRenderSystemScheduler), the next frame is requested from it.
+ *
+ * Parameters:
+ *   system: The animation system.
+ *   renSys: When not NULL, entities that were not drawn in its last frame are skipped and its
+ *           scheduler is kept rendering.
+ *   deltaTime: Seconds since the last pass.
+ *
+ * Returns:
+ *   int: How many components are still running, also kept in system->advanced.
+ */
+int NDL_UpdateAnimationSystem(NDL_AnimationSystem* system, NDL_RenderSystem* renSys, float deltaTime);
+
 NDL_AnimationComponent* NDL_CreateAnimation(bool loop, int flipRate);
 
+// Draws every live particle with one SDL_RenderGeometry call, offset by the render system's camera
+void NDL_RenderParticleEmitter(NDL_RenderSystem* renSys, NDL_ParticleEmitter* em);
+
+/*
+ * Function: NDL_RenderVerletSystem
+ * --------------------------------
+ * Draws the system's ropes and cloth strips as lines through the render system's camera.
+ */
+void NDL_RenderVerletSystem(NDL_RenderSystem* renSys, NDL_VerletSystem* vs);
+
 #endif
@@ -36,6 +36,84 @@ bool NDL_AABB_PosY(NDL_Entity* ent1, NDL_Entity* ent2);
 
 NDL_CollisionData NDL_GenerateCollisionInfo_P(NDL_Entity* ent1, NDL_Entity* ent2);
 
+/*
+ * Function: NDL_CreateShapePairs_P
+ * --------------------------------
+ * Allocates a structure-of-arrays batch of candidate pairs for the round-shape narrowphase.
+ *
+ * Pairs are queued with NDL_PushShapePair_P and tested together by one of the batch kernels
+ * (NDL_CircleCircleBatch_P, NDL_CircleBoxBatch_P, NDL_CircleCapsuleBatch_P, NDL_CapsuleBoxBatch_P),
+ * which process four pairs per SSE2 instruction when the CPU supports it.
+ *
+ * Returns:
+ *   NDL_ShapePairs*: The new, empty batch.
+ */
+NDL_ShapePairs* NDL_CreateShapePairs_P(int capacity);
+
+void NDL_ReserveShapePairs_P(NDL_ShapePairs* pairs, int capacity);
+
+void NDL_ClearShapePairs_P(NDL_ShapePairs* pairs);
+
+int NDL_PushShapePair_P(NDL_ShapePairs* pairs, NDL_Entity* a, NDL_Entity* b);
+
+void NDL_CircleCircleBatch_P(NDL_ShapePairs* pairs);
+
+void NDL_CircleBoxBatch_P(NDL_ShapePairs* pairs);
+
+void NDL_CircleCapsuleBatch_P(NDL_ShapePairs* pairs);
+
+void NDL_CapsuleBoxBatch_P(NDL_ShapePairs* pairs);
+
+void NDL_CapsuleCapsuleBatch_P(NDL_ShapePairs* pairs);
+
+int NDL_ResolveShapePairs_P(NDL_ShapePairs* pairs);
+
+/*
+ * Function: NDL_CreateCollisionMask
+ * ---------------------------------
+ * Builds a packed 1-bit collision mask from the alpha channel of a surface.
+ *
+ * Parameters:
+ *   surface: Any SDL surface; it is converted to RGBA internally and left untouched.
+ *   alphaThreshold: Pixels with alpha greater than or equal to this value are solid.
+ *
+ * Returns:
+ *   NDL_CollisionMask*: The new mask, or NULL if the surface could not be read.
+ */
+NDL_CollisionMask* NDL_CreateCollisionMask(NDL_Surface* surface, Uint8 alphaThreshold);
+
+/*
+ * Function: NDL_LoadCollisionMask
+ * -------------------------------
+ * Loads an image file and builds a mask like NDL_CreateCollisionMask.
+ *
+ * Returns:
+ *   NDL_CollisionMask*: The mask, or NULL if the file could not be loaded.
+ */
+NDL_CollisionMask* NDL_LoadCollisionMask(const char* fp, Uint8 alphaThreshold);
+
+/*
+ * Function: NDL_FreeCollisionMask
+ * -------------------------------
+ * Frees a mask; NULL is ignored.
+ */
+void NDL_FreeCollisionMask(NDL_CollisionMask* mask);
+
+/*
+ * Function: NDL_MaskOverlap_P
+ * ---------------------------
+ * Tests two collision masks placed at integer positions for any shared solid pixel.
+ *
+ * Rows are compared a 64-bit word at a time (two words per SSE2 instruction when available),
+ * shifting one mask's row to line up sub-word offsets, and the test stops at the first hit.
+ *
+ * Returns:
+ *   bool: True if at least one pixel is solid in both masks.
+ */
+bool NDL_MaskOverlap_P(const NDL_CollisionMask* a, int ax, int ay, const NDL_CollisionMask* b, int bx, int by);
+
+bool NDL_PixelCollision_P(NDL_Entity* ent1, NDL_Entity* ent2);
+
 bool NDL_ObserveCollision_P(NDL_PhysicsGrid* grid);
 
 void NDL_UpdateColliderComponent_P(NDL_ColliderComponent* collider, float deltaTime);
@@ -52,4 +130,269 @@ NDL_PhysicsSystem* NDL_CreatePhysicsSystem(int gridSpaceW, int gridSpaceH, int n
 
 void NDL_AddEntityToGrid(NDL_Entity* e, NDL_PhysicsGrid* grid);
 
+void NDL_SamplePhysicsGridOccupancy_P(NDL_PhysicsGrid* grid, NDL_PhysicsStats* stats);
+
+/*
+ * Function: NDL_MortonCode
+ * ------------------------
+ * Interleaves x and y, quantised to NDL_MORTON_QUANTUM and clamped to 16 bits each, so nearby
+ * positions get nearby codes.
+ *
+ * Returns:
+ *   Uint32: The Z-order code.
+ */
+Uint32 NDL_MortonCode(float x, float y);
+
+/*
+ * Function: NDL_SortPoolMorton
+ * ----------------------------
+ * Sorts a pool's entity array by the Z-order (Morton) code of each entity's position,
+ * so entities that are close in space are also close in the array.
+ *
+ * Only the array of entity pointers is reordered; every NDL_Entity* held elsewhere stays valid,
+ * and the entities themselves stay where they were allocated. In a grid cell the payoff is that
+ * the broadphase's per-cell body bounds, gathered in pool order, come out spatially coherent.
+ * Sorting a pool that is drawn directly also changes the order sprites are painted in.
+ *
+ * Returns:
+ *   void: This function does not return a value.
+ */
+void NDL_SortPoolMorton(NDL_Pool* pool);
+
+/*
+ * Function: NDL_QueryGridRect
+ * ---------------------------
+ * Collects the entities binned in the cells covering a world-space rect grown by the largest
+ * sprite or collider diagonal in the grid, plus one cell for drawing a tick behind.
+ *
+ * The result is a superset of the entities reaching into rect; callers test their own bounds.
+ * A grid whose physics system has stepped since it was last binned is rebinned first. Entities
+ * moved or resized by hand need an NDL_RebinPhysicsGrid before they are queried.
+ *
+ * Parameters:
+ *   grid: The grid to query.
+ *   rect: The world-space rect.
+ *   out: Receives up to maxCount entities.
+ *   maxCount: Capacity of out.
+ *
+ * Returns:
+ *   int: The number of entities found, which may exceed maxCount; grow out and query again.
+ */
+int NDL_QueryGridRect(NDL_PhysicsGrid* grid, SDL_FRect rect, NDL_Entity** out, int maxCount);
+
+/*
+ * Function: NDL_RebinPhysicsGrid
+ * ------------------------------
+ * Moves entities that have left their cell into the cell their position now falls in, and
+ * updates the extent NDL_QueryGridRect pads by. Entities outside the grid stay where they are.
+ */
+void NDL_RebinPhysicsGrid(NDL_PhysicsGrid* grid);
+
+/*
+ * Function: NDL_ReorderPhysicsGrid
+ * --------------------------------
+ * Moves entities that have left their grid cell into the cell they now occupy, then
+ * sorts every cell in Morton order. NDL_UpdateSystem runs this automatically every
+ * N frames when NDL_SetPhysicsSystemReorderInterval has been given a non-zero N.
+ *
+ * Returns:
+ *   void: This function does not return a value.
+ */
+void NDL_ReorderPhysicsGrid(NDL_PhysicsGrid* grid);
+
+/*
+ * Function: NDL_CreateVerletSystem
+ * --------------------------------
+ * Creates a Verlet point-mass system for ropes, chains and cloth.
+ *
+ * Points and constraints are added with NDL_AddVerletPoint/NDL_AddVerletConstraint or the
+ * NDL_CreateVerletRope/NDL_CreateVerletCloth helpers, stepped with NDL_UpdateVerletSystem
+ * and drawn with NDL_RenderVerletSystem.
+ *
+ * Parameters:
+ *   maxPoints: Number of point masses the system can hold.
+ *   maxConstraints: Number of distance constraints the system can hold.
+ *
+ * Returns:
+ *   NDL_VerletSystem*: The new, empty system.
+ */
+NDL_VerletSystem* NDL_CreateVerletSystem(int maxPoints, int maxConstraints);
+
+/*
+ * Function: NDL_DestroyVerletSystem
+ * ---------------------------------
+ * Frees the system's points, constraints and strips.
+ */
+void NDL_DestroyVerletSystem(NDL_VerletSystem* vs);
+
+/*
+ * Function: NDL_AddVerletPoint
+ * ----------------------------
+ * Adds a point mass at rest at position. Pinned points are never moved by the solver.
+ *
+ * Returns:
+ *   int: The point's index, or -1 when the system is full.
+ */
+int NDL_AddVerletPoint(NDL_VerletSystem* vs, Vector2F position, bool pinned);
+
+/*
+ * Function: NDL_AddVerletConstraint
+ * ---------------------------------
+ * Keeps points a and b restLength apart; a negative restLength keeps their current distance.
+ */
+void NDL_AddVerletConstraint(NDL_VerletSystem* vs, int a, int b, float restLength);
+
+/*
+ * Function: NDL_PinVerletPoint
+ * ----------------------------
+ * Pins or unpins point i.
+ */
+void NDL_PinVerletPoint(NDL_VerletSystem* vs, int i, bool pinned);
+
+/*
+ * Function: NDL_MoveVerletPoint
+ * -----------------------------
+ * Teleports point i to position with no velocity, e.g. to drag a pinned end.
+ */
+void NDL_MoveVerletPoint(NDL_VerletSystem* vs, int i, Vector2F position);
+
+/*
+ * Function: NDL_GetVerletPoint
+ * ----------------------------
+ * Returns:
+ *   Vector2F: The current position of point i.
+ */
+Vector2F NDL_GetVerletPoint(NDL_VerletSystem* vs, int i);
+
+/*
+ * Function: NDL_CreateVerletRope
+ * ------------------------------
+ * Adds a rope of segments links from start to end, optionally pinned at either end.
+ *
+ * Returns:
+ *   int: The index of the first point, or -1 when the system is too small.
+ */
+int NDL_CreateVerletRope(NDL_VerletSystem* vs, Vector2F start, Vector2F end, int segments, bool pinStart, bool pinEnd);
+
+/*
+ * Function: NDL_CreateVerletCloth
+ * -------------------------------
+ * Adds a cols x rows grid of points spacing apart, optionally pinned along the top row.
+ *
+ * Returns:
+ *   int: The index of the top-left point, or -1 when the system is too small.
+ */
+int NDL_CreateVerletCloth(NDL_VerletSystem* vs, Vector2F topLeft, int cols, int rows, float spacing, bool pinTop);
+
+/*
+ * Function: NDL_SetVerletGravity
+ * ------------------------------
+ * Sets the acceleration applied to every unpinned point.
+ */
+void NDL_SetVerletGravity(NDL_VerletSystem* vs, Vector2F gravity);
+
+/*
+ * Function: NDL_SetVerletIterations
+ * ---------------------------------
+ * Sets how many relaxation passes each step makes; more is stiffer, at least 1.
+ */
+void NDL_SetVerletIterations(NDL_VerletSystem* vs, int iterations);
+
+/*
+ * Function: NDL_SetVerletCollisionGrid
+ * ------------------------------------
+ * Pushes points out of the static colliders in grid, or turns collision off when NULL.
+ */
+void NDL_SetVerletCollisionGrid(NDL_VerletSystem* vs, NDL_PhysicsGrid* grid);
+
+/*
+ * Function: NDL_UpdateVerletSystem
+ * --------------------------------
+ * Advances every point by one Verlet step, relaxes the constraints and, if a collision
+ * grid is set, pushes points out of the static colliders stored in it.
+ *
+ * Parameters:
+ *   vs: The Verlet system to step.
+ *   deltaTime: Step length in seconds; a fixed step gives the most stable results.
+ *
+ * Returns:
+ *   void: This function does not return a value.
+ */
+void NDL_UpdateVerletSystem(NDL_VerletSystem* vs, float deltaTime);
+
+/*
+ * Function: NDL_CreateParticleEmitter
+ * -----------------------------------
+ * Creates an emitter holding up to maxParticles particles for sparks, smoke and similar
+ * effects, which are far too many to be entities. Particles are spawned with NDL_EmitParticles
+ * or the emitter's rate, stepped with NDL_UpdateParticleEmitter and drawn with
+ * NDL_RenderParticleEmitter in one geometry call per emitter.
+ *
+ * Parameters:
+ *   texture: Drawn on every particle, or NULL for plain coloured squares.
+ *
+ * Returns:
+ *   NDL_ParticleEmitter*: The new, empty emitter.
+ */
+NDL_ParticleEmitter* NDL_CreateParticleEmitter(int maxParticles, NDL_Texture* texture);
+
+/*
+ * Function: NDL_DestroyParticleEmitter
+ * ------------------------------------
+ * Frees the emitter and its particles; the texture is left alone.
+ */
+void NDL_DestroyParticleEmitter(NDL_ParticleEmitter* em);
+
+/*
+ * Function: NDL_SetParticleEmitterPosition
+ * ----------------------------------------
+ * Moves where new particles spawn; live particles are unaffected.
+ */
+void NDL_SetParticleEmitterPosition(NDL_ParticleEmitter* em, Vector2F position);
+
+/*
+ * Function: NDL_SetParticleEmitterRate
+ * ------------------------------------
+ * Spawns particlesPerSecond particles during updates; 0 leaves only NDL_EmitParticles bursts.
+ */
+void NDL_SetParticleEmitterRate(NDL_ParticleEmitter* em, float particlesPerSecond);
+
+// angle and spread are in radians; 0 launches along +x
+void NDL_SetParticleLaunch(NDL_ParticleEmitter* em, float angle, float spread, float speedMin, float speedMax);
+
+/*
+ * Function: NDL_SetParticleLifetime
+ * ---------------------------------
+ * Gives each new particle a lifetime picked between minSeconds and maxSeconds.
+ */
+void NDL_SetParticleLifetime(NDL_ParticleEmitter* em, float minSeconds, float maxSeconds);
+
+/*
+ * Function: NDL_SetParticleSize
+ * -----------------------------
+ * Gives each new particle a size picked between minSize and maxSize.
+ */
+void NDL_SetParticleSize(NDL_ParticleEmitter* em, float minSize, float maxSize);
+
+// Particles blend from start to end over their lifetime
+void NDL_SetParticleColors(NDL_ParticleEmitter* em, NDL_Color start, NDL_Color end);
+
+/*
+ * Function: NDL_SetParticleForces
+ * -------------------------------
+ * Sets the acceleration applied to every particle and the fraction of speed lost per second.
+ */
+void NDL_SetParticleForces(NDL_ParticleEmitter* em, Vector2F gravity, float drag);
+
+// Spawns a burst at the emitter position; returns how many fit
+int NDL_EmitParticles(NDL_ParticleEmitter* em, int count);
+
+/*
+ * Function: NDL_UpdateParticleEmitter
+ * -----------------------------------
+ * Moves and ages every particle, removes the expired ones and spawns the rate's share for
+ * deltaTime.
+ */
+void NDL_UpdateParticleEmitter(NDL_ParticleEmitter* em, float deltaTime);
+
 #endif
\ No newline at end of file
@@ -142,6 +142,141 @@ float NDL_GetDeltaTime(NDL_Clock* clock);
  */
 void NDL_CapFPS(NDL_Clock* clock);
 
+/*
+ * Function: NDL_InitFrameScheduler
+ * -----------------------------------------
+ * Initializes a scheduler for event-driven rendering. A loop using it reads events through
+ * NDL_GetScheduledEvent and only draws when NDL_BeginScheduledFrame returns true:
+ *
+ *   NDL_SetRenderSystemScheduler(renSys, &sched);
+ *   while (running) {
+ *       while (NDL_GetScheduledEvent(&sched, &event, window, renderer)) { ... }
+ *       NDL_UpdateClock(&clock);
+ *       if (!NDL_BeginScheduledFrame(&sched, &clock)) continue;
+ *       NDL_UpdateAnimationSystem(anims, renSys, clock.deltaTime);
+ *       ... update and render ...
+ *       NDL_CapFPS(&clock);
+ *   }
+ *
+ * Parameters:
+ *   scheduler: The scheduler to initialize.
+ *   idle: True to block while nothing changes, false to render every frame.
+ *
+ * Returns:
+ *   Void.
+ */
+void NDL_InitFrameScheduler(NDL_FrameScheduler* scheduler, bool idle);
+
+/*
+ * Function: NDL_SetIdleRendering
+ * ------------------------------
+ * Switches between idle and continuous rendering, rendering the next frame either way.
+ */
+void NDL_SetIdleRendering(NDL_FrameScheduler* scheduler, bool idle);
+
+// Marks the next frame as needing a render, e.g. after loading finishes or data changes
+void NDL_RequestRedraw(NDL_FrameScheduler* scheduler);
+
+// Renders one frame after delayMs even if nothing else happens. Up to NDL_SCHEDULER_TIMERS
+// redraws stay pending at once; past that the latest is dropped.
+void NDL_ScheduleRedraw(NDL_FrameScheduler* scheduler, Uint32 delayMs);
+
+/*
+ * Function: NDL_RequestAnimation
+ * -----------------------------------------
+ * Keeps the scheduler rendering continuously for durationMs, or for the next frame when 0.
+ * Call it every frame something is moving, and idle mode resumes on its own once the calls stop.
+ * A render system given the scheduler with NDL_SetRenderSystemScheduler calls it for animations.
+ */
+void NDL_RequestAnimation(NDL_FrameScheduler* scheduler, Uint32 durationMs);
+
+/*
+ * Function: NDL_GetScheduledEvent
+ * -----------------------------------------
+ * As NDL_GetEvent, but in idle mode the first call of a frame blocks in SDL_WaitEventTimeout
+ * until an event arrives or the next redraw is due. Any event marks the frame dirty.
+ *
+ * Returns:
+ *   True if an event was read, false once the queue is empty.
+ */
+bool NDL_GetScheduledEvent(NDL_FrameScheduler* scheduler, Event* event, Window window, Renderer renderer);
+
+/*
+ * Function: NDL_BeginScheduledFrame
+ * -----------------------------------------
+ * Reports whether this frame should update and render, and clears the requests it satisfies.
+ * When clock is given and the loop has just woken from a wait, its delta time is clamped to
+ * one frame so time-based updates don't jump by the whole idle period.
+ *
+ * Returns:
+ *   True to render this frame.
+ */
+bool NDL_BeginScheduledFrame(NDL_FrameScheduler* scheduler, NDL_Clock* clock);
+
+/*
+ * Function: NDL_GetElapsedMs
+ * -----------------------------------------
+ * Returns the milliseconds elapsed since a value taken from SDL_GetPerformanceCounter.
+ *
+ * Parameters:
+ *   startCounter: A performance counter value captured earlier.
+ *
+ * Returns:
+ *   A double-precision value in milliseconds with sub-microsecond resolution.
+ */
+double NDL_GetElapsedMs(Uint64 startCounter);
+
+// Cached CPU feature checks shared by the physics and graphics SIMD paths
+bool NDL_HasSSE2();
+
+bool NDL_HasAVX2();
+
+/*
+ * Function: NDL_CreateThreadPool
+ * -----------------------------------------
+ * Starts a pool of worker threads for NDL_RunParallel.
+ *
+ * Parameters:
+ *   threadCount: Number of workers; 0 or less uses one per CPU core minus the calling thread.
+ *
+ * One pool is meant to serve the whole program: the soft renderer and the render recorder borrow
+ * the pool they are given, so create it once and destroy it after both.
+ *
+ * Returns:
+ *   NDL_ThreadPool*: The pool. With one core it has no workers and jobs run on the caller.
+ */
+NDL_ThreadPool* NDL_CreateThreadPool(int threadCount);
+
+/*
+ * Function: NDL_DestroyThreadPool
+ * -------------------------------
+ * Stops and joins every worker. Nothing that borrows the pool may run afterwards.
+ */
+void NDL_DestroyThreadPool(NDL_ThreadPool* pool);
+
+/*
+ * Function: NDL_RunParallel
+ * -----------------------------------------
+ * Calls job(userData, i) for every i in [0, jobCount) across the pool's workers and the calling
+ * thread, and returns when all calls have finished. Jobs must not call NDL_RunParallel on the
+ * same pool.
+ */
+void NDL_RunParallel(NDL_ThreadPool* pool, int jobCount, NDL_JobMethod job, void* userData);
+
+/*
+ * Function: NDL_FormatInt
+ * -----------------------
+ * Writes value in decimal into buffer without touching the heap or the C locale, for HUD
+ * counters formatted every frame. Output is truncated to fit and always NUL-terminated.
+ *
+ * Returns:
+ *   int: Characters written, not counting the terminator.
+ */
+int NDL_FormatInt(char* buffer, int size, long long value);
+
+// As NDL_FormatInt, with decimals (0-9) digits after the point, rounded half away from zero
+int NDL_FormatFloat(char* buffer, int size, double value, int decimals);
+
 int NDL_IsMouseHover(int mouseX, int mouseY, int pointX, int pointY, int size);
 
 char* NDL_ReadFileToString(const char* filename);
@@ -156,6 +291,9 @@ Vector2 NDL_GetWindowSize(SDL_Window* window);
 
 NDL_Camera* NDL_CreateCamera(Vector2F position, float panSpeed, float interpolation);
 
+// Sets the zoom, moving the camera so the world point under anchor (screen pixels) stays put
+void NDL_SetCameraZoom(NDL_Camera* cam, float zoom, Vector2F anchor);
+
 // void NDL_CenterCameraOnEntity(Window win, NDL_Camera* cam, NDL_Entity* entity, float deltaTime);
 
 // void NDL_BoxCamera(NDL_Camera* cam, NDL_Entity* entity, SDL_Rect box, float deltaTime);
@@ -19,7 +19,11 @@ NDL_Entity* NDL_CreateEntity()
     e->tag = NULL;
     e->sprite = NULL;
     e->collider = NULL;
+    e->transform = NULL;
     e->isDynamic = false;
+    e->isSleeping = false;
+    e->position = (Vector2F){0,0};
+    e->velocity = (Vector2F){0,0};
     e->componentFlags = NO_COMPONENT;
     return e;
 }
@@ -29,8 +33,8 @@ NDL_Pool* NDL_CreatePool(int poolSize)
     NDL_Pool* pool = malloc(sizeof(NDL_Pool));
     pool->size = 0;
     pool->maxSize = poolSize;
-    pool->entities = malloc(sizeof(NDL_Entity)*pool->size);
-    for (int i = 0; i < pool->size; ++i)
+    pool->entities = malloc(sizeof(NDL_Entity*)*pool->maxSize);
+    for (int i = 0; i < pool->maxSize; ++i)
     {
         pool->entities[i] = NULL;
     }
@@ -65,6 +69,9 @@ NDL_ColliderComponent* NDL_CreateColliderComponent(float x, float y, int w, int
     collider->velocity.x = 0.0;
     collider->velocity.y = 0.0;
     collider->r = NDL_CreateRect(w, h, x, y);
+    collider->shape = BOX_COLLIDER;
+    collider->radius = 0.0;
+    collider->mask = NULL;
 
     return collider; // Return a pointer to the newly created NDL_RigidBody
 }
@@ -76,6 +83,18 @@ void NDL_AddSpriteComponent(NDL_Entity *entity, Vector2 size, NDL_Color spriteCo
     sprite->imageOffset = (Vector2){0,0};
     sprite->imageRect = (Rect){0,0,size.x,size.y};
     sprite->image = NULL;
+    sprite->animation = NULL;
+    sprite->srcRect = (Rect){0,0,0,0};
+    sprite->uv = (SDL_FRect){0,0,1,1};
+    sprite->layer = 0;
+    sprite->position = (Vector2F){0,0};
+    sprite->previousPosition = sprite->position;
+    sprite->interpolated = false;
+    sprite->isStatic = false;
+    sprite->visibleFrame = 0;
+    sprite->viewMask = 0;
+    sprite->angle = 0.0f;
+    sprite->scale = (Vector2F){1, 1};
     entity->sprite = sprite;
     entity->componentFlags |= SPRITE_COMPONENT;
 }
@@ -92,6 +111,23 @@ void NDL_AddColliderComponent(NDL_Entity* entity, Vector2 size, NDL_Color collid
     }
 }
 
+void NDL_AddCircleColliderComponent(NDL_Entity* entity, float radius, NDL_Color colliderColor)
+{
+    int diameter = (int)ceilf(radius * 2.0f);
+    NDL_AddColliderComponent(entity, (Vector2){diameter, diameter}, colliderColor);
+    if (entity->collider == NULL) return;
+    entity->collider->shape = CIRCLE_COLLIDER;
+    entity->collider->radius = radius;
+}
+
+void NDL_AddCapsuleColliderComponent(NDL_Entity* entity, Vector2 size, NDL_Color colliderColor)
+{
+    NDL_AddColliderComponent(entity, size, colliderColor);
+    if (entity->collider == NULL) return;
+    entity->collider->shape = CAPSULE_COLLIDER;
+    entity->collider->radius = (size.x < size.y ? size.x : size.y) / 2.0f;
+}
+
 void NDL_RemComponent(NDL_Entity* e, Components component)
 {
     e->componentFlags &= ~component;
@@ -105,6 +141,9 @@ bool NDL_HasComponent(NDL_Entity* e, Components component)
 void NDL_AddSpriteTexture(Renderer ren, NDL_Entity* e, const char* fp)
 {
     e->sprite->image = NDL_CreateTexture(ren, fp);
+    // The whole new texture is drawn, not a region left over from NDL_SetSpriteRegion
+    e->sprite->srcRect = (Rect){0,0,0,0};
+    e->sprite->uv = (SDL_FRect){0,0,1,1};
     if (e->sprite->image == NULL)
     {
         printf("Error creating texture!\n");
@@ -112,6 +151,56 @@ void NDL_AddSpriteTexture(Renderer ren, NDL_Entity* e, const char* fp)
     }
 }
 
+void NDL_AddSpriteTextureAtlas(NDL_Atlas* atlas, NDL_Entity* e, const char* fp)
+{
+    NDL_AtlasRegion region;
+    if (!NDL_AtlasAddImage(atlas, fp, &region))
+    {
+        printf("Error adding texture to atlas!\n");
+        return;
+    }
+    NDL_SetSpriteRegion(e->sprite, &region);
+}
+
+void NDL_SetSpriteRegion(NDL_SpriteComponent* sprite, const NDL_AtlasRegion* region)
+{
+    sprite->image = region->texture;
+    sprite->srcRect = region->src;
+    sprite->uv = region->uv;
+}
+
+void NDL_SetSpriteLayer(NDL_Entity* e, Uint8 layer)
+{
+    e->sprite->layer = layer;
+}
+
+void NDL_SetSpriteStatic(NDL_Entity* e, bool isStatic)
+{
+    e->sprite->isStatic = isStatic;
+}
+
+void NDL_AddSpriteTextureMask(Renderer ren, NDL_Entity* e, const char* fp, Uint8 alphaThreshold)
+{
+    NDL_Surface* surface = IMG_Load(fp);
+    if (surface == NULL)
+    {
+        printf("Error loading image for collision mask!\n%s\n", IMG_GetError());
+        return;
+    }
+    // Build the mask from the same pixels the texture is created from, so the file is read once
+    e->sprite->image = SDL_CreateTextureFromSurface(ren, surface);
+    e->sprite->srcRect = (Rect){0,0,0,0};
+    e->sprite->uv = (SDL_FRect){0,0,1,1};
+    if (e->sprite->image == NULL) printf("Error creating texture!\n");
+    if (NDL_HasComponent(e, COLLIDER_COMPONENT))
+    {
+        e->collider->mask = NDL_CreateCollisionMask(surface, alphaThreshold);
+    } else {
+        printf("Error adding collision mask, entity has no collider component!\n");
+    }
+    SDL_FreeSurface(surface);
+}
+
 void NDL_SetEntityTag(NDL_Entity* entity, const char* tag)
 {
     entity->tag = tag;
@@ -122,6 +211,11 @@ void NDL_SetEntityDynamic(NDL_Entity* entity, bool set)
     entity->isDynamic = set;
 }
 
+void NDL_SetEntitySleeping(NDL_Entity* entity, bool sleeping)
+{
+    entity->isSleeping = sleeping;
+}
+
 void NDL_SetEntityMass(NDL_Entity* e, float mass)
 {
     e->collider->mass = mass;
@@ -146,6 +240,22 @@ void NDL_RemColliderComponent(NDL_Entity* entity)
 
 void NDL_UpdateSystem(NDL_RenderSystem* renSys, NDL_PhysicsSystem* physicsSystem, float deltaTime, int UPF)
 {
+    NDL_PhysicsStats* stats = &physicsSystem->stats;
+    memset(stats, 0, sizeof(NDL_PhysicsStats));
+    Uint64 stepStart = SDL_GetPerformanceCounter();
+    // Per-entity stage timing reads the counter several times per body, so it is opt-in
+    bool profile = physicsSystem->profileStages;
+
+    if (physicsSystem->reorderInterval > 0 && ++physicsSystem->framesSinceReorder >= physicsSystem->reorderInterval)
+    {
+        Uint64 start = SDL_GetPerformanceCounter();
+        NDL_ReorderPhysicsGrid(physicsSystem->gridSpace);
+        physicsSystem->framesSinceReorder = 0;
+        stats->reorderMs = NDL_GetElapsedMs(start);
+    }
+    NDL_SamplePhysicsGridOccupancy_P(physicsSystem->gridSpace, stats);
+
+    double positionsMs = 0.0;
     for (int i = 0; i < physicsSystem->gridSpace->r; ++i)   // rows
     {
         for (int j = 0; j < physicsSystem->gridSpace->c; ++j)   // cols
@@ -155,20 +265,98 @@ void NDL_UpdateSystem(NDL_RenderSystem* renSys, NDL_PhysicsSystem* physicsSystem
             for (int e = 0; e < cell.pool->size; ++e)
             {
                 NDL_Entity* entity = cell.pool->entities[e];
+                if (entity->isSleeping)
+                {
+                    // Keeps a body that fell asleep mid-motion from being drawn between two ticks
+                    NDL_SyncSpriteTransform(entity);
+                    ++stats->sleepingBodies;
+                    continue;
+                }
                 if (NDL_HasComponent(entity, COLLIDER_COMPONENT))
                 {
                     entity->collider->velocity = entity->velocity;
                     if (entity->isDynamic)
                     {
+                        Uint64 start = profile ? SDL_GetPerformanceCounter() : 0;
                         physicsSystem->handleForces(entity, physicsSystem);
-
+                        if (profile) stats->forcesMs += NDL_GetElapsedMs(start);
                     }
                 }
+                Uint64 start = profile ? SDL_GetPerformanceCounter() : 0;
                 physicsSystem->handlePositions(physicsSystem, entity, deltaTime, UPF);
+                if (profile) positionsMs += NDL_GetElapsedMs(start);
+                ++stats->bodiesIntegrated;
+                NDL_SyncSpriteTransform(entity);
             }
         }
 
     }
+    // Bodies have moved; a render cull query rebins before trusting the cells
+    physicsSystem->gridSpace->binsStale = true;
+    // The narrowphase runs inside handlePositions and times itself
+    if (profile) stats->integrateMs = positionsMs - stats->collisionMs;
+    stats->totalMs = NDL_GetElapsedMs(stepStart);
+}
+
+void NDL_SyncSpriteTransform(NDL_Entity* entity)
+{
+    if (!NDL_HasComponent(entity, SPRITE_COMPONENT)) return;
+    NDL_SpriteComponent* sprite = entity->sprite;
+    sprite->previousPosition = sprite->position;
+    sprite->position = entity->position;
+    sprite->imageRect.x = entity->position.x;
+    sprite->imageRect.y = entity->position.y;
+    sprite->interpolated = true;
+}
+
+void NDL_SnapSpriteTransform(NDL_Entity* entity)
+{
+    if (!NDL_HasComponent(entity, SPRITE_COMPONENT)) return;
+    NDL_SyncSpriteTransform(entity);
+    entity->sprite->previousPosition = entity->sprite->position;
+}
+
+void NDL_SetSpritePosition(NDL_SpriteComponent* sprite, Vector2F position)
+{
+    sprite->position = position;
+    sprite->previousPosition = position;
+    sprite->imageRect.x = position.x;
+    sprite->imageRect.y = position.y;
+    sprite->interpolated = true;
+}
+
+int NDL_StepPhysicsFixed(NDL_RenderSystem* renSys, NDL_PhysicsSystem* physicsSystem, float deltaTime, int UPF)
+{
+    physicsSystem->accumulator += deltaTime;
+    int steps = 0;
+    while (physicsSystem->accumulator >= physicsSystem->fixedStep)
+    {
+        if (steps == physicsSystem->maxStepsPerFrame)
+        {
+            physicsSystem->accumulator = 0.0f;
+            break;
+        }
+        NDL_UpdateSystem(renSys, physicsSystem, physicsSystem->fixedStep, UPF);
+        physicsSystem->accumulator -= physicsSystem->fixedStep;
+        ++steps;
+    }
+    renSys->interpolationAlpha = physicsSystem->accumulator / physicsSystem->fixedStep;
+    return steps;
+}
+
+NDL_PhysicsStats NDL_GetPhysicsStats(NDL_PhysicsSystem* phys)
+{
+    return phys->stats;
+}
+
+void NDL_PrintPhysicsStats(NDL_PhysicsSystem* phys)
+{
+    NDL_PhysicsStats* s = &phys->stats;
+    printf("Physics: %d integrated, %d sleeping | %d pairs, %d tests, %d contacts, %d mask overlaps | cells %d used, max %d, avg %.2f\n",
+           s->bodiesIntegrated, s->sleepingBodies, s->broadphasePairs, s->narrowphaseTests, s->contactsResolved, s->maskOverlaps,
+           s->occupiedCells, s->maxCellOccupancy, s->avgCellOccupancy);
+    printf("Physics: reorder %.3fms, forces %.3fms, integrate %.3fms, collision %.3fms, total %.3fms\n",
+           s->reorderMs, s->forcesMs, s->integrateMs, s->collisionMs, s->totalMs);
 }
 
 void NDL_SetPhysicsSystemGravity(NDL_PhysicsSystem* phys, float gravity)
@@ -186,6 +374,24 @@ void NDL_SetPhysicsSystemFrictionY(NDL_PhysicsSystem* phys, float frictionY)
     phys->friction.x = frictionY;
 }
 
+void NDL_SetPhysicsSystemReorderInterval(NDL_PhysicsSystem* phys, int frames)
+{
+    phys->reorderInterval = frames;
+    phys->framesSinceReorder = 0;
+}
+
+void NDL_SetPhysicsSystemProfiling(NDL_PhysicsSystem* phys, bool profileStages)
+{
+    phys->profileStages = profileStages;
+    phys->gridSpace->profileStages = profileStages;
+}
+
+void NDL_SetPhysicsSystemTickRate(NDL_PhysicsSystem* phys, float ticksPerSecond)
+{
+    phys->fixedStep = 1.0f / ticksPerSecond;
+    phys->accumulator = 0.0f;
+}
+
 bool NDL_EnablePhysicsSystemFrictionX(NDL_PhysicsSystem* phys, bool frictionX)
 {
     phys->frictionX = frictionX;
@@ -224,6 +430,69 @@ void NDL_SetRenderSystemClearColor(NDL_RenderSystem* renSys, NDL_Color clearColo
     renSys->clearColor = clearColor;
 }
 
+void NDL_SetRenderSystemBatching(NDL_RenderSystem* renSys, bool useBatching)
+{
+    renSys->useBatching = useBatching;
+}
+
+int NDL_GetRenderSystemDrawCalls(NDL_RenderSystem* renSys)
+{
+    return renSys->drawCalls;
+}
+
+void NDL_SetRenderSystemYSort(NDL_RenderSystem* renSys, bool ySort)
+{
+    renSys->queue->ySort = ySort;
+}
+
+void NDL_SetRenderSystemCamera(NDL_RenderSystem* renSys, NDL_Camera* camera)
+{
+    renSys->camera = camera;
+}
+
+void NDL_SetRenderSystemCullGrid(NDL_RenderSystem* renSys, NDL_PhysicsGrid* grid)
+{
+    renSys->cullGrid = grid;
+}
+
+void NDL_SetRenderSystemTilemap(NDL_RenderSystem* renSys, NDL_Tilemap* tilemap)
+{
+    renSys->tilemap = tilemap;
+}
+
+void NDL_SetRenderSystemStaticCaching(NDL_RenderSystem* renSys, bool enable)
+{
+    if (enable && renSys->staticLayer == NULL)
+    {
+        renSys->staticLayer = NDL_CreateStaticLayer();
+    } else if (!enable && renSys->staticLayer != NULL) {
+        NDL_DestroyStaticLayer(renSys->staticLayer);
+        renSys->staticLayer = NULL;
+    }
+}
+
+void NDL_SetRenderSystemScheduler(NDL_RenderSystem* renSys, NDL_FrameScheduler* scheduler)
+{
+    renSys->scheduler = scheduler;
+}
+
+void NDL_SetRenderSystemThreading(NDL_RenderSystem* renSys, bool enable, NDL_ThreadPool* pool)
+{
+    if (renSys->recorder != NULL)
+    {
+        NDL_DestroyRenderRecorder(renSys->recorder);
+        renSys->recorder = NULL;
+    }
+    if (enable) renSys->recorder = NDL_CreateRenderRecorder(pool);
+}
+
+void NDL_SetRenderSystemSoftRenderer(NDL_RenderSystem* renSys, NDL_SoftRenderer* soft)
+{
+    renSys->soft = soft;
+    renSys->batch->soft = soft;
+    renSys->primitives->soft = soft;
+}
+
 /*
  * Function: NDL_Test
  * ----------------------------
@@ -407,6 +676,16 @@ void NDL_AddAnimationComponent(NDL_Entity *entity, NDL_ImageSet* images, bool lo
     anim->currentFrame = 0;
     anim->flipRate = flipRate;
     anim->flip = NDL_AnimationFlip;
+    anim->time = 0.0f;
+    anim->rate = (float)flipRate;
+    anim->mode = loop ? ANIMATION_LOOP : ANIMATION_ONCE;
+    anim->direction = 1;
+    anim->finished = false;
+    anim->eventFrames = 0;
+    anim->onEvent = NULL;
+    anim->clock = NULL;
+    anim->system = NULL;
+    anim->slot = -1;
     entity->sprite->animation = anim;
     entity->componentFlags |= ANIMATION_COMPONENT;
 }
@@ -415,5 +694,291 @@ void NDL_SetAnimationImageSet(NDL_ImageSet* imageSet, NDL_AnimationComponent* an
 {
     anim->imageSet = imageSet;
     if (anim->imageSet == NULL) printf("Error adding image set to animation!\n");
+    if (anim->system != NULL && anim->imageSet != NULL) anim->system->frameCount[anim->slot] = anim->imageSet->imageCount;
+}
+
+void NDL_SetAnimationRate(NDL_AnimationComponent* anim, float framesPerSecond)
+{
+    anim->rate = framesPerSecond;
+    anim->flipRate = (int)framesPerSecond;
+    if (anim->system != NULL) anim->system->frameDuration[anim->slot] = 1.0f / framesPerSecond;
+}
+
+void NDL_SetAnimationMode(NDL_AnimationComponent* anim, NDL_ANIMATION_MODES mode)
+{
+    anim->mode = mode;
+    anim->loop = mode != ANIMATION_ONCE;
+    if (anim->system != NULL) anim->system->mode[anim->slot] = (Uint8)mode;
+}
+
+void NDL_SetAnimationEvents(NDL_AnimationComponent* anim, Uint64 eventFrames, AnimEventMethod onEvent)
+{
+    anim->eventFrames = eventFrames;
+    anim->onEvent = onEvent;
+}
+
+void NDL_SetAnimationClock(NDL_AnimationComponent* anim, NDL_AnimationClock* clock)
+{
+    anim->clock = clock;
+    if (anim->system != NULL) anim->system->clocks[anim->slot] = clock;
+}
+
+void NDL_RestartAnimation(NDL_AnimationComponent* anim)
+{
+    anim->time = 0.0f;
+    anim->currentFrame = 0;
+    anim->direction = 1;
+    anim->finished = false;
+    if (anim->system != NULL)
+    {
+        anim->system->time[anim->slot] = 0.0f;
+        anim->system->frame[anim->slot] = 0;
+        anim->system->direction[anim->slot] = 1;
+    }
+}
+
+
+void NDL_AddTransformComponent(NDL_Entity* entity)
+{
+    NDL_TransformComponent* t = malloc(sizeof(NDL_TransformComponent));
+    t->entity = entity;
+    t->parent = NULL;
+    t->localPosition = entity->position;
+    t->localRotation = 0.0f;
+    t->localScale = (Vector2F){1, 1};
+    t->worldPosition = entity->position;
+    t->worldCentre = entity->position;
+    t->worldRotation = 0.0f;
+    t->worldScale = (Vector2F){1, 1};
+    t->lag = (Vector2F){0, 0};
+    t->depth = 0;
+    t->dirty = true;
+    t->changed = false;
+    t->system = NULL;
+    entity->transform = t;
+    entity->componentFlags |= TRANSFORM_COMPONENT;
 }
 
+NDL_TransformSystem* NDL_CreateTransformSystem(int capacity)
+{
+    NDL_TransformSystem* system = malloc(sizeof(NDL_TransformSystem));
+    system->count = 0;
+    system->capacity = capacity > 0 ? capacity : 64;
+    system->order = malloc(sizeof(NDL_TransformComponent*)*system->capacity);
+    system->rootCount = 0;
+    system->orderDirty = false;
+    system->dirtyCount = 0;
+    system->updated = 0;
+    return system;
+}
+
+void NDL_DestroyTransformSystem(NDL_TransformSystem* system)
+{
+    for (int i = 0; i < system->count; ++i) system->order[i]->system = NULL;
+    free(system->order);
+    free(system);
+}
+
+void NDL_AddToTransformSystem(NDL_TransformSystem* system, NDL_Entity* e)
+{
+    if (!NDL_HasComponent(e, TRANSFORM_COMPONENT))
+    {
+        printf("Entity has no transform component!\n");
+        return;
+    }
+    NDL_TransformComponent* t = e->transform;
+    if (t->system != NULL) return;
+    if (system->count == system->capacity)
+    {
+        system->capacity *= 2;
+        system->order = realloc(system->order, sizeof(NDL_TransformComponent*)*system->capacity);
+    }
+    system->order[system->count++] = t;
+    t->system = system;
+    t->dirty = true;
+    ++system->dirtyCount;
+    system->orderDirty = true;
+}
+
+void NDL_RemoveFromTransformSystem(NDL_TransformSystem* system, NDL_Entity* e)
+{
+    NDL_TransformComponent* t = e->transform;
+    if (t == NULL || t->system != system) return;
+    // Children stay where they are, as roots
+    for (int i = 0; i < system->count; ++i)
+    {
+        NDL_TransformComponent* child = system->order[i];
+        if (child->parent != t) continue;
+        child->parent = NULL;
+        child->localPosition = child->worldPosition;
+        child->localRotation = child->worldRotation;
+        child->localScale = child->worldScale;
+    }
+    for (int i = 0; i < system->count; ++i)
+    {
+        if (system->order[i] != t) continue;
+        system->order[i] = system->order[--system->count];
+        break;
+    }
+    t->parent = NULL;
+    t->system = NULL;
+    system->orderDirty = true;
+}
+
+void NDL_SetTransformParent(NDL_Entity* e, NDL_Entity* parent)
+{
+    NDL_TransformComponent* t = e->transform;
+    NDL_TransformComponent* p = parent != NULL ? parent->transform : NULL;
+    if (parent != NULL && (p == NULL || p->system != t->system))
+    {
+        printf("Parent must have a transform in the same transform system!\n");
+        return;
+    }
+    for (NDL_TransformComponent* up = p; up != NULL; up = up->parent)
+    {
+        if (up == t)
+        {
+            printf("Transform parent would form a cycle!\n");
+            return;
+        }
+    }
+    t->parent = p;
+    t->dirty = true;
+    if (t->system != NULL)
+    {
+        ++t->system->dirtyCount;
+        t->system->orderDirty = true;
+    }
+}
+
+static void NDL_MarkTransformDirty_C(NDL_TransformComponent* t)
+{
+    if (t->dirty) return;
+    t->dirty = true;
+    if (t->system != NULL) ++t->system->dirtyCount;
+}
+
+void NDL_SetTransformPosition(NDL_Entity* e, float x, float y)
+{
+    NDL_TransformComponent* t = e->transform;
+    t->localPosition = (Vector2F){x, y};
+    if (t->parent == NULL)
+    {
+        e->position = t->localPosition;
+        NDL_SnapSpriteTransform(e);
+    }
+    NDL_MarkTransformDirty_C(t);
+}
+
+void NDL_SetTransformRotation(NDL_Entity* e, float degrees)
+{
+    e->transform->localRotation = degrees;
+    NDL_MarkTransformDirty_C(e->transform);
+}
+
+void NDL_SetTransformScale(NDL_Entity* e, float scaleX, float scaleY)
+{
+    e->transform->localScale = (Vector2F){scaleX, scaleY};
+    NDL_MarkTransformDirty_C(e->transform);
+}
+
+void NDL_UpdateTransformSystem(NDL_TransformSystem* system)
+{
+    system->updated = 0;
+    if (system->orderDirty)
+    {
+        // Structural changes are rare: recount depths and counting-sort by them
+        int maxDepth = 0;
+        for (int i = 0; i < system->count; ++i)
+        {
+            NDL_TransformComponent* t = system->order[i];
+            t->depth = 0;
+            for (NDL_TransformComponent* up = t->parent; up != NULL; up = up->parent) ++t->depth;
+            if (t->depth > maxDepth) maxDepth = t->depth;
+        }
+        int* start = calloc(maxDepth + 2, sizeof(int));
+        NDL_TransformComponent** sorted = malloc(sizeof(NDL_TransformComponent*)*(system->count > 0 ? system->count : 1));
+        for (int i = 0; i < system->count; ++i) ++start[system->order[i]->depth + 1];
+        for (int d = 1; d <= maxDepth + 1; ++d) start[d] += start[d - 1];
+        system->rootCount = system->count > 0 ? start[1] : 0;
+        for (int i = 0; i < system->count; ++i) sorted[start[system->order[i]->depth]++] = system->order[i];
+        memcpy(system->order, sorted, sizeof(NDL_TransformComponent*)*system->count);
+        free(sorted);
+        free(start);
+        system->orderDirty = false;
+    }
+
+    // Roots follow their entities, which physics may have moved
+    for (int i = 0; i < system->rootCount; ++i)
+    {
+        NDL_TransformComponent* t = system->order[i];
+        NDL_Entity* e = t->entity;
+        Vector2F lag = {0, 0};
+        if (NDL_HasComponent(e, SPRITE_COMPONENT))
+        {
+            lag.x = e->sprite->previousPosition.x - e->sprite->position.x;
+            lag.y = e->sprite->previousPosition.y - e->sprite->position.y;
+        }
+        if (e->position.x != t->localPosition.x || e->position.y != t->localPosition.y ||
+            lag.x != t->lag.x || lag.y != t->lag.y)
+        {
+            t->localPosition = e->position;
+            t->lag = lag;
+            NDL_MarkTransformDirty_C(t);
+        }
+    }
+    if (system->dirtyCount == 0) return;
+
+    for (int i = 0; i < system->count; ++i)
+    {
+        NDL_TransformComponent* t = system->order[i];
+        NDL_TransformComponent* p = t->parent;
+        t->changed = t->dirty || (p != NULL && p->changed);
+        if (!t->changed) continue;
+        t->dirty = false;
+        ++system->updated;
+
+        NDL_Entity* e = t->entity;
+        NDL_SpriteComponent* sprite = NDL_HasComponent(e, SPRITE_COMPONENT) ? e->sprite : NULL;
+        Vector2F half = {0, 0};
+        if (sprite != NULL) half = (Vector2F){sprite->imageRect.w*0.5f, sprite->imageRect.h*0.5f};
+        if (p == NULL)
+        {
+            t->worldRotation = t->localRotation;
+            t->worldScale = t->localScale;
+            t->worldPosition = t->localPosition;
+            t->worldCentre = (Vector2F){t->worldPosition.x + half.x*t->worldScale.x, t->worldPosition.y + half.y*t->worldScale.y};
+        }
+        else
+        {
+            // The child's centre is rotated and scaled about the parent's centre
+            Vector2F parentHalf = {0, 0};
+            if (NDL_HasComponent(p->entity, SPRITE_COMPONENT)) parentHalf = (Vector2F){p->entity->sprite->imageRect.w*0.5f, p->entity->sprite->imageRect.h*0.5f};
+            float ox = (t->localPosition.x + half.x - parentHalf.x)*p->worldScale.x;
+            float oy = (t->localPosition.y + half.y - parentHalf.y)*p->worldScale.y;
+            float r = p->worldRotation*(3.1415927f/180.0f);
+            float c = cosf(r);
+            float s = sinf(r);
+            t->worldRotation = p->worldRotation + t->localRotation;
+            t->worldScale = (Vector2F){p->worldScale.x*t->localScale.x, p->worldScale.y*t->localScale.y};
+            t->worldCentre = (Vector2F){p->worldCentre.x + ox*c - oy*s, p->worldCentre.y + ox*s + oy*c};
+            t->worldPosition = (Vector2F){t->worldCentre.x - half.x*t->worldScale.x, t->worldCentre.y - half.y*t->worldScale.y};
+            t->lag = p->lag;
+            e->position = t->worldPosition;
+        }
+        if (sprite != NULL)
+        {
+            sprite->angle = t->worldRotation;
+            sprite->scale = t->worldScale;
+            if (p != NULL)
+            {
+                sprite->position = t->worldPosition;
+                sprite->imageRect.x = t->worldPosition.x;
+                sprite->imageRect.y = t->worldPosition.y;
+                sprite->previousPosition = (Vector2F){t->worldPosition.x + t->lag.x, t->worldPosition.y + t->lag.y};
+                sprite->interpolated = true;
+            }
+        }
+    }
+    system->dirtyCount = 0;
+}
@@ -17,8 +17,18 @@ NDL_PhysicsGrid* NDL_CreatePhysicsGrid(int w, int h, int nRows, int nCols, int c
         for (int j = 0; j < pGrid->c; ++j)
         {
             pGrid->cells[i][j].pool = NDL_CreatePool(cellCapacity);
+            pGrid->cells[i][j].bodies = malloc(sizeof(NDL_CellBody)*cellCapacity);
         }
     }
+    pGrid->circleCircle = NDL_CreateShapePairs_P(cellCapacity);
+    pGrid->circleBox = NDL_CreateShapePairs_P(cellCapacity);
+    pGrid->circleCapsule = NDL_CreateShapePairs_P(cellCapacity);
+    pGrid->capsuleBox = NDL_CreateShapePairs_P(cellCapacity);
+    pGrid->capsuleCapsule = NDL_CreateShapePairs_P(cellCapacity);
+    pGrid->stats = NULL;
+    pGrid->profileStages = false;
+    pGrid->maxExtent = 0.0f;
+    pGrid->binsStale = false;
     
     return pGrid;
 }
@@ -131,27 +141,710 @@ NDL_CollisionData NDL_GenerateCollisionInfo_P(NDL_Entity* ent1, NDL_Entity* ent2
     return info;
 }
 
+NDL_ShapePairs* NDL_CreateShapePairs_P(int capacity)
+{
+    NDL_ShapePairs* pairs = malloc(sizeof(NDL_ShapePairs));
+    memset(pairs, 0, sizeof(NDL_ShapePairs));
+    NDL_ReserveShapePairs_P(pairs, capacity > 0 ? capacity : 16);
+    return pairs;
+}
+
+void NDL_ReserveShapePairs_P(NDL_ShapePairs* pairs, int capacity)
+{
+    if (capacity <= pairs->capacity) return;
+    // Keep every lane a multiple of 4 long so the SIMD kernels never read past the end
+    capacity = (capacity + 3) & ~3;
+    float** lanes[] = {
+        &pairs->ax, &pairs->ay, &pairs->ax2, &pairs->ay2, &pairs->ar,
+        &pairs->bx, &pairs->by, &pairs->bx2, &pairs->by2, &pairs->br,
+        &pairs->nx, &pairs->ny, &pairs->depth
+    };
+    for (int i = 0; i < (int)(sizeof(lanes)/sizeof(lanes[0])); ++i)
+    {
+        *lanes[i] = realloc(*lanes[i], sizeof(float)*capacity);
+    }
+    pairs->a = realloc(pairs->a, sizeof(NDL_Entity*)*capacity);
+    pairs->b = realloc(pairs->b, sizeof(NDL_Entity*)*capacity);
+    pairs->capacity = capacity;
+}
+
+void NDL_ClearShapePairs_P(NDL_ShapePairs* pairs)
+{
+    pairs->count = 0;
+}
+
+static void NDL_GetCapsuleSegment_P(NDL_ColliderComponent* collider, float* x1, float* y1, float* x2, float* y2)
+{
+    float rad = collider->radius;
+    if (collider->r.w >= collider->r.h)
+    {
+        *y1 = *y2 = collider->r.y + collider->r.h / 2.0f;
+        *x1 = collider->r.x + rad;
+        *x2 = collider->r.x + collider->r.w - rad;
+    } else {
+        *x1 = *x2 = collider->r.x + collider->r.w / 2.0f;
+        *y1 = collider->r.y + rad;
+        *y2 = collider->r.y + collider->r.h - rad;
+    }
+}
+
+static void NDL_GetShapeLanes_P(NDL_ColliderComponent* collider, float* x, float* y, float* x2, float* y2, float* r)
+{
+    switch (collider->shape)
+    {
+        case CIRCLE_COLLIDER:
+            *x = *x2 = collider->r.x + collider->radius;
+            *y = *y2 = collider->r.y + collider->radius;
+            *r = collider->radius;
+            break;
+        case CAPSULE_COLLIDER:
+            NDL_GetCapsuleSegment_P(collider, x, y, x2, y2);
+            *r = collider->radius;
+            break;
+        default:
+            *x = collider->r.x;
+            *y = collider->r.y;
+            *x2 = collider->r.x + collider->r.w;
+            *y2 = collider->r.y + collider->r.h;
+            *r = 0.0f;
+            break;
+    }
+}
+
+int NDL_PushShapePair_P(NDL_ShapePairs* pairs, NDL_Entity* a, NDL_Entity* b)
+{
+    if (pairs->count >= pairs->capacity) NDL_ReserveShapePairs_P(pairs, pairs->capacity*2);
+    int i = pairs->count++;
+    pairs->a[i] = a;
+    pairs->b[i] = b;
+    NDL_GetShapeLanes_P(a->collider, &pairs->ax[i], &pairs->ay[i], &pairs->ax2[i], &pairs->ay2[i], &pairs->ar[i]);
+    NDL_GetShapeLanes_P(b->collider, &pairs->bx[i], &pairs->by[i], &pairs->bx2[i], &pairs->by2[i], &pairs->br[i]);
+    pairs->depth[i] = 0.0f;
+    return i;
+}
+
+/*
+ * Scalar narrowphase lanes
+ * These are the reference implementations, and they also handle the tail of each batch
+ * that does not fill a whole SIMD register.
+ */
+static float NDL_Clampf_P(float v, float lo, float hi)
+{
+    return v < lo ? lo : (v > hi ? hi : v);
+}
+
+static void NDL_ClosestOnSegment_P(float px, float py, float x1, float y1, float x2, float y2, float* qx, float* qy)
+{
+    float ex = x2 - x1;
+    float ey = y2 - y1;
+    float len2 = ex*ex + ey*ey;
+    float t = len2 > 1e-6f ? ((px - x1)*ex + (py - y1)*ey) / len2 : 0.0f;
+    t = NDL_Clampf_P(t, 0.0f, 1.0f);
+    *qx = x1 + ex*t;
+    *qy = y1 + ey*t;
+}
+
+static void NDL_PointPointLane_P(float ax, float ay, float bx, float by, float radii, float* nx, float* ny, float* depth)
+{
+    float dx = ax - bx;
+    float dy = ay - by;
+    float d = sqrtf(dx*dx + dy*dy);
+    if (d > 1e-6f)
+    {
+        *nx = dx / d;
+        *ny = dy / d;
+    } else {
+        *nx = 0.0f;
+        *ny = -1.0f;
+    }
+    *depth = radii - d;
+}
+
+static void NDL_CircleBoxLane_P(float px, float py, float r, float minX, float minY, float maxX, float maxY, float* nx, float* ny, float* depth)
+{
+    float dx = px - NDL_Clampf_P(px, minX, maxX);
+    float dy = py - NDL_Clampf_P(py, minY, maxY);
+    float d2 = dx*dx + dy*dy;
+    if (d2 > 1e-12f)
+    {
+        float d = sqrtf(d2);
+        *nx = dx / d;
+        *ny = dy / d;
+        *depth = r - d;
+        return;
+    }
+    // Centre inside the box, push out through the nearest face
+    float best = px - minX;
+    *nx = -1.0f; *ny = 0.0f;
+    if (maxX - px < best) { best = maxX - px; *nx = 1.0f; *ny = 0.0f; }
+    if (py - minY < best) { best = py - minY; *nx = 0.0f; *ny = -1.0f; }
+    if (maxY - py < best) { best = maxY - py; *nx = 0.0f; *ny = 1.0f; }
+    *depth = r + best;
+}
+
+static void NDL_CapsuleBoxLane_P(NDL_ShapePairs* p, int i)
+{
+    // Alternate between the closest point on the segment and the closest point in the box;
+    // two rounds settle on the exact contact for a segment against an axis-aligned box.
+    float sx, sy;
+    NDL_ClosestOnSegment_P((p->bx[i] + p->bx2[i]) * 0.5f, (p->by[i] + p->by2[i]) * 0.5f, p->ax[i], p->ay[i], p->ax2[i], p->ay2[i], &sx, &sy);
+    for (int round = 0; round < 2; ++round)
+    {
+        float qx = NDL_Clampf_P(sx, p->bx[i], p->bx2[i]);
+        float qy = NDL_Clampf_P(sy, p->by[i], p->by2[i]);
+        NDL_ClosestOnSegment_P(qx, qy, p->ax[i], p->ay[i], p->ax2[i], p->ay2[i], &sx, &sy);
+    }
+    NDL_CircleBoxLane_P(sx, sy, p->ar[i], p->bx[i], p->by[i], p->bx2[i], p->by2[i], &p->nx[i], &p->ny[i], &p->depth[i]);
+}
+
+#ifdef NDL_SIMD_X86
+
+NDL_TARGET_SSE2 static inline __m128 NDL_Select4_P(__m128 mask, __m128 a, __m128 b)
+{
+    return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+
+NDL_TARGET_SSE2 static inline __m128 NDL_Clamp4_P(__m128 v, __m128 lo, __m128 hi)
+{
+    return _mm_min_ps(_mm_max_ps(v, lo), hi);
+}
+
+NDL_TARGET_SSE2 static inline void NDL_ClosestOnSegment4_P(__m128 px, __m128 py, __m128 x1, __m128 y1, __m128 x2, __m128 y2, __m128* qx, __m128* qy)
+{
+    __m128 ex = _mm_sub_ps(x2, x1);
+    __m128 ey = _mm_sub_ps(y2, y1);
+    __m128 len2 = _mm_max_ps(_mm_add_ps(_mm_mul_ps(ex, ex), _mm_mul_ps(ey, ey)), _mm_set1_ps(1e-6f));
+    __m128 t = _mm_add_ps(_mm_mul_ps(_mm_sub_ps(px, x1), ex), _mm_mul_ps(_mm_sub_ps(py, y1), ey));
+    t = NDL_Clamp4_P(_mm_div_ps(t, len2), _mm_setzero_ps(), _mm_set1_ps(1.0f));
+    *qx = _mm_add_ps(x1, _mm_mul_ps(ex, t));
+    *qy = _mm_add_ps(y1, _mm_mul_ps(ey, t));
+}
+
+NDL_TARGET_SSE2 static inline void NDL_PointPoint4_P(NDL_ShapePairs* p, int i, __m128 ax, __m128 ay, __m128 bx, __m128 by, __m128 radii)
+{
+    __m128 dx = _mm_sub_ps(ax, bx);
+    __m128 dy = _mm_sub_ps(ay, by);
+    __m128 d = _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)));
+    __m128 valid = _mm_cmpgt_ps(d, _mm_set1_ps(1e-6f));
+    __m128 inv = _mm_div_ps(_mm_set1_ps(1.0f), _mm_max_ps(d, _mm_set1_ps(1e-6f)));
+    _mm_storeu_ps(&p->nx[i], _mm_and_ps(valid, _mm_mul_ps(dx, inv)));
+    _mm_storeu_ps(&p->ny[i], NDL_Select4_P(valid, _mm_mul_ps(dy, inv), _mm_set1_ps(-1.0f)));
+    _mm_storeu_ps(&p->depth[i], _mm_sub_ps(radii, d));
+}
+
+NDL_TARGET_SSE2 static inline void NDL_CircleBox4_P(NDL_ShapePairs* p, int i, __m128 px, __m128 py, __m128 r)
+{
+    __m128 minX = _mm_loadu_ps(&p->bx[i]);
+    __m128 minY = _mm_loadu_ps(&p->by[i]);
+    __m128 maxX = _mm_loadu_ps(&p->bx2[i]);
+    __m128 maxY = _mm_loadu_ps(&p->by2[i]);
+
+    __m128 dx = _mm_sub_ps(px, NDL_Clamp4_P(px, minX, maxX));
+    __m128 dy = _mm_sub_ps(py, NDL_Clamp4_P(py, minY, maxY));
+    __m128 d2 = _mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy));
+    __m128 outside = _mm_cmpgt_ps(d2, _mm_set1_ps(1e-12f));
+    __m128 d = _mm_sqrt_ps(d2);
+    __m128 inv = _mm_div_ps(_mm_set1_ps(1.0f), _mm_max_ps(d, _mm_set1_ps(1e-6f)));
+
+    // Centre inside the box, push out through the nearest face
+    __m128 one = _mm_set1_ps(1.0f);
+    __m128 zero = _mm_setzero_ps();
+    __m128 best = _mm_sub_ps(px, minX);
+    __m128 inNx = _mm_set1_ps(-1.0f);
+    __m128 inNy = zero;
+    __m128 face = _mm_sub_ps(maxX, px);
+    __m128 closer = _mm_cmplt_ps(face, best);
+    best = NDL_Select4_P(closer, face, best);
+    inNx = NDL_Select4_P(closer, one, inNx);
+    face = _mm_sub_ps(py, minY);
+    closer = _mm_cmplt_ps(face, best);
+    best = NDL_Select4_P(closer, face, best);
+    inNx = NDL_Select4_P(closer, zero, inNx);
+    inNy = NDL_Select4_P(closer, _mm_set1_ps(-1.0f), inNy);
+    face = _mm_sub_ps(maxY, py);
+    closer = _mm_cmplt_ps(face, best);
+    best = NDL_Select4_P(closer, face, best);
+    inNx = NDL_Select4_P(closer, zero, inNx);
+    inNy = NDL_Select4_P(closer, one, inNy);
+
+    _mm_storeu_ps(&p->nx[i], NDL_Select4_P(outside, _mm_mul_ps(dx, inv), inNx));
+    _mm_storeu_ps(&p->ny[i], NDL_Select4_P(outside, _mm_mul_ps(dy, inv), inNy));
+    _mm_storeu_ps(&p->depth[i], NDL_Select4_P(outside, _mm_sub_ps(r, d), _mm_add_ps(r, best)));
+}
+
+NDL_TARGET_SSE2 static int NDL_CircleCircleBatch4_P(NDL_ShapePairs* p)
+{
+    int i = 0;
+    for (; i + 4 <= p->count; i += 4)
+    {
+        __m128 radii = _mm_add_ps(_mm_loadu_ps(&p->ar[i]), _mm_loadu_ps(&p->br[i]));
+        NDL_PointPoint4_P(p, i, _mm_loadu_ps(&p->ax[i]), _mm_loadu_ps(&p->ay[i]), _mm_loadu_ps(&p->bx[i]), _mm_loadu_ps(&p->by[i]), radii);
+    }
+    return i;
+}
+
+NDL_TARGET_SSE2 static int NDL_CircleBoxBatch4_P(NDL_ShapePairs* p)
+{
+    int i = 0;
+    for (; i + 4 <= p->count; i += 4)
+    {
+        NDL_CircleBox4_P(p, i, _mm_loadu_ps(&p->ax[i]), _mm_loadu_ps(&p->ay[i]), _mm_loadu_ps(&p->ar[i]));
+    }
+    return i;
+}
+
+NDL_TARGET_SSE2 static int NDL_CircleCapsuleBatch4_P(NDL_ShapePairs* p)
+{
+    int i = 0;
+    for (; i + 4 <= p->count; i += 4)
+    {
+        __m128 ax = _mm_loadu_ps(&p->ax[i]);
+        __m128 ay = _mm_loadu_ps(&p->ay[i]);
+        __m128 qx, qy;
+        NDL_ClosestOnSegment4_P(ax, ay, _mm_loadu_ps(&p->bx[i]), _mm_loadu_ps(&p->by[i]), _mm_loadu_ps(&p->bx2[i]), _mm_loadu_ps(&p->by2[i]), &qx, &qy);
+        __m128 radii = _mm_add_ps(_mm_loadu_ps(&p->ar[i]), _mm_loadu_ps(&p->br[i]));
+        NDL_PointPoint4_P(p, i, ax, ay, qx, qy, radii);
+    }
+    return i;
+}
+
+NDL_TARGET_SSE2 static int NDL_CapsuleBoxBatch4_P(NDL_ShapePairs* p)
+{
+    int i = 0;
+    for (; i + 4 <= p->count; i += 4)
+    {
+        __m128 x1 = _mm_loadu_ps(&p->ax[i]);
+        __m128 y1 = _mm_loadu_ps(&p->ay[i]);
+        __m128 x2 = _mm_loadu_ps(&p->ax2[i]);
+        __m128 y2 = _mm_loadu_ps(&p->ay2[i]);
+        __m128 minX = _mm_loadu_ps(&p->bx[i]);
+        __m128 minY = _mm_loadu_ps(&p->by[i]);
+        __m128 maxX = _mm_loadu_ps(&p->bx2[i]);
+        __m128 maxY = _mm_loadu_ps(&p->by2[i]);
+        __m128 half = _mm_set1_ps(0.5f);
+        __m128 sx, sy;
+        NDL_ClosestOnSegment4_P(_mm_mul_ps(_mm_add_ps(minX, maxX), half), _mm_mul_ps(_mm_add_ps(minY, maxY), half), x1, y1, x2, y2, &sx, &sy);
+        for (int round = 0; round < 2; ++round)
+        {
+            NDL_ClosestOnSegment4_P(NDL_Clamp4_P(sx, minX, maxX), NDL_Clamp4_P(sy, minY, maxY), x1, y1, x2, y2, &sx, &sy);
+        }
+        NDL_CircleBox4_P(p, i, sx, sy, _mm_loadu_ps(&p->ar[i]));
+    }
+    return i;
+}
+#endif
+
+void NDL_CircleCircleBatch_P(NDL_ShapePairs* p)
+{
+    int i = 0;
+#ifdef NDL_SIMD_X86
+    if (NDL_HasSSE2()) i = NDL_CircleCircleBatch4_P(p);
+#endif
+    for (; i < p->count; ++i)
+    {
+        NDL_PointPointLane_P(p->ax[i], p->ay[i], p->bx[i], p->by[i], p->ar[i] + p->br[i], &p->nx[i], &p->ny[i], &p->depth[i]);
+    }
+}
+
+void NDL_CircleBoxBatch_P(NDL_ShapePairs* p)
+{
+    int i = 0;
+#ifdef NDL_SIMD_X86
+    if (NDL_HasSSE2()) i = NDL_CircleBoxBatch4_P(p);
+#endif
+    for (; i < p->count; ++i)
+    {
+        NDL_CircleBoxLane_P(p->ax[i], p->ay[i], p->ar[i], p->bx[i], p->by[i], p->bx2[i], p->by2[i], &p->nx[i], &p->ny[i], &p->depth[i]);
+    }
+}
+
+void NDL_CircleCapsuleBatch_P(NDL_ShapePairs* p)
+{
+    int i = 0;
+#ifdef NDL_SIMD_X86
+    if (NDL_HasSSE2()) i = NDL_CircleCapsuleBatch4_P(p);
+#endif
+    for (; i < p->count; ++i)
+    {
+        float qx, qy;
+        NDL_ClosestOnSegment_P(p->ax[i], p->ay[i], p->bx[i], p->by[i], p->bx2[i], p->by2[i], &qx, &qy);
+        NDL_PointPointLane_P(p->ax[i], p->ay[i], qx, qy, p->ar[i] + p->br[i], &p->nx[i], &p->ny[i], &p->depth[i]);
+    }
+}
+
+void NDL_CapsuleBoxBatch_P(NDL_ShapePairs* p)
+{
+    int i = 0;
+#ifdef NDL_SIMD_X86
+    if (NDL_HasSSE2()) i = NDL_CapsuleBoxBatch4_P(p);
+#endif
+    for (; i < p->count; ++i)
+    {
+        NDL_CapsuleBoxLane_P(p, i);
+    }
+}
+
+void NDL_CapsuleCapsuleBatch_P(NDL_ShapePairs* p)
+{
+    // Capsule pairs are rare enough that they stay scalar
+    for (int i = 0; i < p->count; ++i)
+    {
+        // Closest points between the two segments (clamped parametric solution)
+        float d1x = p->ax2[i] - p->ax[i], d1y = p->ay2[i] - p->ay[i];
+        float d2x = p->bx2[i] - p->bx[i], d2y = p->by2[i] - p->by[i];
+        float rx = p->ax[i] - p->bx[i], ry = p->ay[i] - p->by[i];
+        float a = d1x*d1x + d1y*d1y;
+        float e = d2x*d2x + d2y*d2y;
+        float f = d2x*rx + d2y*ry;
+        float s = 0.0f, t = 0.0f;
+        if (a <= 1e-6f && e <= 1e-6f) {
+            s = t = 0.0f;
+        } else if (a <= 1e-6f) {
+            t = NDL_Clampf_P(f / e, 0.0f, 1.0f);
+        } else {
+            float c = d1x*rx + d1y*ry;
+            if (e <= 1e-6f) {
+                s = NDL_Clampf_P(-c / a, 0.0f, 1.0f);
+            } else {
+                float b = d1x*d2x + d1y*d2y;
+                float denom = a*e - b*b;
+                s = denom > 1e-6f ? NDL_Clampf_P((b*f - c*e) / denom, 0.0f, 1.0f) : 0.0f;
+                t = (b*s + f) / e;
+                if (t < 0.0f) {
+                    t = 0.0f;
+                    s = NDL_Clampf_P(-c / a, 0.0f, 1.0f);
+                } else if (t > 1.0f) {
+                    t = 1.0f;
+                    s = NDL_Clampf_P((b - c) / a, 0.0f, 1.0f);
+                }
+            }
+        }
+        NDL_PointPointLane_P(p->ax[i] + d1x*s, p->ay[i] + d1y*s, p->bx[i] + d2x*t, p->by[i] + d2y*t, p->ar[i] + p->br[i], &p->nx[i], &p->ny[i], &p->depth[i]);
+    }
+}
+
+static bool NDL_IsColliderMoving_P(NDL_Entity* e)
+{
+    return e->isDynamic || e->collider->velocity.x != 0.0 || e->collider->velocity.y != 0.0;
+}
+
+static void NDL_PushCollider_P(NDL_Entity* e, float nx, float ny, float distance)
+{
+    if (distance <= 0.0f) return;
+    NDL_ColliderComponent* collider = e->collider;
+    collider->position.x += nx * distance;
+    collider->position.y += ny * distance;
+    collider->r.x = collider->position.x;
+    collider->r.y = collider->position.y;
+    NDL_UpdateRect(&collider->r);
+    e->position = collider->position;
+
+    // Remove the part of the velocity heading into the contact
+    float vn = collider->velocity.x*nx + collider->velocity.y*ny;
+    if (vn < 0.0f)
+    {
+        collider->velocity.x -= vn * nx;
+        collider->velocity.y -= vn * ny;
+    }
+    vn = e->velocity.x*nx + e->velocity.y*ny;
+    if (vn < 0.0f)
+    {
+        e->velocity.x -= vn * nx;
+        e->velocity.y -= vn * ny;
+    }
+}
+
+int NDL_ResolveShapePairs_P(NDL_ShapePairs* pairs)
+{
+    int contacts = 0;
+    for (int i = 0; i < pairs->count; ++i)
+    {
+        float depth = pairs->depth[i];
+        if (depth <= 0.0f) continue;
+        bool moveA = NDL_IsColliderMoving_P(pairs->a[i]);
+        bool moveB = NDL_IsColliderMoving_P(pairs->b[i]);
+        if (!moveA && !moveB) continue;
+        float shareA = moveA ? (moveB ? 0.5f : 1.0f) : 0.0f;
+        NDL_PushCollider_P(pairs->a[i], pairs->nx[i], pairs->ny[i], depth * shareA);
+        NDL_PushCollider_P(pairs->b[i], -pairs->nx[i], -pairs->ny[i], depth * (1.0f - shareA));
+        ++contacts;
+    }
+    return contacts;
+}
+
+static void NDL_QueueShapePair_P(NDL_PhysicsGrid* grid, NDL_Entity* a, NDL_Entity* b)
+{
+    NDL_COLLIDER_SHAPES sa = a->collider->shape;
+    NDL_COLLIDER_SHAPES sb = b->collider->shape;
+    // Order each pair so shape A is the "rounder" one the kernel expects
+    if (sa == BOX_COLLIDER || (sa == CAPSULE_COLLIDER && sb == CIRCLE_COLLIDER))
+    {
+        NDL_Entity* t = a; a = b; b = t;
+        NDL_COLLIDER_SHAPES ts = sa; sa = sb; sb = ts;
+    }
+    if (sa == CIRCLE_COLLIDER)
+    {
+        if (sb == CIRCLE_COLLIDER) NDL_PushShapePair_P(grid->circleCircle, a, b);
+        else if (sb == CAPSULE_COLLIDER) NDL_PushShapePair_P(grid->circleCapsule, a, b);
+        else NDL_PushShapePair_P(grid->circleBox, a, b);
+    } else {
+        if (sb == CAPSULE_COLLIDER) NDL_PushShapePair_P(grid->capsuleCapsule, a, b);
+        else NDL_PushShapePair_P(grid->capsuleBox, a, b);
+    }
+}
+
+void NDL_SamplePhysicsGridOccupancy_P(NDL_PhysicsGrid* grid, NDL_PhysicsStats* stats)
+{
+    int occupied = 0, total = 0, largest = 0;
+    for (int row = 0; row < grid->r; ++row)
+    {
+        for (int col = 0; col < grid->c; ++col)
+        {
+            int size = grid->cells[row][col].pool->size;
+            if (size == 0) continue;
+            ++occupied;
+            total += size;
+            if (size > largest) largest = size;
+        }
+    }
+    stats->occupiedCells = occupied;
+    stats->maxCellOccupancy = largest;
+    stats->avgCellOccupancy = occupied > 0 ? (float)total / occupied : 0.0f;
+}
+
+static int NDL_RunShapeNarrowphase_P(NDL_PhysicsGrid* grid)
+{
+    NDL_CircleCircleBatch_P(grid->circleCircle);
+    NDL_CircleBoxBatch_P(grid->circleBox);
+    NDL_CircleCapsuleBatch_P(grid->circleCapsule);
+    NDL_CapsuleBoxBatch_P(grid->capsuleBox);
+    NDL_CapsuleCapsuleBatch_P(grid->capsuleCapsule);
+
+    if (grid->stats != NULL)
+    {
+        grid->stats->narrowphaseTests += grid->circleCircle->count + grid->circleBox->count + grid->circleCapsule->count
+                                       + grid->capsuleBox->count + grid->capsuleCapsule->count;
+    }
+
+    int contacts = 0;
+    contacts += NDL_ResolveShapePairs_P(grid->circleCircle);
+    contacts += NDL_ResolveShapePairs_P(grid->circleBox);
+    contacts += NDL_ResolveShapePairs_P(grid->circleCapsule);
+    contacts += NDL_ResolveShapePairs_P(grid->capsuleBox);
+    contacts += NDL_ResolveShapePairs_P(grid->capsuleCapsule);
+    return contacts;
+}
+
+NDL_CollisionMask* NDL_CreateCollisionMask(NDL_Surface* surface, Uint8 alphaThreshold)
+{
+    NDL_Surface* rgba = SDL_ConvertSurfaceFormat(surface, SDL_PIXELFORMAT_RGBA32, 0);
+    if (rgba == NULL)
+    {
+        printf("Error converting surface for collision mask!\n%s\n", SDL_GetError());
+        return NULL;
+    }
+
+    NDL_CollisionMask* mask = malloc(sizeof(NDL_CollisionMask));
+    mask->w = rgba->w;
+    mask->h = rgba->h;
+    mask->stride = (rgba->w + 63) / 64 + 1;
+    mask->bits = calloc((size_t)mask->stride * mask->h, sizeof(Uint64));
+
+    SDL_LockSurface(rgba);
+    for (int y = 0; y < rgba->h; ++y)
+    {
+        const Uint8* pixel = (const Uint8*)rgba->pixels + y*rgba->pitch;
+        Uint64* row = mask->bits + (size_t)y*mask->stride;
+        for (int x = 0; x < rgba->w; ++x)
+        {
+            if (pixel[x*4 + 3] >= alphaThreshold) row[x >> 6] |= (Uint64)1 << (x & 63);
+        }
+    }
+    SDL_UnlockSurface(rgba);
+    SDL_FreeSurface(rgba);
+    return mask;
+}
+
+NDL_CollisionMask* NDL_LoadCollisionMask(const char* fp, Uint8 alphaThreshold)
+{
+    NDL_Surface* surface = IMG_Load(fp);
+    if (surface == NULL)
+    {
+        printf("Error loading image for collision mask!\n%s\n", IMG_GetError());
+        return NULL;
+    }
+    NDL_CollisionMask* mask = NDL_CreateCollisionMask(surface, alphaThreshold);
+    SDL_FreeSurface(surface);
+    return mask;
+}
+
+void NDL_FreeCollisionMask(NDL_CollisionMask* mask)
+{
+    if (mask == NULL) return;
+    free(mask->bits);
+    free(mask);
+}
+
+static bool NDL_MaskRowOverlap_P(const Uint64* right, const Uint64* left, int words, int shift)
+{
+    for (int j = 0; j < words; ++j)
+    {
+        Uint64 shifted = shift ? (left[j] >> shift) | (left[j+1] << (64 - shift)) : left[j];
+        if (right[j] & shifted) return true;
+    }
+    return false;
+}
+
+#ifdef NDL_SIMD_X86
+NDL_TARGET_SSE2 static bool NDL_MaskRowOverlap2_P(const Uint64* right, const Uint64* left, int words, int shift)
+{
+    // SSE2 shifts by 64 or more yield zero, so shift == 0 needs no special case
+    __m128i lo = _mm_cvtsi32_si128(shift);
+    __m128i hi = _mm_cvtsi32_si128(64 - shift);
+    int j = 0;
+    for (; j + 2 <= words; j += 2)
+    {
+        __m128i l0 = _mm_loadu_si128((const __m128i*)(left + j));
+        __m128i l1 = _mm_loadu_si128((const __m128i*)(left + j + 1));
+        __m128i shifted = _mm_or_si128(_mm_srl_epi64(l0, lo), _mm_sll_epi64(l1, hi));
+        __m128i hit = _mm_and_si128(_mm_loadu_si128((const __m128i*)(right + j)), shifted);
+        if (_mm_movemask_epi8(_mm_cmpeq_epi8(hit, _mm_setzero_si128())) != 0xFFFF) return true;
+    }
+    return j < words && NDL_MaskRowOverlap_P(right + j, left + j, words - j, shift);
+}
+#endif
+
+bool NDL_MaskOverlap_P(const NDL_CollisionMask* a, int ax, int ay, const NDL_CollisionMask* b, int bx, int by)
+{
+    // Walk the rows of the right-hand mask and pull the matching bits out of the left-hand one
+    const NDL_CollisionMask* left = a;
+    const NDL_CollisionMask* right = b;
+    int lx = ax, ly = ay, rx = bx, ry = by;
+    if (bx < ax)
+    {
+        left = b; right = a;
+        lx = bx; ly = by; rx = ax; ry = ay;
+    }
+    int dx = rx - lx;
+    int columns = min(right->w, left->w - dx);
+    int top = max(ly, ry);
+    int bottom = min(ly + left->h, ry + right->h);
+    if (columns <= 0 || top >= bottom) return false;
+
+    int words = (columns + 63) / 64;
+    int base = dx >> 6;
+    int shift = dx & 63;
+#ifdef NDL_SIMD_X86
+    bool useSSE2 = NDL_HasSSE2();
+#endif
+    for (int y = top; y < bottom; ++y)
+    {
+        const Uint64* rightRow = right->bits + (size_t)(y - ry)*right->stride;
+        const Uint64* leftRow = left->bits + (size_t)(y - ly)*left->stride + base;
+#ifdef NDL_SIMD_X86
+        if (useSSE2)
+        {
+            if (NDL_MaskRowOverlap2_P(rightRow, leftRow, words, shift)) return true;
+            continue;
+        }
+#endif
+        if (NDL_MaskRowOverlap_P(rightRow, leftRow, words, shift)) return true;
+    }
+    return false;
+}
+
+bool NDL_PixelCollision_P(NDL_Entity* ent1, NDL_Entity* ent2)
+{
+    NDL_ColliderComponent* collider1 = ent1->collider;
+    NDL_ColliderComponent* collider2 = ent2->collider;
+    // Bounding boxes first; the masks are only read when they overlap
+    if (collider1->r.x >= collider2->r.x + collider2->r.w || collider2->r.x >= collider1->r.x + collider1->r.w ||
+        collider1->r.y >= collider2->r.y + collider2->r.h || collider2->r.y >= collider1->r.y + collider1->r.h)
+    {
+        return false;
+    }
+    if (collider1->mask == NULL || collider2->mask == NULL) return true;
+    return NDL_MaskOverlap_P(collider1->mask, (int)floorf(collider1->r.x), (int)floorf(collider1->r.y),
+                             collider2->mask, (int)floorf(collider2->r.x), (int)floorf(collider2->r.y));
+}
+
+// The AABB path snaps touching edges within a unit, so bounds are padded by one before rejecting
+static inline bool NDL_CellBodiesTouch_P(const NDL_CellBody* a, const NDL_CellBody* b)
+{
+    return a->minX <= b->maxX + 1.0f && b->minX <= a->maxX + 1.0f && a->minY <= b->maxY + 1.0f && b->minY <= a->maxY + 1.0f;
+}
+
+static void NDL_GatherCellBodies_P(Cell* cell)
+{
+    NDL_Pool* pool = cell->pool;
+    for (int i = 0; i < pool->size; ++i)
+    {
+        NDL_ColliderComponent* collider = pool->entities[i]->collider;
+        NDL_CellBody* body = &cell->bodies[i];
+        body->minX = collider->r.x;
+        body->minY = collider->r.y;
+        body->maxX = collider->r.x + collider->r.w;
+        body->maxY = collider->r.y + collider->r.h;
+        body->box = collider->shape == BOX_COLLIDER;
+        body->masked = collider->mask != NULL;
+    }
+}
+
 bool NDL_ObserveCollision_P(NDL_PhysicsGrid* grid)
 {
+    Uint64 start = grid->profileStages ? SDL_GetPerformanceCounter() : 0;
+    int tests = 0, contacts = 0, overlaps = 0, pairs = 0;
     bool collisionDetected = false;
+    NDL_ClearShapePairs_P(grid->circleCircle);
+    NDL_ClearShapePairs_P(grid->circleBox);
+    NDL_ClearShapePairs_P(grid->circleCapsule);
+    NDL_ClearShapePairs_P(grid->capsuleBox);
+    NDL_ClearShapePairs_P(grid->capsuleCapsule);
     // Iterate through entities in the cell
     for (int row = 0; row < grid->r; ++row)   // rows
     {
         for (int col = 0; col < grid->c; ++col)   // cols
         {
             NDL_Pool* cell = grid->cells[row][col].pool;
+            NDL_CellBody* bodies = grid->cells[row][col].bodies;
+            pairs += cell->size*(cell->size - 1) / 2;
+            // Each entity is read once here; the pair loop below only touches the contiguous
+            // bodies and follows entity pointers for pairs whose bounds actually meet
+            NDL_GatherCellBodies_P(&grid->cells[row][col]);
             for (int i = 0; i < cell->size; ++i)
             {
-                NDL_Entity* entityA = cell->entities[i];
                 // Check for collision with other entities in the cell
                 for (int j = 0; j < cell->size; ++j)
                 {
-                    if (i == j) continue;
+                    if (i == j || !NDL_CellBodiesTouch_P(&bodies[i], &bodies[j])) continue;
+                    NDL_Entity* entityA = cell->entities[i];
                     NDL_Entity* entityB = cell->entities[j];
+                    if (!bodies[i].box || !bodies[j].box)
+                    {
+                        // Round shapes are gathered once per pair and tested in batches below
+                        if (j > i) NDL_QueueShapePair_P(grid, entityA, entityB);
+                        continue;
+                    }
+                    if (bodies[i].masked && bodies[j].masked)
+                    {
+                        // Masked pairs are pixel-accurate overlap sensors and are not pushed apart
+                        if (j > i)
+                        {
+                            ++tests;
+                            if (NDL_PixelCollision_P(entityA, entityB))
+                            {
+                                collisionDetected = true;
+                                ++overlaps;
+                            }
+                        }
+                        continue;
+                    }
                     // Apply collision rules between entityA and entityB
                     NDL_CollisionData collision = NDL_GenerateCollisionInfo_P(entityA, entityB);
+                    ++tests;
                     if (!collision.none)
                     {
+                        ++contacts;
                         //printf("collision data generated!\n1st step AABB resolution calculated!\n");
                         collisionDetected = true;
                     }
@@ -159,6 +852,16 @@ bool NDL_ObserveCollision_P(NDL_PhysicsGrid* grid)
             }    
         }
     }
+    int shapeContacts = NDL_RunShapeNarrowphase_P(grid);
+    if (shapeContacts > 0) collisionDetected = true;
+    if (grid->stats != NULL)
+    {
+        grid->stats->broadphasePairs += pairs;
+        grid->stats->narrowphaseTests += tests;
+        grid->stats->contactsResolved += contacts + shapeContacts;
+        grid->stats->maskOverlaps += overlaps;
+        if (grid->profileStages) grid->stats->collisionMs += NDL_GetElapsedMs(start);
+    }
     return collisionDetected;
 }
 
@@ -228,16 +931,11 @@ void NDL_HandlePositions_P(NDL_PhysicsSystem* phys, NDL_Entity* e, float deltaTi
             e->position.x = e->collider->position.x;
             e->position.y = e->collider->position.y;
             NDL_UpdateRect(&e->collider->r);  // Update the collider/rectangle after adjusting the position
-            
-            e->sprite->imageRect.x = e->collider->position.x;
-            e->sprite->imageRect.y = e->collider->position.y;
 
             phys->handleCollisions(phys->gridSpace);
         }else {
             e->position.x += e->velocity.x * deltaTime;
             e->position.y += e->velocity.y * deltaTime;
-            e->sprite->imageRect.x = e->position.x;
-            e->sprite->imageRect.y = e->position.y;
         }
     }
 }
@@ -255,19 +953,857 @@ NDL_PhysicsSystem* NDL_CreatePhysicsSystem(int gridSpaceW, int gridSpaceH, int n
     p->handleForces = NDL_HandleForces_P;
     p->handlePositions = NDL_HandlePositions_P;
     p->handleCollisions = NDL_ObserveCollision_P;
+    p->reorderInterval = 0;
+    p->framesSinceReorder = 0;
+    p->profileStages = false;
+    p->fixedStep = 1.0f / 60.0f;
+    p->accumulator = 0.0f;
+    p->maxStepsPerFrame = 8;
+    memset(&p->stats, 0, sizeof(NDL_PhysicsStats));
+    p->gridSpace->stats = &p->stats;
     return p;
 }
 
+// Diagonal of the entity's sprite or collider, whichever is larger: how far it can reach from its position
+static float NDL_EntityExtent_P(const NDL_Entity* e)
+{
+    float extent = 0.0f;
+    if (NDL_HasComponent((NDL_Entity*)e, SPRITE_COMPONENT))
+    {
+        float w = e->sprite->imageRect.w*e->sprite->scale.x, h = e->sprite->imageRect.h*e->sprite->scale.y;
+        extent = sqrtf(w*w + h*h);
+    }
+    if (NDL_HasComponent((NDL_Entity*)e, COLLIDER_COMPONENT))
+    {
+        float w = e->collider->r.w, h = e->collider->r.h;
+        extent = SDL_max(extent, sqrtf(w*w + h*h));
+    }
+    return extent;
+}
+
 void NDL_AddEntityToGrid(NDL_Entity* e, NDL_PhysicsGrid* grid)
 {
+    grid->maxExtent = SDL_max(grid->maxExtent, NDL_EntityExtent_P(e));
     // Calculate grid cell based on entity position
     int cellX = e->position.x / grid->cellSize;
     int cellY = e->position.y / grid->cellSize;
 
     // Check if the calculated cell is within grid bounds
     if (cellX >= 0 && cellX < grid->c && cellY >= 0 && cellY < grid->r) {
-        NDL_AddToPool(e, grid->cells[cellX][cellY].pool);
+        NDL_AddToPool(e, grid->cells[cellY][cellX].pool);
     } else {
         printf("NDL_Entity position is out of grid bounds!\n");
     }
-}
\ No newline at end of file
+}
+
+#define NDL_MORTON_QUANTUM 4.0f   // World units per Morton step; 16 bits cover 262144 units per axis
+
+Uint32 NDL_MortonCode(float x, float y)
+{
+    float qx = x / NDL_MORTON_QUANTUM;
+    float qy = y / NDL_MORTON_QUANTUM;
+    Uint32 ix = qx <= 0.0f ? 0 : (qx >= 65535.0f ? 65535 : (Uint32)qx);
+    Uint32 iy = qy <= 0.0f ? 0 : (qy >= 65535.0f ? 65535 : (Uint32)qy);
+    // Spread the 16 bits of each axis out to every other bit, then interleave
+    ix = (ix | (ix << 8)) & 0x00FF00FF;
+    ix = (ix | (ix << 4)) & 0x0F0F0F0F;
+    ix = (ix | (ix << 2)) & 0x33333333;
+    ix = (ix | (ix << 1)) & 0x55555555;
+    iy = (iy | (iy << 8)) & 0x00FF00FF;
+    iy = (iy | (iy << 4)) & 0x0F0F0F0F;
+    iy = (iy | (iy << 2)) & 0x33333333;
+    iy = (iy | (iy << 1)) & 0x55555555;
+    return ix | (iy << 1);
+}
+
+static void NDL_SortByKey32_P(Uint32* keys, NDL_Entity** items, int n, Uint32* tmpKeys, NDL_Entity** tmpItems)
+{
+    if (n < 32)
+    {
+        for (int i = 1; i < n; ++i)
+        {
+            Uint32 k = keys[i];
+            NDL_Entity* e = items[i];
+            int j = i - 1;
+            while (j >= 0 && keys[j] > k)
+            {
+                keys[j + 1] = keys[j];
+                items[j + 1] = items[j];
+                --j;
+            }
+            keys[j + 1] = k;
+            items[j + 1] = e;
+        }
+        return;
+    }
+
+    // LSD radix sort, one byte per pass; passes where every key shares the byte are skipped
+    Uint32* srcKeys = keys;
+    NDL_Entity** srcItems = items;
+    Uint32* dstKeys = tmpKeys;
+    NDL_Entity** dstItems = tmpItems;
+    for (int shift = 0; shift < 32; shift += 8)
+    {
+        int count[257] = {0};
+        for (int i = 0; i < n; ++i) ++count[((srcKeys[i] >> shift) & 0xFF) + 1];
+        if (count[((srcKeys[0] >> shift) & 0xFF) + 1] == n) continue;
+        for (int b = 0; b < 256; ++b) count[b + 1] += count[b];
+        for (int i = 0; i < n; ++i)
+        {
+            int dst = count[(srcKeys[i] >> shift) & 0xFF]++;
+            dstKeys[dst] = srcKeys[i];
+            dstItems[dst] = srcItems[i];
+        }
+        Uint32* tk = srcKeys; srcKeys = dstKeys; dstKeys = tk;
+        NDL_Entity** ti = srcItems; srcItems = dstItems; dstItems = ti;
+    }
+    if (srcKeys != keys)
+    {
+        memcpy(keys, srcKeys, sizeof(Uint32)*n);
+        memcpy(items, srcItems, sizeof(NDL_Entity*)*n);
+    }
+}
+
+static void NDL_SortPoolMortonScratch_P(NDL_Pool* pool, Uint32* keys, Uint32* tmpKeys, NDL_Entity** tmpItems)
+{
+    for (int i = 0; i < pool->size; ++i)
+    {
+        keys[i] = NDL_MortonCode(pool->entities[i]->position.x, pool->entities[i]->position.y);
+    }
+    NDL_SortByKey32_P(keys, pool->entities, pool->size, tmpKeys, tmpItems);
+}
+
+void NDL_SortPoolMorton(NDL_Pool* pool)
+{
+    if (pool->size < 2) return;
+    Uint32* keys = malloc(sizeof(Uint32)*pool->size*2);
+    NDL_Entity** tmpItems = malloc(sizeof(NDL_Entity*)*pool->size);
+    NDL_SortPoolMortonScratch_P(pool, keys, keys + pool->size, tmpItems);
+    free(tmpItems);
+    free(keys);
+}
+
+int NDL_QueryGridRect(NDL_PhysicsGrid* grid, SDL_FRect rect, NDL_Entity** out, int maxCount)
+{
+    if (grid->binsStale) NDL_RebinPhysicsGrid(grid);
+    // Entities are binned by their position, so anything reaching into the rect lies within the
+    // largest extent of it; the extra cell covers drawing up to a tick behind the binned position
+    float pad = grid->maxExtent;
+    int col0 = (int)floorf((rect.x - pad) / grid->cellSize) - 1;
+    int row0 = (int)floorf((rect.y - pad) / grid->cellSize) - 1;
+    int col1 = (int)floorf((rect.x + rect.w + pad) / grid->cellSize) + 1;
+    int row1 = (int)floorf((rect.y + rect.h + pad) / grid->cellSize) + 1;
+    if (col0 < 0) col0 = 0;
+    if (row0 < 0) row0 = 0;
+    if (col1 > grid->c - 1) col1 = grid->c - 1;
+    if (row1 > grid->r - 1) row1 = grid->r - 1;
+
+    int found = 0;
+    for (int row = row0; row <= row1; ++row)
+    {
+        for (int col = col0; col <= col1; ++col)
+        {
+            NDL_Pool* cell = grid->cells[row][col].pool;
+            for (int i = 0; i < cell->size; ++i)
+            {
+                if (found < maxCount) out[found] = cell->entities[i];
+                ++found;
+            }
+        }
+    }
+    return found;
+}
+
+void NDL_RebinPhysicsGrid(NDL_PhysicsGrid* grid)
+{
+    // Every entity is visited anyway, so the query padding is brought up to date as well
+    float maxExtent = 0.0f;
+    for (int row = 0; row < grid->r; ++row)
+    {
+        for (int col = 0; col < grid->c; ++col)
+        {
+            NDL_Pool* cell = grid->cells[row][col].pool;
+            int i = 0;
+            while (i < cell->size)
+            {
+                NDL_Entity* e = cell->entities[i];
+                maxExtent = SDL_max(maxExtent, NDL_EntityExtent_P(e));
+                int targetCol = (int)floorf(e->position.x / grid->cellSize);
+                int targetRow = (int)floorf(e->position.y / grid->cellSize);
+                bool inside = targetCol >= 0 && targetCol < grid->c && targetRow >= 0 && targetRow < grid->r;
+                NDL_Pool* target = inside ? grid->cells[targetRow][targetCol].pool : cell;
+                if (target == cell || target->size >= target->maxSize)
+                {
+                    ++i;
+                    continue;
+                }
+                // Swap-remove; cell order does not matter because the cell is sorted afterwards
+                cell->entities[i] = cell->entities[--cell->size];
+                target->entities[target->size++] = e;
+            }
+        }
+    }
+    grid->maxExtent = maxExtent;
+    grid->binsStale = false;
+}
+
+void NDL_ReorderPhysicsGrid(NDL_PhysicsGrid* grid)
+{
+    NDL_RebinPhysicsGrid(grid);
+
+    int largest = 0;
+    for (int row = 0; row < grid->r; ++row)
+    {
+        for (int col = 0; col < grid->c; ++col)
+        {
+            if (grid->cells[row][col].pool->size > largest) largest = grid->cells[row][col].pool->size;
+        }
+    }
+    if (largest < 2) return;
+
+    Uint32* keys = malloc(sizeof(Uint32)*largest*2);
+    NDL_Entity** tmpItems = malloc(sizeof(NDL_Entity*)*largest);
+    for (int row = 0; row < grid->r; ++row)
+    {
+        for (int col = 0; col < grid->c; ++col)
+        {
+            NDL_Pool* cell = grid->cells[row][col].pool;
+            if (cell->size > 1) NDL_SortPoolMortonScratch_P(cell, keys, keys + largest, tmpItems);
+        }
+    }
+    free(tmpItems);
+    free(keys);
+}
+
+#define NDL_VERLET_COLORS 32    // Constraints that fit no colour are relaxed one by one at the end
+
+static float* NDL_AllocVerletLane_P(int count)
+{
+    float* lane = SDL_SIMDAlloc(sizeof(float)*count);
+    memset(lane, 0, sizeof(float)*count);
+    return lane;
+}
+
+NDL_VerletSystem* NDL_CreateVerletSystem(int maxPoints, int maxConstraints)
+{
+    NDL_VerletSystem* vs = malloc(sizeof(NDL_VerletSystem));
+    // Point lanes are padded to a multiple of 4 so the integration loop never needs a tail
+    int paddedPoints = (maxPoints + 3) & ~3;
+    vs->pointCount = 0;
+    vs->maxPoints = maxPoints;
+    vs->x = NDL_AllocVerletLane_P(paddedPoints);
+    vs->y = NDL_AllocVerletLane_P(paddedPoints);
+    vs->px = NDL_AllocVerletLane_P(paddedPoints);
+    vs->py = NDL_AllocVerletLane_P(paddedPoints);
+    vs->invMass = NDL_AllocVerletLane_P(paddedPoints);
+
+    vs->constraintCount = 0;
+    vs->maxConstraints = maxConstraints;
+    vs->ca = malloc(sizeof(int)*maxConstraints);
+    vs->cb = malloc(sizeof(int)*maxConstraints);
+    vs->restLength = malloc(sizeof(float)*maxConstraints);
+    vs->colorCount = 0;
+    vs->colorStart = malloc(sizeof(int)*(NDL_VERLET_COLORS + 2));
+    vs->constraintsDirty = false;
+
+    vs->stripCount = 0;
+    vs->stripStart = NULL;
+    vs->stripLength = NULL;
+    vs->stripIndexCount = 0;
+    vs->stripIndices = NULL;
+    vs->stripPoints = NULL;
+
+    vs->gravity = (Vector2F){0.0, 980.0};
+    vs->damping = 0.99;
+    vs->iterations = 8;
+    vs->collisionGrid = NULL;
+    vs->color = (NDL_Color){255, 255, 255, 255};
+    return vs;
+}
+
+void NDL_DestroyVerletSystem(NDL_VerletSystem* vs)
+{
+    SDL_SIMDFree(vs->x);
+    SDL_SIMDFree(vs->y);
+    SDL_SIMDFree(vs->px);
+    SDL_SIMDFree(vs->py);
+    SDL_SIMDFree(vs->invMass);
+    free(vs->ca);
+    free(vs->cb);
+    free(vs->restLength);
+    free(vs->colorStart);
+    free(vs->stripStart);
+    free(vs->stripLength);
+    free(vs->stripIndices);
+    free(vs->stripPoints);
+    free(vs);
+}
+
+int NDL_AddVerletPoint(NDL_VerletSystem* vs, Vector2F position, bool pinned)
+{
+    if (vs->pointCount >= vs->maxPoints)
+    {
+        printf("This Verlet system is full!\n");
+        return -1;
+    }
+    int i = vs->pointCount++;
+    vs->x[i] = vs->px[i] = position.x;
+    vs->y[i] = vs->py[i] = position.y;
+    vs->invMass[i] = pinned ? 0.0f : 1.0f;
+    return i;
+}
+
+void NDL_AddVerletConstraint(NDL_VerletSystem* vs, int a, int b, float restLength)
+{
+    if (vs->constraintCount >= vs->maxConstraints)
+    {
+        printf("This Verlet system has no room for more constraints!\n");
+        return;
+    }
+    if (a < 0 || b < 0 || a >= vs->pointCount || b >= vs->pointCount || a == b) return;
+    int i = vs->constraintCount++;
+    vs->ca[i] = a;
+    vs->cb[i] = b;
+    // A negative rest length keeps the distance the points have right now
+    vs->restLength[i] = restLength >= 0.0f ? restLength : (float)NDL_GetMagnitude(vs->x[b] - vs->x[a], vs->y[b] - vs->y[a]);
+    vs->constraintsDirty = true;
+}
+
+void NDL_PinVerletPoint(NDL_VerletSystem* vs, int i, bool pinned)
+{
+    vs->invMass[i] = pinned ? 0.0f : 1.0f;
+}
+
+void NDL_MoveVerletPoint(NDL_VerletSystem* vs, int i, Vector2F position)
+{
+    vs->x[i] = vs->px[i] = position.x;
+    vs->y[i] = vs->py[i] = position.y;
+}
+
+Vector2F NDL_GetVerletPoint(NDL_VerletSystem* vs, int i)
+{
+    return (Vector2F){vs->x[i], vs->y[i]};
+}
+
+static void NDL_AddVerletStrip_P(NDL_VerletSystem* vs, int first, int count, int step)
+{
+    vs->stripStart = realloc(vs->stripStart, sizeof(int)*(vs->stripCount + 1));
+    vs->stripLength = realloc(vs->stripLength, sizeof(int)*(vs->stripCount + 1));
+    vs->stripIndices = realloc(vs->stripIndices, sizeof(int)*(vs->stripIndexCount + count));
+    vs->stripStart[vs->stripCount] = vs->stripIndexCount;
+    vs->stripLength[vs->stripCount] = count;
+    for (int i = 0; i < count; ++i)
+    {
+        vs->stripIndices[vs->stripIndexCount + i] = first + i*step;
+    }
+    vs->stripIndexCount += count;
+    ++vs->stripCount;
+
+    int longest = 0;
+    for (int s = 0; s < vs->stripCount; ++s)
+    {
+        if (vs->stripLength[s] > longest) longest = vs->stripLength[s];
+    }
+    vs->stripPoints = realloc(vs->stripPoints, sizeof(SDL_FPoint)*longest);
+}
+
+int NDL_CreateVerletRope(NDL_VerletSystem* vs, Vector2F start, Vector2F end, int segments, bool pinStart, bool pinEnd)
+{
+    if (segments < 1 || vs->pointCount + segments + 1 > vs->maxPoints || vs->constraintCount + segments > vs->maxConstraints)
+    {
+        printf("Error creating Verlet rope, the system is too small!\n");
+        return -1;
+    }
+    int first = vs->pointCount;
+    for (int i = 0; i <= segments; ++i)
+    {
+        float t = (float)i / segments;
+        Vector2F p = {start.x + (end.x - start.x)*t, start.y + (end.y - start.y)*t};
+        NDL_AddVerletPoint(vs, p, (i == 0 && pinStart) || (i == segments && pinEnd));
+        if (i > 0) NDL_AddVerletConstraint(vs, first + i - 1, first + i, -1.0f);
+    }
+    NDL_AddVerletStrip_P(vs, first, segments + 1, 1);
+    return first;
+}
+
+int NDL_CreateVerletCloth(NDL_VerletSystem* vs, Vector2F topLeft, int cols, int rows, float spacing, bool pinTop)
+{
+    int constraints = rows*(cols - 1) + cols*(rows - 1);
+    if (cols < 2 || rows < 2 || vs->pointCount + cols*rows > vs->maxPoints || vs->constraintCount + constraints > vs->maxConstraints)
+    {
+        printf("Error creating Verlet cloth, the system is too small!\n");
+        return -1;
+    }
+    int first = vs->pointCount;
+    for (int r = 0; r < rows; ++r)
+    {
+        for (int c = 0; c < cols; ++c)
+        {
+            int i = NDL_AddVerletPoint(vs, (Vector2F){topLeft.x + c*spacing, topLeft.y + r*spacing}, pinTop && r == 0);
+            if (c > 0) NDL_AddVerletConstraint(vs, i - 1, i, spacing);
+            if (r > 0) NDL_AddVerletConstraint(vs, i - cols, i, spacing);
+        }
+    }
+    for (int r = 0; r < rows; ++r) NDL_AddVerletStrip_P(vs, first + r*cols, cols, 1);
+    for (int c = 0; c < cols; ++c) NDL_AddVerletStrip_P(vs, first + c, rows, cols);
+    return first;
+}
+
+void NDL_SetVerletGravity(NDL_VerletSystem* vs, Vector2F gravity)
+{
+    vs->gravity = gravity;
+}
+
+void NDL_SetVerletIterations(NDL_VerletSystem* vs, int iterations)
+{
+    vs->iterations = iterations > 0 ? iterations : 1;
+}
+
+void NDL_SetVerletCollisionGrid(NDL_VerletSystem* vs, NDL_PhysicsGrid* grid)
+{
+    vs->collisionGrid = grid;
+}
+
+static void NDL_ColorVerletConstraints_P(NDL_VerletSystem* vs)
+{
+    int n = vs->constraintCount;
+    Uint32* used = calloc(vs->pointCount > 0 ? vs->pointCount : 1, sizeof(Uint32));
+    Uint8* color = malloc(n > 0 ? n : 1);
+    int counts[NDL_VERLET_COLORS + 1] = {0};
+
+    // Greedy colouring: each constraint takes the lowest colour neither of its points uses yet
+    for (int i = 0; i < n; ++i)
+    {
+        Uint32 busy = used[vs->ca[i]] | used[vs->cb[i]];
+        int k = 0;
+        while (k < NDL_VERLET_COLORS && (busy >> k) & 1) ++k;
+        if (k < NDL_VERLET_COLORS)
+        {
+            used[vs->ca[i]] |= (Uint32)1 << k;
+            used[vs->cb[i]] |= (Uint32)1 << k;
+        }
+        color[i] = (Uint8)k;
+        ++counts[k];
+    }
+
+    vs->colorStart[0] = 0;
+    for (int k = 0; k <= NDL_VERLET_COLORS; ++k) vs->colorStart[k + 1] = vs->colorStart[k] + counts[k];
+    vs->colorCount = NDL_VERLET_COLORS + 1;
+
+    // Reorder the constraint arrays so each colour is contiguous
+    int* ca = malloc(sizeof(int)*(n > 0 ? n : 1));
+    int* cb = malloc(sizeof(int)*(n > 0 ? n : 1));
+    float* rest = malloc(sizeof(float)*(n > 0 ? n : 1));
+    int next[NDL_VERLET_COLORS + 1];
+    memcpy(next, vs->colorStart, sizeof(next));
+    for (int i = 0; i < n; ++i)
+    {
+        int dst = next[color[i]]++;
+        ca[dst] = vs->ca[i];
+        cb[dst] = vs->cb[i];
+        rest[dst] = vs->restLength[i];
+    }
+    memcpy(vs->ca, ca, sizeof(int)*n);
+    memcpy(vs->cb, cb, sizeof(int)*n);
+    memcpy(vs->restLength, rest, sizeof(float)*n);
+    free(ca);
+    free(cb);
+    free(rest);
+    free(color);
+    free(used);
+    vs->constraintsDirty = false;
+}
+
+static void NDL_RelaxVerletRange_P(NDL_VerletSystem* vs, int start, int end)
+{
+    float* x = vs->x;
+    float* y = vs->y;
+    float* w = vs->invMass;
+    for (int i = start; i < end; ++i)
+    {
+        int a = vs->ca[i], b = vs->cb[i];
+        float wsum = w[a] + w[b];
+        if (wsum <= 0.0f) continue;
+        float dx = x[b] - x[a];
+        float dy = y[b] - y[a];
+        float d = sqrtf(dx*dx + dy*dy);
+        if (d < 1e-6f) continue;
+        float k = (d - vs->restLength[i]) / (d * wsum);
+        x[a] += dx*k*w[a]; y[a] += dy*k*w[a];
+        x[b] -= dx*k*w[b]; y[b] -= dy*k*w[b];
+    }
+}
+
+static void NDL_IntegrateVerletRange_P(NDL_VerletSystem* vs, int start, int end, float gx, float gy)
+{
+    for (int i = start; i < end; ++i)
+    {
+        if (vs->invMass[i] <= 0.0f)
+        {
+            vs->px[i] = vs->x[i];
+            vs->py[i] = vs->y[i];
+            continue;
+        }
+        float x = vs->x[i];
+        float y = vs->y[i];
+        vs->x[i] += (x - vs->px[i])*vs->damping + gx;
+        vs->y[i] += (y - vs->py[i])*vs->damping + gy;
+        vs->px[i] = x;
+        vs->py[i] = y;
+    }
+}
+
+#ifdef NDL_SIMD_X86
+NDL_TARGET_SSE2 static void NDL_IntegrateVerlet4_P(NDL_VerletSystem* vs, float gx, float gy)
+{
+    __m128 damping = _mm_set1_ps(vs->damping);
+    __m128 vgx = _mm_set1_ps(gx);
+    __m128 vgy = _mm_set1_ps(gy);
+    for (int i = 0; i < vs->pointCount; i += 4)
+    {
+        __m128 x = _mm_load_ps(&vs->x[i]);
+        __m128 y = _mm_load_ps(&vs->y[i]);
+        __m128 movable = _mm_cmpgt_ps(_mm_load_ps(&vs->invMass[i]), _mm_setzero_ps());
+        __m128 nx = _mm_add_ps(x, _mm_add_ps(_mm_mul_ps(_mm_sub_ps(x, _mm_load_ps(&vs->px[i])), damping), vgx));
+        __m128 ny = _mm_add_ps(y, _mm_add_ps(_mm_mul_ps(_mm_sub_ps(y, _mm_load_ps(&vs->py[i])), damping), vgy));
+        _mm_store_ps(&vs->x[i], NDL_Select4_P(movable, nx, x));
+        _mm_store_ps(&vs->y[i], NDL_Select4_P(movable, ny, y));
+        _mm_store_ps(&vs->px[i], x);
+        _mm_store_ps(&vs->py[i], y);
+    }
+}
+
+NDL_TARGET_SSE2 static int NDL_RelaxVerlet4_P(NDL_VerletSystem* vs, int start, int end)
+{
+    // Constraints of one colour touch disjoint points, so gather/compute/scatter is race free
+    float* x = vs->x;
+    float* y = vs->y;
+    float* w = vs->invMass;
+    int i = start;
+    for (; i + 4 <= end; i += 4)
+    {
+        const int* a = &vs->ca[i];
+        const int* b = &vs->cb[i];
+        __m128 xa = _mm_setr_ps(x[a[0]], x[a[1]], x[a[2]], x[a[3]]);
+        __m128 ya = _mm_setr_ps(y[a[0]], y[a[1]], y[a[2]], y[a[3]]);
+        __m128 xb = _mm_setr_ps(x[b[0]], x[b[1]], x[b[2]], x[b[3]]);
+        __m128 yb = _mm_setr_ps(y[b[0]], y[b[1]], y[b[2]], y[b[3]]);
+        __m128 wa = _mm_setr_ps(w[a[0]], w[a[1]], w[a[2]], w[a[3]]);
+        __m128 wb = _mm_setr_ps(w[b[0]], w[b[1]], w[b[2]], w[b[3]]);
+
+        __m128 dx = _mm_sub_ps(xb, xa);
+        __m128 dy = _mm_sub_ps(yb, ya);
+        __m128 d = _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)));
+        __m128 wsum = _mm_add_ps(wa, wb);
+        __m128 eps = _mm_set1_ps(1e-6f);
+        __m128 valid = _mm_and_ps(_mm_cmpgt_ps(wsum, _mm_setzero_ps()), _mm_cmpge_ps(d, eps));
+        __m128 k = _mm_div_ps(_mm_sub_ps(d, _mm_loadu_ps(&vs->restLength[i])), _mm_mul_ps(_mm_max_ps(d, eps), _mm_max_ps(wsum, eps)));
+        k = _mm_and_ps(valid, k);
+        __m128 kx = _mm_mul_ps(dx, k);
+        __m128 ky = _mm_mul_ps(dy, k);
+
+        float out[4][4];
+        _mm_storeu_ps(out[0], _mm_add_ps(xa, _mm_mul_ps(kx, wa)));
+        _mm_storeu_ps(out[1], _mm_add_ps(ya, _mm_mul_ps(ky, wa)));
+        _mm_storeu_ps(out[2], _mm_sub_ps(xb, _mm_mul_ps(kx, wb)));
+        _mm_storeu_ps(out[3], _mm_sub_ps(yb, _mm_mul_ps(ky, wb)));
+        for (int l = 0; l < 4; ++l)
+        {
+            x[a[l]] = out[0][l]; y[a[l]] = out[1][l];
+            x[b[l]] = out[2][l]; y[b[l]] = out[3][l];
+        }
+    }
+    return i;
+}
+#endif
+
+static void NDL_CollideVerletPoint_P(NDL_VerletSystem* vs, int i)
+{
+    NDL_PhysicsGrid* grid = vs->collisionGrid;
+    int col = (int)floorf(vs->x[i] / grid->cellSize);
+    int row = (int)floorf(vs->y[i] / grid->cellSize);
+    // Entities are binned by their top-left corner, so a box covering this point can sit one cell up or left
+    for (int r = row - 1; r <= row; ++r)
+    {
+        for (int c = col - 1; c <= col; ++c)
+        {
+            if (r < 0 || c < 0 || r >= grid->r || c >= grid->c) continue;
+            NDL_Pool* cell = grid->cells[r][c].pool;
+            for (int e = 0; e < cell->size; ++e)
+            {
+                NDL_Entity* entity = cell->entities[e];
+                if (!NDL_HasComponent(entity, COLLIDER_COMPONENT) || entity->isDynamic) continue;
+                NDL_Rect* b = &entity->collider->r;
+                float px = vs->x[i], py = vs->y[i];
+                if (px <= b->x || px >= b->x + b->w || py <= b->y || py >= b->y + b->h) continue;
+
+                // Push out through the nearest face and drop the velocity into that face
+                float left = px - b->x, right = b->x + b->w - px;
+                float top = py - b->y, bottom = b->y + b->h - py;
+                float best = min(min(left, right), min(top, bottom));
+                if (best == left) { vs->x[i] = b->x; vs->px[i] = vs->x[i]; }
+                else if (best == right) { vs->x[i] = b->x + b->w; vs->px[i] = vs->x[i]; }
+                else if (best == top) { vs->y[i] = b->y; vs->py[i] = vs->y[i]; }
+                else { vs->y[i] = b->y + b->h; vs->py[i] = vs->y[i]; }
+            }
+        }
+    }
+}
+
+void NDL_UpdateVerletSystem(NDL_VerletSystem* vs, float deltaTime)
+{
+    if (vs->constraintsDirty) NDL_ColorVerletConstraints_P(vs);
+    float gx = vs->gravity.x * deltaTime * deltaTime;
+    float gy = vs->gravity.y * deltaTime * deltaTime;
+
+#ifdef NDL_SIMD_X86
+    bool useSSE2 = NDL_HasSSE2();
+    if (useSSE2) NDL_IntegrateVerlet4_P(vs, gx, gy);
+    else NDL_IntegrateVerletRange_P(vs, 0, vs->pointCount, gx, gy);
+#else
+    NDL_IntegrateVerletRange_P(vs, 0, vs->pointCount, gx, gy);
+#endif
+
+    for (int it = 0; it < vs->iterations; ++it)
+    {
+        for (int k = 0; k < vs->colorCount; ++k)
+        {
+            int start = vs->colorStart[k];
+            int end = vs->colorStart[k + 1];
+#ifdef NDL_SIMD_X86
+            // The last group holds constraints that share points with every colour and must stay sequential
+            if (useSSE2 && k < NDL_VERLET_COLORS) start = NDL_RelaxVerlet4_P(vs, start, end);
+#endif
+            NDL_RelaxVerletRange_P(vs, start, end);
+        }
+    }
+
+    if (vs->collisionGrid != NULL)
+    {
+        for (int i = 0; i < vs->pointCount; ++i)
+        {
+            if (vs->invMass[i] > 0.0f) NDL_CollideVerletPoint_P(vs, i);
+        }
+    }
+}
+
+NDL_ParticleEmitter* NDL_CreateParticleEmitter(int maxParticles, NDL_Texture* texture)
+{
+    NDL_ParticleEmitter* em = malloc(sizeof(NDL_ParticleEmitter));
+    // Lanes are padded to a multiple of 4 so the update never needs a tail
+    int padded = (maxParticles + 3) & ~3;
+    em->count = 0;
+    em->capacity = maxParticles;
+    em->x = NDL_AllocVerletLane_P(padded);
+    em->y = NDL_AllocVerletLane_P(padded);
+    em->vx = NDL_AllocVerletLane_P(padded);
+    em->vy = NDL_AllocVerletLane_P(padded);
+    em->age = NDL_AllocVerletLane_P(padded);
+    em->ageRate = NDL_AllocVerletLane_P(padded);
+    em->size = NDL_AllocVerletLane_P(padded);
+    em->color = (Uint32*)NDL_AllocVerletLane_P(padded);
+
+    em->position = (Vector2F){0, 0};
+    em->rate = 0.0f;
+    em->spawnDebt = 0.0f;
+    em->angle = -1.5707963f;
+    em->spread = 0.5f;
+    em->speedMin = 50.0f;
+    em->speedMax = 100.0f;
+    em->lifeMin = 0.5f;
+    em->lifeMax = 1.0f;
+    em->sizeMin = 2.0f;
+    em->sizeMax = 4.0f;
+    em->startColor = (NDL_Color){255, 255, 255, 255};
+    em->endColor = (NDL_Color){255, 255, 255, 0};
+    em->gravity = (Vector2F){0, 0};
+    em->drag = 0.0f;
+    em->seed = 0x9E3779B9u;
+
+    em->texture = texture;
+    em->uv = (SDL_FRect){0, 0, 1, 1};
+    em->vertexCapacity = 0;
+    em->vertices = NULL;
+    em->indices = NULL;
+    return em;
+}
+
+void NDL_DestroyParticleEmitter(NDL_ParticleEmitter* em)
+{
+    SDL_SIMDFree(em->x);
+    SDL_SIMDFree(em->y);
+    SDL_SIMDFree(em->vx);
+    SDL_SIMDFree(em->vy);
+    SDL_SIMDFree(em->age);
+    SDL_SIMDFree(em->ageRate);
+    SDL_SIMDFree(em->size);
+    SDL_SIMDFree(em->color);
+    free(em->vertices);
+    free(em->indices);
+    free(em);
+}
+
+void NDL_SetParticleEmitterPosition(NDL_ParticleEmitter* em, Vector2F position)
+{
+    em->position = position;
+}
+
+void NDL_SetParticleEmitterRate(NDL_ParticleEmitter* em, float particlesPerSecond)
+{
+    em->rate = particlesPerSecond;
+}
+
+void NDL_SetParticleLaunch(NDL_ParticleEmitter* em, float angle, float spread, float speedMin, float speedMax)
+{
+    em->angle = angle;
+    em->spread = spread;
+    em->speedMin = speedMin;
+    em->speedMax = speedMax;
+}
+
+void NDL_SetParticleLifetime(NDL_ParticleEmitter* em, float minSeconds, float maxSeconds)
+{
+    em->lifeMin = minSeconds > 0.001f ? minSeconds : 0.001f;
+    em->lifeMax = maxSeconds > em->lifeMin ? maxSeconds : em->lifeMin;
+}
+
+void NDL_SetParticleSize(NDL_ParticleEmitter* em, float minSize, float maxSize)
+{
+    em->sizeMin = minSize;
+    em->sizeMax = maxSize;
+}
+
+void NDL_SetParticleColors(NDL_ParticleEmitter* em, NDL_Color start, NDL_Color end)
+{
+    em->startColor = start;
+    em->endColor = end;
+}
+
+void NDL_SetParticleForces(NDL_ParticleEmitter* em, Vector2F gravity, float drag)
+{
+    em->gravity = gravity;
+    em->drag = drag;
+}
+
+static inline float NDL_ParticleRandom_P(NDL_ParticleEmitter* em)
+{
+    Uint32 s = em->seed;
+    s ^= s << 13;
+    s ^= s >> 17;
+    s ^= s << 5;
+    em->seed = s;
+    return (float)(s >> 8) * (1.0f / 16777216.0f);
+}
+
+int NDL_EmitParticles(NDL_ParticleEmitter* em, int count)
+{
+    if (count > em->capacity - em->count) count = em->capacity - em->count;
+    Uint32 color;
+    memcpy(&color, &em->startColor, sizeof(Uint32));
+    for (int n = 0; n < count; ++n)
+    {
+        int i = em->count++;
+        float angle = em->angle + (NDL_ParticleRandom_P(em) - 0.5f)*em->spread;
+        float speed = em->speedMin + (em->speedMax - em->speedMin)*NDL_ParticleRandom_P(em);
+        float life = em->lifeMin + (em->lifeMax - em->lifeMin)*NDL_ParticleRandom_P(em);
+        em->x[i] = em->position.x;
+        em->y[i] = em->position.y;
+        em->vx[i] = cosf(angle)*speed;
+        em->vy[i] = sinf(angle)*speed;
+        em->age[i] = 0.0f;
+        em->ageRate[i] = 1.0f / life;
+        em->size[i] = em->sizeMin + (em->sizeMax - em->sizeMin)*NDL_ParticleRandom_P(em);
+        em->color[i] = color;
+    }
+    return count;
+}
+
+static void NDL_IntegrateParticlesRange_P(NDL_ParticleEmitter* em, int start, int end, float dt, float dragFactor)
+{
+    float gx = em->gravity.x*dt, gy = em->gravity.y*dt;
+    NDL_Color s = em->startColor, e = em->endColor;
+    for (int i = start; i < end; ++i)
+    {
+        em->vx[i] = (em->vx[i] + gx)*dragFactor;
+        em->vy[i] = (em->vy[i] + gy)*dragFactor;
+        em->x[i] += em->vx[i]*dt;
+        em->y[i] += em->vy[i]*dt;
+        em->age[i] += em->ageRate[i]*dt;
+        float t = em->age[i] < 1.0f ? em->age[i] : 1.0f;
+        NDL_Color c = {
+            (Uint8)(int)(s.r + (e.r - s.r)*t + 0.5f), (Uint8)(int)(s.g + (e.g - s.g)*t + 0.5f),
+            (Uint8)(int)(s.b + (e.b - s.b)*t + 0.5f), (Uint8)(int)(s.a + (e.a - s.a)*t + 0.5f)
+        };
+        memcpy(&em->color[i], &c, sizeof(Uint32));
+    }
+}
+
+#ifdef NDL_SIMD_X86
+NDL_TARGET_SSE2 static void NDL_IntegrateParticles4_P(NDL_ParticleEmitter* em, float dt, float dragFactor)
+{
+    __m128 vdt = _mm_set1_ps(dt);
+    __m128 drag = _mm_set1_ps(dragFactor);
+    __m128 gx = _mm_set1_ps(em->gravity.x*dt), gy = _mm_set1_ps(em->gravity.y*dt);
+    __m128 one = _mm_set1_ps(1.0f), half = _mm_set1_ps(0.5f);
+    NDL_Color s = em->startColor, e = em->endColor;
+    __m128 s0 = _mm_set1_ps(s.r), d0 = _mm_set1_ps((float)(e.r - s.r));
+    __m128 s1 = _mm_set1_ps(s.g), d1 = _mm_set1_ps((float)(e.g - s.g));
+    __m128 s2 = _mm_set1_ps(s.b), d2 = _mm_set1_ps((float)(e.b - s.b));
+    __m128 s3 = _mm_set1_ps(s.a), d3 = _mm_set1_ps((float)(e.a - s.a));
+    for (int i = 0; i < em->count; i += 4)
+    {
+        __m128 vx = _mm_mul_ps(_mm_add_ps(_mm_load_ps(&em->vx[i]), gx), drag);
+        __m128 vy = _mm_mul_ps(_mm_add_ps(_mm_load_ps(&em->vy[i]), gy), drag);
+        _mm_store_ps(&em->vx[i], vx);
+        _mm_store_ps(&em->vy[i], vy);
+        _mm_store_ps(&em->x[i], _mm_add_ps(_mm_load_ps(&em->x[i]), _mm_mul_ps(vx, vdt)));
+        _mm_store_ps(&em->y[i], _mm_add_ps(_mm_load_ps(&em->y[i]), _mm_mul_ps(vy, vdt)));
+        __m128 age = _mm_add_ps(_mm_load_ps(&em->age[i]), _mm_mul_ps(_mm_load_ps(&em->ageRate[i]), vdt));
+        _mm_store_ps(&em->age[i], age);
+        // Colour channels are blended as floats and packed in SDL_Color byte order
+        __m128 t = _mm_min_ps(age, one);
+        __m128i r = _mm_cvttps_epi32(_mm_add_ps(_mm_add_ps(s0, _mm_mul_ps(d0, t)), half));
+        __m128i g = _mm_cvttps_epi32(_mm_add_ps(_mm_add_ps(s1, _mm_mul_ps(d1, t)), half));
+        __m128i b = _mm_cvttps_epi32(_mm_add_ps(_mm_add_ps(s2, _mm_mul_ps(d2, t)), half));
+        __m128i a = _mm_cvttps_epi32(_mm_add_ps(_mm_add_ps(s3, _mm_mul_ps(d3, t)), half));
+        __m128i packed = _mm_or_si128(_mm_or_si128(r, _mm_slli_epi32(g, 8)), _mm_or_si128(_mm_slli_epi32(b, 16), _mm_slli_epi32(a, 24)));
+        _mm_store_si128((__m128i*)&em->color[i], packed);
+    }
+}
+#endif
+
+void NDL_UpdateParticleEmitter(NDL_ParticleEmitter* em, float deltaTime)
+{
+    float dragFactor = 1.0f - em->drag*deltaTime;
+    if (dragFactor < 0.0f) dragFactor = 0.0f;
+#ifdef NDL_SIMD_X86
+    if (NDL_HasSSE2()) NDL_IntegrateParticles4_P(em, deltaTime, dragFactor);
+    else NDL_IntegrateParticlesRange_P(em, 0, em->count, deltaTime, dragFactor);
+#else
+    NDL_IntegrateParticlesRange_P(em, 0, em->count, deltaTime, dragFactor);
+#endif
+
+    // Swap-remove: the last particle fills the dead one's slot and is checked next
+    for (int i = 0; i < em->count; )
+    {
+        if (em->age[i] < 1.0f)
+        {
+            ++i;
+            continue;
+        }
+        int last = --em->count;
+        em->x[i] = em->x[last];
+        em->y[i] = em->y[last];
+        em->vx[i] = em->vx[last];
+        em->vy[i] = em->vy[last];
+        em->age[i] = em->age[last];
+        em->ageRate[i] = em->ageRate[last];
+        em->size[i] = em->size[last];
+        em->color[i] = em->color[last];
+    }
+
+    em->spawnDebt += em->rate*deltaTime;
+    int spawn = (int)em->spawnDebt;
+    em->spawnDebt -= (float)spawn;
+    NDL_EmitParticles(em, spawn);
+}
@@ -49,34 +49,162 @@ Renderer NDL_CreateRenderer(Window window, Uint32 flags)
     return r;
 }
 
+#define NDL_MAX_RENDER_STATES 4
+
+static NDL_RenderState NDL_RenderStates_G[NDL_MAX_RENDER_STATES];
+static int NDL_RenderStateCount_G = 0;
+
+NDL_RenderState* NDL_GetRenderState(Renderer renderer)
+{
+    for (int i = 0; i < NDL_RenderStateCount_G; ++i)
+    {
+        if (NDL_RenderStates_G[i].renderer == renderer) return &NDL_RenderStates_G[i];
+    }
+    // More renderers than slots is rare; the oldest slot is recycled with nothing cached
+    NDL_RenderState* state = &NDL_RenderStates_G[NDL_RenderStateCount_G < NDL_MAX_RENDER_STATES ? NDL_RenderStateCount_G++ : 0];
+    memset(state, 0, sizeof(NDL_RenderState));
+    state->renderer = renderer;
+    return state;
+}
+
+void NDL_InvalidateRenderState(Renderer renderer)
+{
+    NDL_RenderState* state = NDL_GetRenderState(renderer);
+    state->colorValid = false;
+    state->blendValid = false;
+    state->targetValid = false;
+    state->textureValid = false;
+}
+
+void NDL_SetDrawColor(Renderer renderer, NDL_Color color)
+{
+    NDL_RenderState* state = NDL_GetRenderState(renderer);
+    if (state->colorValid && state->color.r == color.r && state->color.g == color.g &&
+        state->color.b == color.b && state->color.a == color.a)
+    {
+        ++state->frame.redundantStates;
+        return;
+    }
+    SDL_SetRenderDrawColor(renderer, color.r, color.g, color.b, color.a);
+    state->color = color;
+    state->colorValid = true;
+    ++state->frame.stateChanges;
+}
+
+void NDL_SetDrawBlendMode(Renderer renderer, SDL_BlendMode mode)
+{
+    NDL_RenderState* state = NDL_GetRenderState(renderer);
+    if (state->blendValid && state->blend == mode)
+    {
+        ++state->frame.redundantStates;
+        return;
+    }
+    SDL_SetRenderDrawBlendMode(renderer, mode);
+    state->blend = mode;
+    state->blendValid = true;
+    ++state->frame.stateChanges;
+}
+
+// Current draw colour and blend mode, from the cache when it has them
+static NDL_Color NDL_GetDrawColor_G(Renderer renderer)
+{
+    NDL_RenderState* state = NDL_GetRenderState(renderer);
+    if (state->colorValid) return state->color;
+    NDL_Color color;
+    SDL_GetRenderDrawColor(renderer, &color.r, &color.g, &color.b, &color.a);
+    return color;
+}
+
+static SDL_BlendMode NDL_GetDrawBlendMode_G(Renderer renderer)
+{
+    NDL_RenderState* state = NDL_GetRenderState(renderer);
+    if (state->blendValid) return state->blend;
+    SDL_BlendMode mode;
+    SDL_GetRenderDrawBlendMode(renderer, &mode);
+    return mode;
+}
+
+bool NDL_SetRenderTarget(Renderer renderer, NDL_Texture* target)
+{
+    NDL_RenderState* state = NDL_GetRenderState(renderer);
+    if (state->targetValid && state->target == target)
+    {
+        ++state->frame.redundantStates;
+        return true;
+    }
+    if (SDL_SetRenderTarget(renderer, target) != 0)
+    {
+        printf("Error setting render target: %s\n", SDL_GetError());
+        state->targetValid = false;
+        return false;
+    }
+    state->target = target;
+    state->targetValid = true;
+    ++state->frame.stateChanges;
+    return true;
+}
+
+NDL_Texture* NDL_GetRenderTarget(Renderer renderer)
+{
+    NDL_RenderState* state = NDL_GetRenderState(renderer);
+    return state->targetValid ? state->target : SDL_GetRenderTarget(renderer);
+}
+
+static void NDL_CountDraw_G(Renderer renderer, NDL_Texture* texture, int vertices)
+{
+    NDL_RenderState* state = NDL_GetRenderState(renderer);
+    if (!state->textureValid || state->texture != texture) ++state->frame.textureSwitches;
+    state->texture = texture;
+    state->textureValid = true;
+    ++state->frame.drawCalls;
+    state->frame.vertices += vertices;
+}
+
+NDL_RenderStats NDL_GetRenderStats(Renderer renderer)
+{
+    return NDL_GetRenderState(renderer)->last;
+}
+
 void NDL_ClearScreen(Renderer renderer, int color[4])
 {
-    SDL_SetRenderDrawColor(renderer, color[0], color[1], color[2], color[3]);
+    NDL_SetDrawColor(renderer, (NDL_Color){color[0], color[1], color[2], color[3]});
     SDL_RenderClear(renderer);
+    NDL_CountDraw_G(renderer, NULL, 0);
 }
 
 void NDL_SendFrame(Renderer renderer)
 {
     SDL_RenderPresent(renderer);
+    NDL_RenderState* state = NDL_GetRenderState(renderer);
+    state->last = state->frame;
+    memset(&state->frame, 0, sizeof(NDL_RenderStats));
 }
 
 void NDL_BlitCircleF(Renderer renderer, int x, int y, int radius)
 {
-    for (int w = 0; w < radius * 2; w++) {
-        for (int h = 0; h < radius * 2; h++) {
-            int dx = radius - w;
-            int dy = radius - h;
-            if ((dx*dx + dy*dy) <= (radius * radius)) {
-                SDL_RenderDrawPoint(renderer, x + dx, y + dy);
-            }
+    // One horizontal span per scanline, submitted 256 scanlines per call
+    SDL_Rect spans[256];
+    int count = 0;
+    for (int dy = -radius; dy <= radius; dy++) {
+        int half = (int)sqrtf((float)(radius*radius - dy*dy));
+        spans[count++] = (SDL_Rect){x - half, y + dy, 2*half + 1, 1};
+        if (count == 256) {
+            SDL_RenderFillRects(renderer, spans, count);
+            NDL_CountDraw_G(renderer, NULL, count*4);
+            count = 0;
         }
     }
+    if (count > 0) {
+        SDL_RenderFillRects(renderer, spans, count);
+        NDL_CountDraw_G(renderer, NULL, count*4);
+    }
 }
 
 void NDL_DrawEdge(Renderer ren, NDL_Edge* edge, NDL_Color color)
 {
-    SDL_SetRenderDrawColor(ren, color.r, color.g, color.b, color.a);
+    NDL_SetDrawColor(ren, color);
     SDL_RenderDrawLineF(ren, edge->V1.x, edge->V1.y, edge->V2.x, edge->V2.y);
+    NDL_CountDraw_G(ren, NULL, 2);
 }
 
 NDL_Rect NDL_CreateRect(int w, int h, float x, float y)
@@ -116,10 +244,10 @@ void NDL_UpdateRect(NDL_Rect* r)
 
 void NDL_BlitRect(Renderer ren, NDL_Rect* r, NDL_Color color)
 {
-    NDL_DrawEdge(ren, &r->left, color);
-    NDL_DrawEdge(ren, &r->top, color);
-    NDL_DrawEdge(ren, &r->right, color);
-    NDL_DrawEdge(ren, &r->bottom, color);
+    SDL_FPoint corners[5] = {{r->x, r->y}, {r->x+r->w, r->y}, {r->x+r->w, r->y+r->h}, {r->x, r->y+r->h}, {r->x, r->y}};
+    NDL_SetDrawColor(ren, color);
+    SDL_RenderDrawLinesF(ren, corners, 5);
+    NDL_CountDraw_G(ren, NULL, 5);
 }
 
 void NDL_ToggleBorderless(Window window)
@@ -136,13 +264,15 @@ void NDL_ToggleBorderless(Window window)
 
 void NDL_FillRect(Renderer ren, Rect* rect, NDL_Color color)
 {
-    SDL_SetRenderDrawColor(ren, color.r,color.g,color.b,color.a);
+    NDL_SetDrawColor(ren, color);
     SDL_RenderFillRect(ren, rect);
+    NDL_CountDraw_G(ren, NULL, 4);
 }
 
 void NDL_BlitTexture(Renderer ren, NDL_Texture* image, Rect* rect)
 {
     SDL_RenderCopy(ren, image, NULL, rect);
+    NDL_CountDraw_G(ren, image, 4);
 }
 
 void NDL_BlitColliderComponent(Renderer ren, NDL_ColliderComponent* collider, NDL_Color color)
@@ -150,128 +280,3988 @@ void NDL_BlitColliderComponent(Renderer ren, NDL_ColliderComponent* collider, ND
     NDL_BlitRect(ren, &collider->r, color);
 }
 
-void NDL_Render(NDL_RenderSystem* renSys, float deltaTime)
+NDL_PrimitiveBatch* NDL_CreatePrimitiveBatch(Renderer renderer)
 {
-    NDL_Pool* pool = renSys->pool;
-    Renderer ren = renSys->sdlRenderer;
-    int clearColor[4] = {renSys->clearColor.r, renSys->clearColor.g, renSys->clearColor.b, renSys->clearColor.a};
-    NDL_ClearScreen(renSys->sdlRenderer, clearColor);
-    for (int i = 0; i < pool->size; i++)
-    {
-        if (NDL_HasComponent(pool->entities[i], SPRITE_COMPONENT))
-        {
-            Rect renderRect;
-            renderRect.x = (int)pool->entities[i]->sprite->imageRect.x;// - cam->position.x;
-            renderRect.y = (int)pool->entities[i]->sprite->imageRect.y;// - cam->position.y;
-            renderRect.w = (int)pool->entities[i]->sprite->imageRect.w;
-            renderRect.h = (int)pool->entities[i]->sprite->imageRect.h;
-            if (pool->entities[i]->sprite->image == NULL) NDL_FillRect(ren, &pool->entities[i]->sprite->imageRect, pool->entities[i]->sprite->color);
-            
-            if (NDL_HasComponent(pool->entities[i], ANIMATION_COMPONENT))
-            {
-                NDL_AnimationComponent* anim = pool->entities[i]->sprite->animation;
-                pool->entities[i]->sprite->image = anim->flip(anim, deltaTime);
-                NDL_BlitTexture(ren, pool->entities[i]->sprite->image, &renderRect);
-            } else {
-                NDL_BlitTexture(ren, pool->entities[i]->sprite->image, &renderRect);
-            }
+    NDL_PrimitiveBatch* batch = malloc(sizeof(NDL_PrimitiveBatch));
+    batch->sdlRenderer = renderer;
+    batch->groupCount = 0;
+    batch->groupCapacity = 8;
+    batch->groups = malloc(sizeof(NDL_PrimitiveGroup)*batch->groupCapacity);
+    batch->lastGroup = -1;
+    batch->vertexCount = 0;
+    batch->vertexCapacity = 256;
+    batch->vertices = malloc(sizeof(SDL_Vertex)*batch->vertexCapacity);
+    batch->indexCount = 0;
+    batch->indexCapacity = 768;
+    batch->indices = malloc(sizeof(int)*batch->indexCapacity);
+    batch->lineVertexCount = 0;
+    batch->lineVertexCapacity = 256;
+    batch->lineVertices = malloc(sizeof(SDL_Vertex)*batch->lineVertexCapacity);
+    batch->lineIndexCount = 0;
+    batch->lineIndexCapacity = 384;
+    batch->lineIndices = malloc(sizeof(int)*batch->lineIndexCapacity);
+    batch->drawCalls = 0;
+    batch->soft = NULL;
+    return batch;
+}
 
-            if (NDL_HasComponent(pool->entities[i], COLLIDER_COMPONENT) & renSys->showColliders)
-            {
-                NDL_BlitColliderComponent(ren, pool->entities[i]->collider, pool->entities[i]->sprite->color);
-            }
+void NDL_DestroyPrimitiveBatch(NDL_PrimitiveBatch* batch)
+{
+    for (int g = 0; g < batch->groupCount; ++g)
+    {
+        free(batch->groups[g].outlines);
+        free(batch->groups[g].fills);
+    }
+    free(batch->groups);
+    free(batch->vertices);
+    free(batch->indices);
+    free(batch->lineVertices);
+    free(batch->lineIndices);
+    free(batch);
+}
+
+static NDL_PrimitiveGroup* NDL_GetPrimitiveGroup_G(NDL_PrimitiveBatch* batch, NDL_Color color)
+{
+    int g = batch->lastGroup;
+    if (g >= 0)
+    {
+        NDL_Color c = batch->groups[g].color;
+        if (c.r == color.r && c.g == color.g && c.b == color.b && c.a == color.a) return &batch->groups[g];
+    }
+    for (g = 0; g < batch->groupCount; ++g)
+    {
+        NDL_Color c = batch->groups[g].color;
+        if (c.r == color.r && c.g == color.g && c.b == color.b && c.a == color.a) break;
+    }
+    if (g == batch->groupCount)
+    {
+        if (batch->groupCount == batch->groupCapacity)
+        {
+            batch->groupCapacity *= 2;
+            batch->groups = realloc(batch->groups, sizeof(NDL_PrimitiveGroup)*batch->groupCapacity);
         }
+        NDL_PrimitiveGroup* group = &batch->groups[batch->groupCount++];
+        group->color = color;
+        group->outlineCount = 0;
+        group->outlineCapacity = 64;
+        group->outlines = malloc(sizeof(SDL_FRect)*group->outlineCapacity);
+        group->fillCount = 0;
+        group->fillCapacity = 64;
+        group->fills = malloc(sizeof(SDL_FRect)*group->fillCapacity);
     }
+    batch->lastGroup = g;
+    return &batch->groups[g];
 }
 
-NDL_RenderSystem* NDL_CreateRenderSystem(Renderer sdlRenderer, NDL_Color clearColor)
+// Appends a line as a one-pixel-wide quad, so every line of every colour shares one geometry call
+static void NDL_PushLineQuad_G(NDL_PrimitiveBatch* batch, float x0, float y0, float x1, float y1, NDL_Color color)
 {
-    NDL_RenderSystem* renSys = malloc(sizeof(NDL_RenderSystem));
-    renSys->pool = NDL_CreatePool(1);
-    renSys->showColliders = false;
-    renSys->renderSpace = false;
-    renSys->clearColor = clearColor;
-    renSys->sdlRenderer = sdlRenderer;
-    renSys->render = NDL_Render;
-    return renSys;
+    float dx = x1 - x0, dy = y1 - y0;
+    float length = sqrtf(dx*dx + dy*dy);
+    if (length == 0.0f) return;
+    if (batch->lineVertexCount + 4 > batch->lineVertexCapacity)
+    {
+        batch->lineVertexCapacity *= 2;
+        batch->lineVertices = realloc(batch->lineVertices, sizeof(SDL_Vertex)*batch->lineVertexCapacity);
+    }
+    if (batch->lineIndexCount + 6 > batch->lineIndexCapacity)
+    {
+        batch->lineIndexCapacity *= 2;
+        batch->lineIndices = realloc(batch->lineIndices, sizeof(int)*batch->lineIndexCapacity);
+    }
+    // Half a pixel either side of the line, along its normal
+    float nx = -dy/length*0.5f, ny = dx/length*0.5f;
+    int first = batch->lineVertexCount;
+    SDL_Vertex* v = batch->lineVertices + first;
+    v[0] = (SDL_Vertex){{x0 + nx, y0 + ny}, color, {0, 0}};
+    v[1] = (SDL_Vertex){{x1 + nx, y1 + ny}, color, {0, 0}};
+    v[2] = (SDL_Vertex){{x1 - nx, y1 - ny}, color, {0, 0}};
+    v[3] = (SDL_Vertex){{x0 - nx, y0 - ny}, color, {0, 0}};
+    batch->lineVertexCount += 4;
+    int* i = batch->lineIndices + batch->lineIndexCount;
+    i[0] = first; i[1] = first + 1; i[2] = first + 2;
+    i[3] = first + 2; i[4] = first + 3; i[5] = first;
+    batch->lineIndexCount += 6;
 }
 
-NDL_ImageSet* NDL_CreateImageSet_PNG(Renderer ren, const char* fp)
+void NDL_BatchLine(NDL_PrimitiveBatch* batch, float x0, float y0, float x1, float y1, NDL_Color color)
 {
-    WIN32_FIND_DATA findFileData;
-    HANDLE hFind = INVALID_HANDLE_VALUE;
-    DWORD dwError = 0;
-    int imageCount = 0;
-    char searchPath[MAX_PATH];
+    NDL_PushLineQuad_G(batch, x0, y0, x1, y1, color);
+}
 
-    // Create a search path for .png files
-    sprintf(searchPath, "%s\\*.png", fp);
-    hFind = FindFirstFile(searchPath, &findFileData);
+void NDL_BatchRectOutline(NDL_PrimitiveBatch* batch, SDL_FRect rect, NDL_Color color)
+{
+    NDL_PrimitiveGroup* group = NDL_GetPrimitiveGroup_G(batch, color);
+    if (group->outlineCount == group->outlineCapacity)
+    {
+        group->outlineCapacity *= 2;
+        group->outlines = realloc(group->outlines, sizeof(SDL_FRect)*group->outlineCapacity);
+    }
+    group->outlines[group->outlineCount++] = rect;
+}
 
-    if (hFind == INVALID_HANDLE_VALUE) {
-        printf("No .png files found.\n");
-        return NULL;
-    } 
+void NDL_BatchRectFilled(NDL_PrimitiveBatch* batch, SDL_FRect rect, NDL_Color color)
+{
+    NDL_PrimitiveGroup* group = NDL_GetPrimitiveGroup_G(batch, color);
+    if (group->fillCount == group->fillCapacity)
+    {
+        group->fillCapacity *= 2;
+        group->fills = realloc(group->fills, sizeof(SDL_FRect)*group->fillCapacity);
+    }
+    group->fills[group->fillCount++] = rect;
+}
 
-    // Count .png files
-    do {
-        if (!(findFileData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)) {
-            imageCount++;
+static int NDL_CircleSegments_G(float radius)
+{
+    // About one segment per 6px of circumference keeps edges smooth without wasting vertices
+    int segments = (int)ceilf(6.2831853f*radius / 6.0f);
+    return segments < 12 ? 12 : (segments > 64 ? 64 : segments);
+}
+
+void NDL_BatchCircleOutline(NDL_PrimitiveBatch* batch, float cx, float cy, float radius, NDL_Color color)
+{
+    int segments = NDL_CircleSegments_G(radius);
+    SDL_FPoint previous = {cx + radius, cy};
+    for (int i = 1; i <= segments; ++i)
+    {
+        float a = 6.2831853f*i/segments;
+        SDL_FPoint p = {cx + cosf(a)*radius, cy + sinf(a)*radius};
+        NDL_PushLineQuad_G(batch, previous.x, previous.y, p.x, p.y, color);
+        previous = p;
+    }
+}
+
+void NDL_BatchCircleFilled(NDL_PrimitiveBatch* batch, float cx, float cy, float radius, NDL_Color color)
+{
+    int segments = NDL_CircleSegments_G(radius);
+    if (batch->vertexCount + segments + 1 > batch->vertexCapacity)
+    {
+        while (batch->vertexCount + segments + 1 > batch->vertexCapacity) batch->vertexCapacity *= 2;
+        batch->vertices = realloc(batch->vertices, sizeof(SDL_Vertex)*batch->vertexCapacity);
+    }
+    if (batch->indexCount + segments*3 > batch->indexCapacity)
+    {
+        while (batch->indexCount + segments*3 > batch->indexCapacity) batch->indexCapacity *= 2;
+        batch->indices = realloc(batch->indices, sizeof(int)*batch->indexCapacity);
+    }
+    // Triangle fan around the centre, emitted as an indexed triangle list
+    int centre = batch->vertexCount;
+    batch->vertices[batch->vertexCount++] = (SDL_Vertex){{cx, cy}, color, {0, 0}};
+    for (int i = 0; i < segments; ++i)
+    {
+        float a = 6.2831853f*i/segments;
+        batch->vertices[batch->vertexCount++] = (SDL_Vertex){{cx + cosf(a)*radius, cy + sinf(a)*radius}, color, {0, 0}};
+        batch->indices[batch->indexCount++] = centre;
+        batch->indices[batch->indexCount++] = centre + 1 + i;
+        batch->indices[batch->indexCount++] = centre + 1 + (i + 1) % segments;
+    }
+}
+
+void NDL_BatchCapsuleOutline(NDL_PrimitiveBatch* batch, SDL_FRect bounds, NDL_Color color)
+{
+    bool horizontal = bounds.w >= bounds.h;
+    float radius = (horizontal ? bounds.h : bounds.w) / 2.0f;
+    // Cap centres, and the angle the first cap's arc starts at; the arcs' ends join into the sides
+    float ax, ay, bx, by, start;
+    if (horizontal)
+    {
+        ax = bounds.x + bounds.w - radius; ay = bounds.y + radius;
+        bx = bounds.x + radius; by = ay;
+        start = -1.5707963f;
+    } else {
+        ax = bounds.x + radius; ay = bounds.y + bounds.h - radius;
+        bx = ax; by = bounds.y + radius;
+        start = 0.0f;
+    }
+    int half = NDL_CircleSegments_G(radius) / 2;
+    // NDL_CircleSegments_G gives at most 64 segments, so each cap has at most 32
+    SDL_FPoint p[2*(64/2 + 1) + 1];
+    for (int i = 0; i <= half; ++i)
+    {
+        float a = start + 3.1415927f*i/half;
+        p[i] = (SDL_FPoint){ax + cosf(a)*radius, ay + sinf(a)*radius};
+        p[half + 1 + i] = (SDL_FPoint){bx + cosf(a + 3.1415927f)*radius, by + sinf(a + 3.1415927f)*radius};
+    }
+    p[2*(half + 1)] = p[0];
+    for (int i = 0; i < 2*(half + 1); ++i) NDL_PushLineQuad_G(batch, p[i].x, p[i].y, p[i + 1].x, p[i + 1].y, color);
+}
+
+static void NDL_BatchColliderOutlineZoomed_G(NDL_PrimitiveBatch* batch, NDL_ColliderComponent* collider, Vector2F offset, float zoom, NDL_Color color)
+{
+    NDL_Rect* r = &collider->r;
+    SDL_FRect bounds = {(r->x - offset.x)*zoom, (r->y - offset.y)*zoom, r->w*zoom, r->h*zoom};
+    switch (collider->shape)
+    {
+        case CIRCLE_COLLIDER:
+            NDL_BatchCircleOutline(batch, bounds.x + collider->radius*zoom, bounds.y + collider->radius*zoom, collider->radius*zoom, color);
+            break;
+        case CAPSULE_COLLIDER:
+            NDL_BatchCapsuleOutline(batch, bounds, color);
+            break;
+        default:
+            NDL_BatchRectOutline(batch, bounds, color);
+            break;
+    }
+}
+
+void NDL_BatchColliderOutline(NDL_PrimitiveBatch* batch, NDL_ColliderComponent* collider, Vector2F offset, NDL_Color color)
+{
+    NDL_BatchColliderOutlineZoomed_G(batch, collider, offset, 1.0f, color);
+}
+
+static void NDL_FlushPrimitiveBatchSoft_G(NDL_PrimitiveBatch* batch)
+{
+    // The CPU rasterizer only draws axis-aligned quads, so lines and circle geometry are dropped
+    for (int g = 0; g < batch->groupCount; ++g)
+    {
+        NDL_PrimitiveGroup* group = &batch->groups[g];
+        for (int i = 0; i < group->fillCount; ++i) NDL_SoftQueueQuad(batch->soft, NULL, NULL, &group->fills[i], group->color);
+        for (int i = 0; i < group->outlineCount; ++i)
+        {
+            SDL_FRect r = group->outlines[i];
+            SDL_FRect edges[4] = {
+                {r.x, r.y, r.w, 1}, {r.x, r.y + r.h - 1, r.w, 1},
+                {r.x, r.y + 1, 1, r.h - 2}, {r.x + r.w - 1, r.y + 1, 1, r.h - 2}
+            };
+            for (int k = 0; k < 4; ++k) NDL_SoftQueueQuad(batch->soft, NULL, NULL, &edges[k], group->color);
         }
-    } while (FindNextFile(hFind, &findFileData) != 0);
+        group->fillCount = 0;
+        group->outlineCount = 0;
+    }
+    batch->vertexCount = 0;
+    batch->indexCount = 0;
+    batch->lineVertexCount = 0;
+    batch->lineIndexCount = 0;
+    batch->drawCalls = 0;
+}
 
-    FindClose(hFind);
+int NDL_FlushPrimitiveBatch(NDL_PrimitiveBatch* batch)
+{
+    if (batch->soft != NULL)
+    {
+        NDL_FlushPrimitiveBatchSoft_G(batch);
+        return 0;
+    }
+    Renderer ren = batch->sdlRenderer;
+    int drawCalls = 0;
+    if (batch->indexCount > 0)
+    {
+        SDL_RenderGeometry(ren, NULL, batch->vertices, batch->vertexCount, batch->indices, batch->indexCount);
+        NDL_CountDraw_G(ren, NULL, batch->vertexCount);
+        ++drawCalls;
+    }
+    for (int g = 0; g < batch->groupCount; ++g)
+    {
+        NDL_PrimitiveGroup* group = &batch->groups[g];
+        if (group->fillCount == 0 && group->outlineCount == 0) continue;
+        NDL_SetDrawColor(ren, group->color);
+        if (group->fillCount > 0)
+        {
+            SDL_RenderFillRectsF(ren, group->fills, group->fillCount);
+            NDL_CountDraw_G(ren, NULL, group->fillCount*4);
+            ++drawCalls;
+        }
+        if (group->outlineCount > 0)
+        {
+            SDL_RenderDrawRectsF(ren, group->outlines, group->outlineCount);
+            NDL_CountDraw_G(ren, NULL, group->outlineCount*4);
+            ++drawCalls;
+        }
+        group->fillCount = 0;
+        group->outlineCount = 0;
+    }
+    if (batch->lineIndexCount > 0)
+    {
+        SDL_RenderGeometry(ren, NULL, batch->lineVertices, batch->lineVertexCount, batch->lineIndices, batch->lineIndexCount);
+        NDL_CountDraw_G(ren, NULL, batch->lineVertexCount);
+        ++drawCalls;
+    }
+    batch->vertexCount = 0;
+    batch->indexCount = 0;
+    batch->lineVertexCount = 0;
+    batch->lineIndexCount = 0;
+    batch->drawCalls = drawCalls;
+    return drawCalls;
+}
 
-    // Allocate memory for NDL_ImageSet and its images array
-    NDL_ImageSet* imageSet = malloc(sizeof(NDL_ImageSet));
-    imageSet->images = malloc(sizeof(NDL_Texture*) * imageCount);
-    imageSet->imageCount = imageCount;
+// x*y/255 with exact rounding for x, y in [0, 255]; the SIMD kernels use the same formula
+static inline Uint32 NDL_MulDiv255_G(Uint32 x, Uint32 y)
+{
+    Uint32 t = x*y + 128;
+    return (t + (t >> 8)) >> 8;
+}
 
-    // Iterate over files again to create textures
-    hFind = FindFirstFile(searchPath, &findFileData);
+static inline Uint32 NDL_Modulate_G(Uint32 texel, Uint32 mod)
+{
+    return NDL_MulDiv255_G(texel & 0xFF, mod & 0xFF)
+         | NDL_MulDiv255_G((texel >> 8) & 0xFF, (mod >> 8) & 0xFF) << 8
+         | NDL_MulDiv255_G((texel >> 16) & 0xFF, (mod >> 16) & 0xFF) << 16
+         | NDL_MulDiv255_G(texel >> 24, mod >> 24) << 24;
+}
+
+// SDL_BLENDMODE_BLEND on ARGB8888: rgb = s*a + d*(1-a), alpha = a + d*(1-a)
+static inline Uint32 NDL_BlendPixel_G(Uint32 s, Uint32 d)
+{
+    Uint32 a = s >> 24;
+    Uint32 ia = 255 - a;
+    Uint32 out = 0;
+    for (int shift = 0; shift < 24; shift += 8)
+    {
+        Uint32 t = ((s >> shift) & 0xFF)*a + ((d >> shift) & 0xFF)*ia + 128;
+        out |= ((t + (t >> 8)) >> 8) << shift;
+    }
+    Uint32 t = a*255 + (d >> 24)*ia + 128;
+    return out | ((t + (t >> 8)) >> 8) << 24;
+}
+
+static Uint32 NDL_BilinearSample_G(const NDL_Surface* tex, int fx, int fy)
+{
+    // fx, fy are 24.8 fixed point texel coordinates measured from texel centres
+    int x0 = fx >> 8, y0 = fy >> 8;
+    int wx = fx & 0xFF, wy = fy & 0xFF;
+    int x1 = x0 + 1, y1 = y0 + 1;
+    if (x0 < 0) x0 = 0;
+    if (y0 < 0) y0 = 0;
+    if (x1 > tex->w - 1) x1 = tex->w - 1;
+    if (y1 > tex->h - 1) y1 = tex->h - 1;
+    if (x0 > tex->w - 1) x0 = tex->w - 1;
+    if (y0 > tex->h - 1) y0 = tex->h - 1;
+    const Uint32* r0 = (const Uint32*)((const Uint8*)tex->pixels + y0*tex->pitch);
+    const Uint32* r1 = (const Uint32*)((const Uint8*)tex->pixels + y1*tex->pitch);
+    Uint32 c00 = r0[x0], c10 = r0[x1], c01 = r1[x0], c11 = r1[x1];
+    Uint32 out = 0;
+    for (int shift = 0; shift < 32; shift += 8)
+    {
+        Uint32 top = (((c00 >> shift) & 0xFF)*(256 - wx) + ((c10 >> shift) & 0xFF)*wx) >> 8;
+        Uint32 bottom = (((c01 >> shift) & 0xFF)*(256 - wx) + ((c11 >> shift) & 0xFF)*wx) >> 8;
+        out |= ((top*(256 - wy) + bottom*wy) >> 8) << shift;
+    }
+    return out;
+}
+
+typedef void (*NDL_FillSpanMethod) (Uint32*, int, Uint32);
+typedef void (*NDL_TexSpanMethod) (Uint32*, const Uint32*, int, Sint32, Sint32, int, Uint32);
+
+static void NDL_FillSpan_Scalar_G(Uint32* dst, int count, Uint32 color)
+{
+    if ((color >> 24) == 255)
+    {
+        for (int i = 0; i < count; ++i) dst[i] = color;
+        return;
+    }
+    for (int i = 0; i < count; ++i) dst[i] = NDL_BlendPixel_G(color, dst[i]);
+}
+
+// Nearest-neighbour textured span: u is 16.16 fixed point, mod is the ARGB modulation colour
+static void NDL_TexSpan_Scalar_G(Uint32* dst, const Uint32* srcRow, int count, Sint32 u, Sint32 du, int srcW, Uint32 mod)
+{
+    for (int i = 0; i < count; ++i, u += du)
+    {
+        int x = u >> 16;
+        if (x > srcW - 1) x = srcW - 1;
+        Uint32 texel = srcRow[x];
+        if (mod != 0xFFFFFFFF) texel = NDL_Modulate_G(texel, mod);
+        dst[i] = NDL_BlendPixel_G(texel, dst[i]);
+    }
+}
+
+#ifdef NDL_SIMD_X86
+// Four ARGB pixels widened to 16-bit lanes two at a time; every step mirrors the scalar formula
+NDL_TARGET_SSE2 static inline __m128i NDL_MulDiv255x8_G(__m128i x, __m128i y)
+{
+    __m128i t = _mm_add_epi16(_mm_mullo_epi16(x, y), _mm_set1_epi16(128));
+    return _mm_srli_epi16(_mm_add_epi16(t, _mm_srli_epi16(t, 8)), 8);
+}
+
+NDL_TARGET_SSE2 static inline __m128i NDL_Blend2x16_G(__m128i s, __m128i d)
+{
+    __m128i a = _mm_shufflehi_epi16(_mm_shufflelo_epi16(s, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+    __m128i alphaLanes = _mm_set_epi16(255, 0, 0, 0, 255, 0, 0, 0);
+    __m128i rgbMask = _mm_set_epi16(0, -1, -1, -1, 0, -1, -1, -1);
+    __m128i f = _mm_or_si128(_mm_and_si128(a, rgbMask), alphaLanes);
+    __m128i ia = _mm_sub_epi16(_mm_set1_epi16(255), a);
+    __m128i t = _mm_add_epi16(_mm_add_epi16(_mm_mullo_epi16(s, f), _mm_mullo_epi16(d, ia)), _mm_set1_epi16(128));
+    return _mm_srli_epi16(_mm_add_epi16(t, _mm_srli_epi16(t, 8)), 8);
+}
+
+NDL_TARGET_SSE2 static inline __m128i NDL_Blend4_G(__m128i src, __m128i dst, __m128i mod, bool modulate)
+{
+    __m128i zero = _mm_setzero_si128();
+    __m128i sLo = _mm_unpacklo_epi8(src, zero), sHi = _mm_unpackhi_epi8(src, zero);
+    if (modulate)
+    {
+        __m128i m = _mm_unpacklo_epi8(mod, zero);
+        sLo = NDL_MulDiv255x8_G(sLo, m);
+        sHi = NDL_MulDiv255x8_G(sHi, m);
+    }
+    __m128i lo = NDL_Blend2x16_G(sLo, _mm_unpacklo_epi8(dst, zero));
+    __m128i hi = NDL_Blend2x16_G(sHi, _mm_unpackhi_epi8(dst, zero));
+    return _mm_packus_epi16(lo, hi);
+}
+
+NDL_TARGET_SSE2 static void NDL_FillSpan_SSE2_G(Uint32* dst, int count, Uint32 color)
+{
+    __m128i c = _mm_set1_epi32((int)color);
     int i = 0;
-    do {
-        if (!(findFileData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)) {
-            char imagePath[MAX_PATH];
-            sprintf(imagePath, "%s\\%s", fp, findFileData.cFileName);
-            imageSet->images[i] = NDL_CreateTexture(ren, imagePath);
-            i++;
+    if ((color >> 24) == 255)
+    {
+        for (; i + 4 <= count; i += 4) _mm_storeu_si128((__m128i*)(dst + i), c);
+    } else {
+        for (; i + 4 <= count; i += 4)
+        {
+            __m128i d = _mm_loadu_si128((const __m128i*)(dst + i));
+            _mm_storeu_si128((__m128i*)(dst + i), NDL_Blend4_G(c, d, c, false));
         }
-    } while (FindNextFile(hFind, &findFileData) != 0);
+    }
+    NDL_FillSpan_Scalar_G(dst + i, count - i, color);
+}
 
-    FindClose(hFind);
-    return imageSet;
+NDL_TARGET_SSE2 static void NDL_TexSpan_SSE2_G(Uint32* dst, const Uint32* srcRow, int count, Sint32 u, Sint32 du, int srcW, Uint32 mod)
+{
+    __m128i m = _mm_set1_epi32((int)mod);
+    bool modulate = mod != 0xFFFFFFFF;
+    int i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        // SSE2 has no gather; fetch the four texels, then blend them together
+        Uint32 t[4];
+        for (int k = 0; k < 4; ++k, u += du)
+        {
+            int x = u >> 16;
+            t[k] = srcRow[x > srcW - 1 ? srcW - 1 : x];
+        }
+        __m128i s = _mm_loadu_si128((const __m128i*)t);
+        __m128i d = _mm_loadu_si128((const __m128i*)(dst + i));
+        _mm_storeu_si128((__m128i*)(dst + i), NDL_Blend4_G(s, d, m, modulate));
+    }
+    NDL_TexSpan_Scalar_G(dst + i, srcRow, count - i, u, du, srcW, mod);
 }
 
-NDL_Texture* NDL_AnimationFlip(NDL_AnimationComponent* anim, float deltaTime)
+NDL_TARGET_AVX2 static inline __m256i NDL_MulDiv255x16_G(__m256i x, __m256i y)
 {
-    static float timeAccumulator = 0;
-    timeAccumulator += deltaTime;
+    __m256i t = _mm256_add_epi16(_mm256_mullo_epi16(x, y), _mm256_set1_epi16(128));
+    return _mm256_srli_epi16(_mm256_add_epi16(t, _mm256_srli_epi16(t, 8)), 8);
+}
 
-    // Calculate the time threshold for frame flip based on flipRate
-    float flipThreshold = 1.0 / anim->flipRate;
+NDL_TARGET_AVX2 static inline __m256i NDL_Blend4x16_G(__m256i s, __m256i d)
+{
+    __m256i a = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(s, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+    __m256i alphaLanes = _mm256_set_epi16(255, 0, 0, 0, 255, 0, 0, 0, 255, 0, 0, 0, 255, 0, 0, 0);
+    __m256i rgbMask = _mm256_set_epi16(0, -1, -1, -1, 0, -1, -1, -1, 0, -1, -1, -1, 0, -1, -1, -1);
+    __m256i f = _mm256_or_si256(_mm256_and_si256(a, rgbMask), alphaLanes);
+    __m256i ia = _mm256_sub_epi16(_mm256_set1_epi16(255), a);
+    __m256i t = _mm256_add_epi16(_mm256_add_epi16(_mm256_mullo_epi16(s, f), _mm256_mullo_epi16(d, ia)), _mm256_set1_epi16(128));
+    return _mm256_srli_epi16(_mm256_add_epi16(t, _mm256_srli_epi16(t, 8)), 8);
+}
 
-    if (timeAccumulator >= flipThreshold) {
-        timeAccumulator = 0; // Reset the accumulator
+NDL_TARGET_AVX2 static inline __m256i NDL_Blend8_G(__m256i src, __m256i dst, __m256i mod, bool modulate)
+{
+    // The unpacks work within 128-bit lanes and packus undoes them the same way, so order is kept
+    __m256i zero = _mm256_setzero_si256();
+    __m256i sLo = _mm256_unpacklo_epi8(src, zero), sHi = _mm256_unpackhi_epi8(src, zero);
+    if (modulate)
+    {
+        __m256i m = _mm256_unpacklo_epi8(mod, zero);
+        sLo = NDL_MulDiv255x16_G(sLo, m);
+        sHi = NDL_MulDiv255x16_G(sHi, m);
+    }
+    __m256i lo = NDL_Blend4x16_G(sLo, _mm256_unpacklo_epi8(dst, zero));
+    __m256i hi = NDL_Blend4x16_G(sHi, _mm256_unpackhi_epi8(dst, zero));
+    return _mm256_packus_epi16(lo, hi);
+}
 
-        if (anim->currentFrame < anim->imageSet->imageCount - 1) {
-            ++anim->currentFrame;
-        } else if (anim->loop) {
-            anim->currentFrame = 0;
+NDL_TARGET_AVX2 static void NDL_FillSpan_AVX2_G(Uint32* dst, int count, Uint32 color)
+{
+    __m256i c = _mm256_set1_epi32((int)color);
+    int i = 0;
+    if ((color >> 24) == 255)
+    {
+        for (; i + 8 <= count; i += 8) _mm256_storeu_si256((__m256i*)(dst + i), c);
+    } else {
+        for (; i + 8 <= count; i += 8)
+        {
+            __m256i d = _mm256_loadu_si256((const __m256i*)(dst + i));
+            _mm256_storeu_si256((__m256i*)(dst + i), NDL_Blend8_G(c, d, c, false));
         }
-        // If not looping, keep the last frame
     }
+    NDL_FillSpan_Scalar_G(dst + i, count - i, color);
+}
 
-    return anim->imageSet->images[anim->currentFrame];
+NDL_TARGET_AVX2 static void NDL_TexSpan_AVX2_G(Uint32* dst, const Uint32* srcRow, int count, Sint32 u, Sint32 du, int srcW, Uint32 mod)
+{
+    __m256i m = _mm256_set1_epi32((int)mod);
+    bool modulate = mod != 0xFFFFFFFF;
+    __m256i steps = _mm256_mullo_epi32(_mm256_set_epi32(7, 6, 5, 4, 3, 2, 1, 0), _mm256_set1_epi32(du));
+    __m256i maxX = _mm256_set1_epi32(srcW - 1);
+    int i = 0;
+    for (; i + 8 <= count; i += 8, u += 8*du)
+    {
+        __m256i x = _mm256_srai_epi32(_mm256_add_epi32(_mm256_set1_epi32(u), steps), 16);
+        x = _mm256_min_epi32(x, maxX);
+        __m256i s = _mm256_i32gather_epi32((const int*)srcRow, x, 4);
+        __m256i d = _mm256_loadu_si256((const __m256i*)(dst + i));
+        _mm256_storeu_si256((__m256i*)(dst + i), NDL_Blend8_G(s, d, m, modulate));
+    }
+    NDL_TexSpan_Scalar_G(dst + i, srcRow, count - i, u, du, srcW, mod);
 }
+#endif
 
-NDL_AnimationComponent* NDL_CreateAnimation(bool loop, int flipRate)
+NDL_SoftRenderer* NDL_CreateSoftRenderer(int w, int h, NDL_ThreadPool* pool)
 {
-    NDL_AnimationComponent* anim = malloc(sizeof(NDL_AnimationComponent));
-    anim->loop = loop;
-    anim->imageSet = NULL;
-    anim->currentFrame = 0;
-    anim->flipRate = flipRate;
-    anim->flip = NDL_AnimationFlip;
-    return anim;
+    NDL_Surface* target = SDL_CreateRGBSurfaceWithFormat(0, w, h, 32, SDL_PIXELFORMAT_ARGB8888);
+    if (target == NULL)
+    {
+        printf("Error creating soft render target: %s\n", SDL_GetError());
+        return NULL;
+    }
+    NDL_SoftRenderer* soft = malloc(sizeof(NDL_SoftRenderer));
+    soft->target = target;
+    soft->pool = pool;
+    soft->bandHeight = 32;
+    soft->bilinear = false;
+    soft->simdLevel = 0;
+#ifdef NDL_SIMD_X86
+    if (NDL_HasAVX2()) soft->simdLevel = 2;
+    else if (NDL_HasSSE2()) soft->simdLevel = 1;
+#endif
+    soft->clearColor = (NDL_Color){0, 0, 0, 255};
+    soft->clearPending = false;
+    soft->commandCount = 0;
+    soft->commandCapacity = 1024;
+    soft->commands = malloc(sizeof(NDL_SoftCommand)*soft->commandCapacity);
+    soft->textureCount = 0;
+    soft->textureCapacity = 64;
+    soft->textureKeys = calloc(soft->textureCapacity, sizeof(NDL_Texture*));
+    soft->textureSurfaces = malloc(sizeof(NDL_Surface*)*soft->textureCapacity);
+    soft->missingTextures = 0;
+    return soft;
+}
+
+void NDL_DestroySoftRenderer(NDL_SoftRenderer* soft)
+{
+    for (int i = 0; i < soft->textureCapacity; ++i)
+    {
+        if (soft->textureKeys[i] != NULL) SDL_FreeSurface(soft->textureSurfaces[i]);
+    }
+    SDL_FreeSurface(soft->target);
+    free(soft->commands);
+    free(soft->textureKeys);
+    free(soft->textureSurfaces);
+    free(soft);
+}
+
+void NDL_SetSoftRendererFiltering(NDL_SoftRenderer* soft, bool bilinear)
+{
+    soft->bilinear = bilinear;
+}
+
+void NDL_SetSoftRendererSIMD(NDL_SoftRenderer* soft, int level)
+{
+    int supported = 0;
+#ifdef NDL_SIMD_X86
+    if (NDL_HasAVX2()) supported = 2;
+    else if (NDL_HasSSE2()) supported = 1;
+#endif
+    soft->simdLevel = level < supported ? (level < 0 ? 0 : level) : supported;
+}
+
+static Uint32 NDL_SoftTextureSlot_G(NDL_SoftRenderer* soft, NDL_Texture* texture)
+{
+    Uint32 mask = soft->textureCapacity - 1;
+    Uint32 slot = (Uint32)(((uintptr_t)texture >> 4) * 2654435761u) & mask;
+    while (soft->textureKeys[slot] != NULL && soft->textureKeys[slot] != texture) slot = (slot + 1) & mask;
+    return slot;
+}
+
+static NDL_Surface* NDL_FindSoftTexture_G(NDL_SoftRenderer* soft, NDL_Texture* texture)
+{
+    Uint32 slot = NDL_SoftTextureSlot_G(soft, texture);
+    return soft->textureKeys[slot] != NULL ? soft->textureSurfaces[slot] : NULL;
+}
+
+bool NDL_RegisterSoftTexture(NDL_SoftRenderer* soft, NDL_Texture* texture, NDL_Surface* pixels)
+{
+    NDL_Surface* copy = SDL_ConvertSurfaceFormat(pixels, SDL_PIXELFORMAT_ARGB8888, 0);
+    if (copy == NULL)
+    {
+        printf("Error converting soft texture: %s\n", SDL_GetError());
+        return false;
+    }
+    if ((soft->textureCount + 1)*2 > soft->textureCapacity)
+    {
+        int oldCapacity = soft->textureCapacity;
+        NDL_Texture** oldKeys = soft->textureKeys;
+        NDL_Surface** oldSurfaces = soft->textureSurfaces;
+        soft->textureCapacity *= 2;
+        soft->textureKeys = calloc(soft->textureCapacity, sizeof(NDL_Texture*));
+        soft->textureSurfaces = malloc(sizeof(NDL_Surface*)*soft->textureCapacity);
+        for (int i = 0; i < oldCapacity; ++i)
+        {
+            if (oldKeys[i] == NULL) continue;
+            Uint32 slot = NDL_SoftTextureSlot_G(soft, oldKeys[i]);
+            soft->textureKeys[slot] = oldKeys[i];
+            soft->textureSurfaces[slot] = oldSurfaces[i];
+        }
+        free(oldKeys);
+        free(oldSurfaces);
+    }
+    Uint32 slot = NDL_SoftTextureSlot_G(soft, texture);
+    if (soft->textureKeys[slot] != NULL)
+    {
+        SDL_FreeSurface(soft->textureSurfaces[slot]);
+    } else {
+        ++soft->textureCount;
+    }
+    soft->textureKeys[slot] = texture;
+    soft->textureSurfaces[slot] = copy;
+    return true;
+}
+
+bool NDL_LoadSoftTexture(NDL_SoftRenderer* soft, NDL_Texture* texture, const char* fp)
+{
+    NDL_Surface* surface = IMG_Load(fp);
+    if (surface == NULL)
+    {
+        printf("Error loading %s: %s\n", fp, IMG_GetError());
+        return false;
+    }
+    bool registered = NDL_RegisterSoftTexture(soft, texture, surface);
+    SDL_FreeSurface(surface);
+    return registered;
+}
+
+void NDL_SoftClear(NDL_SoftRenderer* soft, NDL_Color color)
+{
+    // Anything queued before a clear would be overwritten anyway
+    soft->commandCount = 0;
+    soft->clearColor = color;
+    soft->clearPending = true;
+}
+
+void NDL_SoftQueueQuad(NDL_SoftRenderer* soft, NDL_Texture* texture, const SDL_FRect* uv, const SDL_FRect* dst, NDL_Color color)
+{
+    NDL_Surface* surface = NULL;
+    if (texture != NULL)
+    {
+        surface = NDL_FindSoftTexture_G(soft, texture);
+        if (surface == NULL)
+        {
+            ++soft->missingTextures;
+            return;
+        }
+    }
+    if (soft->commandCount == soft->commandCapacity)
+    {
+        soft->commandCapacity *= 2;
+        soft->commands = realloc(soft->commands, sizeof(NDL_SoftCommand)*soft->commandCapacity);
+    }
+    NDL_SoftCommand* cmd = &soft->commands[soft->commandCount++];
+    cmd->texture = surface;
+    cmd->dst = *dst;
+    cmd->color = color;
+    if (surface != NULL)
+    {
+        SDL_FRect full = {0, 0, 1, 1};
+        if (uv == NULL) uv = &full;
+        cmd->src = (SDL_FRect){uv->x*surface->w, uv->y*surface->h, uv->w*surface->w, uv->h*surface->h};
+    }
+}
+
+static void NDL_SoftDrawCommand_G(NDL_SoftRenderer* soft, const NDL_SoftCommand* cmd, int bandY0, int bandY1, NDL_FillSpanMethod fillSpan, NDL_TexSpanMethod texSpan)
+{
+    NDL_Surface* target = soft->target;
+    // Pixels whose centres fall inside dst are covered, as with SDL's geometry rasterizer
+    int x0 = (int)ceilf(cmd->dst.x - 0.5f), x1 = (int)ceilf(cmd->dst.x + cmd->dst.w - 0.5f);
+    int y0 = (int)ceilf(cmd->dst.y - 0.5f), y1 = (int)ceilf(cmd->dst.y + cmd->dst.h - 0.5f);
+    if (x0 < 0) x0 = 0;
+    if (x1 > target->w) x1 = target->w;
+    if (y0 < bandY0) y0 = bandY0;
+    if (y1 > bandY1) y1 = bandY1;
+    if (x0 >= x1 || y0 >= y1) return;
+    Uint32 color = (Uint32)cmd->color.a << 24 | (Uint32)cmd->color.r << 16 | (Uint32)cmd->color.g << 8 | cmd->color.b;
+
+    if (cmd->texture == NULL)
+    {
+        for (int y = y0; y < y1; ++y) fillSpan((Uint32*)((Uint8*)target->pixels + y*target->pitch) + x0, x1 - x0, color);
+        return;
+    }
+
+    NDL_Surface* tex = cmd->texture;
+    float sx = cmd->src.w / cmd->dst.w, sy = cmd->src.h / cmd->dst.h;
+    for (int y = y0; y < y1; ++y)
+    {
+        Uint32* row = (Uint32*)((Uint8*)target->pixels + y*target->pitch) + x0;
+        float v = cmd->src.y + (y + 0.5f - cmd->dst.y)*sy;
+        float u = cmd->src.x + (x0 + 0.5f - cmd->dst.x)*sx;
+        if (soft->bilinear)
+        {
+            int fy = (int)floorf((v - 0.5f)*256.0f);
+            for (int x = 0; x < x1 - x0; ++x)
+            {
+                int fx = (int)floorf((u + x*sx - 0.5f)*256.0f);
+                Uint32 texel = NDL_BilinearSample_G(tex, fx, fy);
+                if (color != 0xFFFFFFFF) texel = NDL_Modulate_G(texel, color);
+                row[x] = NDL_BlendPixel_G(texel, row[x]);
+            }
+            continue;
+        }
+        int ty = (int)floorf(v);
+        if (ty < 0) ty = 0;
+        if (ty > tex->h - 1) ty = tex->h - 1;
+        const Uint32* srcRow = (const Uint32*)((const Uint8*)tex->pixels + ty*tex->pitch);
+        Sint32 fu = (Sint32)(u*65536.0f);
+        if (fu < 0) fu = 0;
+        texSpan(row, srcRow, x1 - x0, fu, (Sint32)(sx*65536.0f), tex->w, color);
+    }
+}
+
+static void NDL_SoftBandJob_G(void* data, int band)
+{
+    NDL_SoftRenderer* soft = data;
+    NDL_FillSpanMethod fillSpan = NDL_FillSpan_Scalar_G;
+    NDL_TexSpanMethod texSpan = NDL_TexSpan_Scalar_G;
+#ifdef NDL_SIMD_X86
+    if (soft->simdLevel >= 2)
+    {
+        fillSpan = NDL_FillSpan_AVX2_G;
+        texSpan = NDL_TexSpan_AVX2_G;
+    } else if (soft->simdLevel == 1) {
+        fillSpan = NDL_FillSpan_SSE2_G;
+        texSpan = NDL_TexSpan_SSE2_G;
+    }
+#endif
+    int y0 = band*soft->bandHeight;
+    int y1 = y0 + soft->bandHeight;
+    if (y1 > soft->target->h) y1 = soft->target->h;
+    if (soft->clearPending)
+    {
+        NDL_Color c = soft->clearColor;
+        Uint32 clear = (Uint32)c.a << 24 | (Uint32)c.r << 16 | (Uint32)c.g << 8 | c.b;
+        for (int y = y0; y < y1; ++y)
+        {
+            Uint32* row = (Uint32*)((Uint8*)soft->target->pixels + y*soft->target->pitch);
+            for (int x = 0; x < soft->target->w; ++x) row[x] = clear;
+        }
+    }
+    for (int i = 0; i < soft->commandCount; ++i) NDL_SoftDrawCommand_G(soft, &soft->commands[i], y0, y1, fillSpan, texSpan);
+}
+
+void NDL_SoftFlush(NDL_SoftRenderer* soft)
+{
+    int bands = (soft->target->h + soft->bandHeight - 1) / soft->bandHeight;
+    SDL_LockSurface(soft->target);
+    NDL_RunParallel(soft->pool, bands, NDL_SoftBandJob_G, soft);
+    SDL_UnlockSurface(soft->target);
+    soft->commandCount = 0;
+    soft->clearPending = false;
+}
+
+int NDL_CompareSurfaces(NDL_Surface* a, NDL_Surface* b, Uint8 tolerance)
+{
+    if (a->w != b->w || a->h != b->h) return -1;
+    NDL_Surface* ca = SDL_ConvertSurfaceFormat(a, SDL_PIXELFORMAT_ARGB8888, 0);
+    NDL_Surface* cb = SDL_ConvertSurfaceFormat(b, SDL_PIXELFORMAT_ARGB8888, 0);
+    if (ca == NULL || cb == NULL)
+    {
+        if (ca != NULL) SDL_FreeSurface(ca);
+        if (cb != NULL) SDL_FreeSurface(cb);
+        return -1;
+    }
+    int differing = 0;
+    for (int y = 0; y < ca->h; ++y)
+    {
+        const Uint32* ra = (const Uint32*)((const Uint8*)ca->pixels + y*ca->pitch);
+        const Uint32* rb = (const Uint32*)((const Uint8*)cb->pixels + y*cb->pitch);
+        for (int x = 0; x < ca->w; ++x)
+        {
+            for (int shift = 0; shift < 32; shift += 8)
+            {
+                int d = (int)((ra[x] >> shift) & 0xFF) - (int)((rb[x] >> shift) & 0xFF);
+                if (d > tolerance || -d > tolerance)
+                {
+                    ++differing;
+                    break;
+                }
+            }
+        }
+    }
+    SDL_FreeSurface(ca);
+    SDL_FreeSurface(cb);
+    return differing;
+}
+
+double NDL_BenchmarkSoftRenderer(NDL_SoftRenderer* soft, int quadSize, int quadCount, int iterations)
+{
+    // A 64x64 half-transparent gradient, registered under a fake texture handle
+    NDL_Surface* pattern = SDL_CreateRGBSurfaceWithFormat(0, 64, 64, 32, SDL_PIXELFORMAT_ARGB8888);
+    if (pattern == NULL) return 0.0;
+    for (int y = 0; y < 64; ++y)
+    {
+        Uint32* row = (Uint32*)((Uint8*)pattern->pixels + y*pattern->pitch);
+        for (int x = 0; x < 64; ++x) row[x] = (Uint32)(128 + x) << 24 | (Uint32)(x*4) << 16 | (Uint32)(y*4) << 8 | 200;
+    }
+    NDL_Texture* handle = (NDL_Texture*)pattern;
+    NDL_RegisterSoftTexture(soft, handle, pattern);
+
+    Uint32 seed = 12345;
+    double pixels = 0.0;
+    Uint64 start = SDL_GetPerformanceCounter();
+    for (int it = 0; it < iterations; ++it)
+    {
+        NDL_SoftClear(soft, (NDL_Color){0, 0, 0, 255});
+        for (int q = 0; q < quadCount; ++q)
+        {
+            seed = seed*1664525u + 1013904223u;
+            float x = (float)(seed % (Uint32)(soft->target->w > quadSize ? soft->target->w - quadSize : 1));
+            seed = seed*1664525u + 1013904223u;
+            float y = (float)(seed % (Uint32)(soft->target->h > quadSize ? soft->target->h - quadSize : 1));
+            SDL_FRect dst = {x, y, (float)quadSize, (float)quadSize};
+            NDL_SoftQueueQuad(soft, handle, NULL, &dst, (NDL_Color){255, 255, 255, 255});
+        }
+        NDL_SoftFlush(soft);
+        pixels += (double)quadCount*quadSize*quadSize;
+    }
+    double ms = NDL_GetElapsedMs(start);
+
+    // Forget the fake handle so it can never alias a real texture
+    Uint32 slot = NDL_SoftTextureSlot_G(soft, handle);
+    SDL_FreeSurface(soft->textureSurfaces[slot]);
+    soft->textureKeys[slot] = NULL;
+    --soft->textureCount;
+    for (Uint32 next = (slot + 1) & (soft->textureCapacity - 1); soft->textureKeys[next] != NULL; next = (next + 1) & (soft->textureCapacity - 1))
+    {
+        // Re-insert the rest of the probe run so lookups past the hole still succeed
+        NDL_Texture* key = soft->textureKeys[next];
+        NDL_Surface* surface = soft->textureSurfaces[next];
+        soft->textureKeys[next] = NULL;
+        Uint32 to = NDL_SoftTextureSlot_G(soft, key);
+        soft->textureKeys[to] = key;
+        soft->textureSurfaces[to] = surface;
+    }
+    SDL_FreeSurface(pattern);
+    return ms > 0.0 ? pixels / (ms*1000.0) : 0.0;
+}
+
+NDL_PixelBufferPool* NDL_CreatePixelBufferPool()
+{
+    NDL_PixelBufferPool* pool = malloc(sizeof(NDL_PixelBufferPool));
+    pool->free = NULL;
+    pool->allocated = 0;
+    pool->reused = 0;
+    return pool;
+}
+
+void NDL_DestroyPixelBufferPool(NDL_PixelBufferPool* pool)
+{
+    // Only released buffers are freed; buffers still held by callers stay theirs
+    while (pool->free != NULL)
+    {
+        NDL_PixelBuffer* next = pool->free->next;
+        free(pool->free->pixels);
+        free(pool->free);
+        pool->free = next;
+    }
+    free(pool);
+}
+
+NDL_PixelBuffer* NDL_AcquirePixelBuffer(NDL_PixelBufferPool* pool, int w, int h)
+{
+    // Take the smallest free buffer that fits, so large buffers stay available for large requests
+    int needed = w*h;
+    NDL_PixelBuffer** best = NULL;
+    for (NDL_PixelBuffer** it = &pool->free; *it != NULL; it = &(*it)->next)
+    {
+        if ((*it)->capacity >= needed && (best == NULL || (*it)->capacity < (*best)->capacity)) best = it;
+    }
+    NDL_PixelBuffer* buffer;
+    if (best != NULL)
+    {
+        buffer = *best;
+        *best = buffer->next;
+        ++pool->reused;
+    } else {
+        buffer = malloc(sizeof(NDL_PixelBuffer));
+        buffer->capacity = needed > 0 ? needed : 1;
+        buffer->pixels = malloc(sizeof(Uint32)*buffer->capacity);
+        ++pool->allocated;
+    }
+    buffer->w = w;
+    buffer->h = h;
+    buffer->next = NULL;
+    return buffer;
+}
+
+void NDL_ReleasePixelBuffer(NDL_PixelBufferPool* pool, NDL_PixelBuffer* buffer)
+{
+    buffer->next = pool->free;
+    pool->free = buffer;
+}
+
+NDL_StreamingTexture* NDL_CreateStreamingTexture(Renderer renderer, int w, int h, bool doubleBuffered)
+{
+    NDL_StreamingTexture* stream = malloc(sizeof(NDL_StreamingTexture));
+    stream->sdlRenderer = renderer;
+    stream->w = w;
+    stream->h = h;
+    stream->bufferCount = doubleBuffered ? 2 : 1;
+    stream->textures[0] = stream->textures[1] = NULL;
+    for (int b = 0; b < stream->bufferCount; ++b)
+    {
+        stream->textures[b] = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STREAMING, w, h);
+        if (stream->textures[b] == NULL)
+        {
+            printf("Error creating streaming texture: %s\n", SDL_GetError());
+            if (b == 1) SDL_DestroyTexture(stream->textures[0]);
+            free(stream);
+            return NULL;
+        }
+        SDL_SetTextureBlendMode(stream->textures[b], SDL_BLENDMODE_BLEND);
+        // The first unlock uploads the whole image into each buffer
+        stream->dirtyCount[b] = 1;
+        stream->dirty[b][0] = (SDL_Rect){0, 0, w, h};
+    }
+    stream->front = 0;
+    stream->shadow = calloc(w*h, sizeof(Uint32));
+    stream->uploadedPixels = 0;
+    return stream;
+}
+
+void NDL_DestroyStreamingTexture(NDL_StreamingTexture* stream)
+{
+    for (int b = 0; b < stream->bufferCount; ++b) SDL_DestroyTexture(stream->textures[b]);
+    free(stream->shadow);
+    free(stream);
+}
+
+static void NDL_MarkStreamDirty_G(NDL_StreamingTexture* stream, SDL_Rect rect)
+{
+    for (int b = 0; b < stream->bufferCount; ++b)
+    {
+        SDL_Rect* list = stream->dirty[b];
+        int* count = &stream->dirtyCount[b];
+        // Skip rects already covered, which is the common case for a region rewritten every frame
+        bool covered = false;
+        for (int i = 0; i < *count && !covered; ++i)
+        {
+            covered = rect.x >= list[i].x && rect.y >= list[i].y &&
+                      rect.x + rect.w <= list[i].x + list[i].w && rect.y + rect.h <= list[i].y + list[i].h;
+        }
+        if (covered) continue;
+        if (*count == NDL_STREAM_MAX_DIRTY)
+        {
+            for (int i = 1; i < *count; ++i) SDL_UnionRect(&list[0], &list[i], &list[0]);
+            SDL_UnionRect(&list[0], &rect, &list[0]);
+            *count = 1;
+        } else {
+            list[(*count)++] = rect;
+        }
+    }
+}
+
+static bool NDL_ClipStreamRect_G(NDL_StreamingTexture* stream, const SDL_Rect* rect, SDL_Rect* out)
+{
+    SDL_Rect full = {0, 0, stream->w, stream->h};
+    if (rect == NULL)
+    {
+        *out = full;
+        return true;
+    }
+    return SDL_IntersectRect(rect, &full, out);
+}
+
+Uint32* NDL_LockStreamingTexture(NDL_StreamingTexture* stream, const SDL_Rect* rect, int* pitch)
+{
+    SDL_Rect r;
+    if (!NDL_ClipStreamRect_G(stream, rect, &r)) return NULL;
+    NDL_MarkStreamDirty_G(stream, r);
+    *pitch = stream->w*(int)sizeof(Uint32);
+    return stream->shadow + r.y*stream->w + r.x;
+}
+
+void NDL_UpdateStreamingTexture(NDL_StreamingTexture* stream, const SDL_Rect* rect, const void* pixels, int pitch)
+{
+    SDL_Rect r;
+    if (!NDL_ClipStreamRect_G(stream, rect, &r)) return;
+    // pixels holds the caller's rect; skip the part that was clipped away
+    const Uint8* src = (const Uint8*)pixels;
+    if (rect != NULL) src += (r.y - rect->y)*pitch + (r.x - rect->x)*(int)sizeof(Uint32);
+    for (int y = 0; y < r.h; ++y)
+    {
+        memcpy(stream->shadow + (r.y + y)*stream->w + r.x, src + y*pitch, sizeof(Uint32)*r.w);
+    }
+    NDL_MarkStreamDirty_G(stream, r);
+}
+
+NDL_Texture* NDL_UnlockStreamingTexture(NDL_StreamingTexture* stream)
+{
+    int back = (stream->front + 1) % stream->bufferCount;
+    NDL_Texture* texture = stream->textures[back];
+    stream->uploadedPixels = 0;
+    for (int i = 0; i < stream->dirtyCount[back]; ++i)
+    {
+        SDL_Rect* r = &stream->dirty[back][i];
+        void* dst;
+        int dstPitch;
+        if (SDL_LockTexture(texture, r, &dst, &dstPitch) != 0)
+        {
+            printf("Error locking streaming texture: %s\n", SDL_GetError());
+            continue;
+        }
+        for (int y = 0; y < r->h; ++y)
+        {
+            memcpy((Uint8*)dst + y*dstPitch, stream->shadow + (r->y + y)*stream->w + r->x, sizeof(Uint32)*r->w);
+        }
+        SDL_UnlockTexture(texture);
+        stream->uploadedPixels += r->w*r->h;
+    }
+    stream->dirtyCount[back] = 0;
+    stream->front = back;
+    return texture;
+}
+
+NDL_Texture* NDL_GetStreamingTexture(NDL_StreamingTexture* stream)
+{
+    return stream->textures[stream->front];
+}
+
+NDL_SpriteBatch* NDL_CreateSpriteBatch(Renderer renderer, int quadCapacity)
+{
+    NDL_SpriteBatch* batch = malloc(sizeof(NDL_SpriteBatch));
+    batch->sdlRenderer = renderer;
+    batch->groupCount = 0;
+    batch->groupCapacity = 8;
+    batch->groups = malloc(sizeof(NDL_SpriteBatchGroup)*batch->groupCapacity);
+    batch->activeCount = 0;
+    batch->active = malloc(sizeof(int)*batch->groupCapacity);
+    batch->lastGroup = -1;
+    batch->indexCapacity = 0;
+    batch->indices = NULL;
+    batch->drawCalls = 0;
+    batch->quadCapacityHint = quadCapacity > 0 ? quadCapacity : 256;
+    batch->ordered = true;
+    batch->soft = NULL;
+    return batch;
+}
+
+void NDL_SetSpriteBatchGrouped(NDL_SpriteBatch* batch, bool grouped)
+{
+    // Quads already queued were collected under the old rule, so draw them first
+    if (batch->ordered == grouped) NDL_FlushSpriteBatch(batch);
+    batch->ordered = !grouped;
+}
+
+void NDL_DestroySpriteBatch(NDL_SpriteBatch* batch)
+{
+    for (int g = 0; g < batch->groupCount; ++g)
+    {
+        free(batch->groups[g].vertices);
+    }
+    free(batch->groups);
+    free(batch->active);
+    free(batch->indices);
+    free(batch);
+}
+
+static NDL_SpriteBatchGroup* NDL_GetBatchGroup_G(NDL_SpriteBatch* batch, NDL_Texture* texture)
+{
+    // Consecutive sprites usually share a texture, so check the last group before searching
+    int g = batch->lastGroup;
+    if (g >= 0 && batch->groups[g].texture != texture && batch->ordered) NDL_FlushSpriteBatch(batch);
+    if (g < 0 || batch->groups[g].texture != texture)
+    {
+        for (g = 0; g < batch->groupCount; ++g)
+        {
+            if (batch->groups[g].texture == texture) break;
+        }
+        if (g == batch->groupCount)
+        {
+            if (batch->groupCount == batch->groupCapacity)
+            {
+                batch->groupCapacity *= 2;
+                batch->groups = realloc(batch->groups, sizeof(NDL_SpriteBatchGroup)*batch->groupCapacity);
+                batch->active = realloc(batch->active, sizeof(int)*batch->groupCapacity);
+            }
+            NDL_SpriteBatchGroup* group = &batch->groups[batch->groupCount++];
+            group->texture = texture;
+            group->quadCount = 0;
+            group->quadCapacity = batch->quadCapacityHint;
+            group->vertices = malloc(sizeof(SDL_Vertex)*4*group->quadCapacity);
+        }
+        batch->lastGroup = g;
+    }
+    NDL_SpriteBatchGroup* group = &batch->groups[g];
+    if (group->quadCount == 0) batch->active[batch->activeCount++] = g;
+    if (group->quadCount == group->quadCapacity)
+    {
+        group->quadCapacity *= 2;
+        group->vertices = realloc(group->vertices, sizeof(SDL_Vertex)*4*group->quadCapacity);
+    }
+    return group;
+}
+
+static inline void NDL_WriteQuad_G(SDL_Vertex* v, const SDL_FRect* uv, const SDL_FRect* dst, NDL_Color color)
+{
+    float u0 = 0.0f, v0 = 0.0f, u1 = 1.0f, v1 = 1.0f;
+    if (uv != NULL)
+    {
+        u0 = uv->x; v0 = uv->y;
+        u1 = uv->x + uv->w; v1 = uv->y + uv->h;
+    }
+    float x0 = dst->x, y0 = dst->y;
+    float x1 = dst->x + dst->w, y1 = dst->y + dst->h;
+    v[0] = (SDL_Vertex){{x0, y0}, color, {u0, v0}};
+    v[1] = (SDL_Vertex){{x1, y0}, color, {u1, v0}};
+    v[2] = (SDL_Vertex){{x1, y1}, color, {u1, v1}};
+    v[3] = (SDL_Vertex){{x0, y1}, color, {u0, v1}};
+}
+
+// As NDL_WriteQuad_G, with the corners turned by angle degrees clockwise about dst's centre
+static inline void NDL_WriteQuadEx_G(SDL_Vertex* v, const SDL_FRect* uv, const SDL_FRect* dst, NDL_Color color, float angle)
+{
+    NDL_WriteQuad_G(v, uv, dst, color);
+    if (angle == 0.0f) return;
+    float r = angle*(3.1415927f/180.0f);
+    float c = cosf(r), s = sinf(r);
+    float cx = dst->x + dst->w*0.5f, cy = dst->y + dst->h*0.5f;
+    for (int i = 0; i < 4; ++i)
+    {
+        float dx = v[i].position.x - cx, dy = v[i].position.y - cy;
+        v[i].position.x = cx + dx*c - dy*s;
+        v[i].position.y = cy + dx*s + dy*c;
+    }
+}
+
+void NDL_BatchSprite(NDL_SpriteBatch* batch, NDL_Texture* texture, const SDL_FRect* uv, const SDL_FRect* dst, NDL_Color color)
+{
+    NDL_BatchSpriteEx(batch, texture, uv, dst, color, 0.0f);
+}
+
+void NDL_BatchSpriteEx(NDL_SpriteBatch* batch, NDL_Texture* texture, const SDL_FRect* uv, const SDL_FRect* dst, NDL_Color color, float angle)
+{
+    if (batch->soft != NULL)
+    {
+        // The soft rasterizer only fills axis-aligned spans
+        NDL_SoftQueueQuad(batch->soft, texture, uv, dst, color);
+        return;
+    }
+    NDL_SpriteBatchGroup* group = NDL_GetBatchGroup_G(batch, texture);
+    NDL_WriteQuadEx_G(group->vertices + group->quadCount*4, uv, dst, color, angle);
+    ++group->quadCount;
+}
+
+void NDL_BatchFillRect(NDL_SpriteBatch* batch, const SDL_FRect* dst, NDL_Color color)
+{
+    NDL_BatchSprite(batch, NULL, NULL, dst, color);
+}
+
+static void NDL_ReserveBatchIndices_G(NDL_SpriteBatch* batch, int quads)
+{
+    if (quads <= batch->indexCapacity) return;
+    batch->indices = realloc(batch->indices, sizeof(int)*6*quads);
+    for (int q = batch->indexCapacity; q < quads; ++q)
+    {
+        int* i = batch->indices + q*6;
+        i[0] = q*4; i[1] = q*4 + 1; i[2] = q*4 + 2;
+        i[3] = q*4 + 2; i[4] = q*4 + 3; i[5] = q*4;
+    }
+    batch->indexCapacity = quads;
+}
+
+int NDL_FlushSpriteBatch(NDL_SpriteBatch* batch)
+{
+    int drawCalls = 0;
+    for (int a = 0; a < batch->activeCount; ++a)
+    {
+        NDL_SpriteBatchGroup* group = &batch->groups[batch->active[a]];
+        NDL_ReserveBatchIndices_G(batch, group->quadCount);
+        SDL_RenderGeometry(batch->sdlRenderer, group->texture, group->vertices, group->quadCount*4, batch->indices, group->quadCount*6);
+        NDL_CountDraw_G(batch->sdlRenderer, group->texture, group->quadCount*4);
+        group->quadCount = 0;
+        ++drawCalls;
+    }
+    batch->activeCount = 0;
+    batch->drawCalls += drawCalls;
+    return drawCalls;
+}
+
+void NDL_ResetSpriteBatchStats(NDL_SpriteBatch* batch)
+{
+    batch->drawCalls = 0;
+}
+
+NDL_RenderQueue* NDL_CreateRenderQueue(int capacity)
+{
+    NDL_RenderQueue* queue = malloc(sizeof(NDL_RenderQueue));
+    queue->count = 0;
+    queue->capacity = capacity > 0 ? capacity : 256;
+    queue->entities = malloc(sizeof(NDL_Entity*)*queue->capacity);
+    queue->keys = malloc(sizeof(Uint64)*queue->capacity);
+    queue->scratch = malloc(sizeof(Uint64)*queue->capacity);
+    queue->lastCount = 0;
+    queue->lastEntities = malloc(sizeof(NDL_Entity*)*queue->capacity);
+    queue->ySort = false;
+    queue->zoom = 1.0f;
+    queue->textureIdCapacity = 256;
+    queue->textureIdCount = 0;
+    queue->textureIdKeys = calloc(queue->textureIdCapacity, sizeof(NDL_Texture*));
+    queue->textureIds = malloc(sizeof(Uint16)*queue->textureIdCapacity);
+    queue->incrementalSorts = 0;
+    queue->radixSorts = 0;
+    return queue;
+}
+
+void NDL_DestroyRenderQueue(NDL_RenderQueue* queue)
+{
+    free(queue->entities);
+    free(queue->keys);
+    free(queue->scratch);
+    free(queue->lastEntities);
+    free(queue->textureIdKeys);
+    free(queue->textureIds);
+    free(queue);
+}
+
+static Uint64 NDL_TextureId_G(NDL_RenderQueue* queue, NDL_Texture* texture)
+{
+    // Id 0 is colour-only; textures get stable ids in first-seen order
+    if (texture == NULL) return 0;
+    Uint32 mask = queue->textureIdCapacity - 1;
+    Uint32 slot = (Uint32)(((uintptr_t)texture >> 4) * 2654435761u) & mask;
+    while (queue->textureIdKeys[slot] != NULL)
+    {
+        if (queue->textureIdKeys[slot] == texture) return queue->textureIds[slot];
+        slot = (slot + 1) & mask;
+    }
+    if (queue->textureIdCount >= 0xFFFF) return 0xFFFF;
+    if ((queue->textureIdCount + 1)*2 > queue->textureIdCapacity)
+    {
+        int oldCapacity = queue->textureIdCapacity;
+        NDL_Texture** oldKeys = queue->textureIdKeys;
+        Uint16* oldIds = queue->textureIds;
+        queue->textureIdCapacity *= 2;
+        queue->textureIdKeys = calloc(queue->textureIdCapacity, sizeof(NDL_Texture*));
+        queue->textureIds = malloc(sizeof(Uint16)*queue->textureIdCapacity);
+        mask = queue->textureIdCapacity - 1;
+        for (int i = 0; i < oldCapacity; ++i)
+        {
+            if (oldKeys[i] == NULL) continue;
+            Uint32 s = (Uint32)(((uintptr_t)oldKeys[i] >> 4) * 2654435761u) & mask;
+            while (queue->textureIdKeys[s] != NULL) s = (s + 1) & mask;
+            queue->textureIdKeys[s] = oldKeys[i];
+            queue->textureIds[s] = oldIds[i];
+        }
+        free(oldKeys);
+        free(oldIds);
+        slot = (Uint32)(((uintptr_t)texture >> 4) * 2654435761u) & mask;
+        while (queue->textureIdKeys[slot] != NULL) slot = (slot + 1) & mask;
+    }
+    queue->textureIdKeys[slot] = texture;
+    queue->textureIds[slot] = (Uint16)(++queue->textureIdCount);
+    return queue->textureIds[slot];
+}
+
+// Read-only lookup, safe to call from several threads while nothing registers new textures
+static int NDL_FindTextureId_G(const NDL_RenderQueue* queue, NDL_Texture* texture)
+{
+    if (texture == NULL) return 0;
+    Uint32 mask = queue->textureIdCapacity - 1;
+    Uint32 slot = (Uint32)(((uintptr_t)texture >> 4) * 2654435761u) & mask;
+    while (queue->textureIdKeys[slot] != NULL)
+    {
+        if (queue->textureIdKeys[slot] == texture) return queue->textureIds[slot];
+        slot = (slot + 1) & mask;
+    }
+    return -1;
+}
+
+// The sprite's texture at the LOD level closest to how far the sprite is minified on screen
+static inline NDL_Texture* NDL_SpriteTexture_G(const NDL_SpriteComponent* sprite, float zoom, int* level)
+{
+    return NDL_GetTextureLOD(sprite->image, zoom*SDL_max(sprite->scale.x, sprite->scale.y), level);
+}
+
+// The texture the sprite will be drawn with, which is what the key's texture id must batch on
+static inline NDL_Texture* NDL_KeyTexture_G(const NDL_RenderQueue* queue, const NDL_SpriteComponent* sprite)
+{
+    return queue->zoom > 0.0f ? NDL_SpriteTexture_G(sprite, queue->zoom, NULL) : sprite->image;
+}
+
+static Uint64 NDL_RenderKeyBits_G(const NDL_RenderQueue* queue, NDL_SpriteComponent* sprite, Uint64 textureId)
+{
+    Uint64 y = 0;
+    if (queue->ySort)
+    {
+        // Bottom edge, biased so positions down to -2^19 still sort correctly
+        int bottom = sprite->imageRect.y + sprite->imageRect.h + (1 << 19);
+        y = bottom < 0 ? 0 : (bottom > 0xFFFFF ? 0xFFFFF : (Uint64)bottom);
+    }
+    return ((Uint64)sprite->layer << NDL_RENDER_KEY_LAYER_SHIFT)
+         | (y << NDL_RENDER_KEY_Y_SHIFT)
+         | (textureId << NDL_RENDER_KEY_TEXTURE_SHIFT);
+}
+
+static Uint64 NDL_RenderKey_G(NDL_RenderQueue* queue, NDL_SpriteComponent* sprite)
+{
+    return NDL_RenderKeyBits_G(queue, sprite, NDL_TextureId_G(queue, NDL_KeyTexture_G(queue, sprite)));
+}
+
+static void NDL_ReserveRenderQueue_G(NDL_RenderQueue* queue, int count)
+{
+    if (count <= queue->capacity) return;
+    while (queue->capacity < count) queue->capacity *= 2;
+    queue->entities = realloc(queue->entities, sizeof(NDL_Entity*)*queue->capacity);
+    queue->keys = realloc(queue->keys, sizeof(Uint64)*queue->capacity);
+    queue->scratch = realloc(queue->scratch, sizeof(Uint64)*queue->capacity);
+    queue->lastEntities = realloc(queue->lastEntities, sizeof(NDL_Entity*)*queue->capacity);
+}
+
+void NDL_SubmitRenderQueue(NDL_RenderQueue* queue, NDL_Entity* e)
+{
+    if (queue->count > (int)NDL_RENDER_KEY_SEQUENCE_MASK) return;
+    NDL_ReserveRenderQueue_G(queue, queue->count + 1);
+    queue->entities[queue->count] = e;
+    // Keys are filled in by NDL_SortRenderQueue, which knows whether last frame's order is reusable
+    ++queue->count;
+}
+
+static void NDL_RadixSort64_G(Uint64* keys, Uint64* scratch, int n)
+{
+    // Histograms for all eight bytes in one pass; passes where every key shares the byte are skipped
+    int count[8][257];
+    memset(count, 0, sizeof(count));
+    for (int i = 0; i < n; ++i)
+    {
+        Uint64 k = keys[i];
+        for (int b = 0; b < 8; ++b) ++count[b][((k >> (b*8)) & 0xFF) + 1];
+    }
+    Uint64* src = keys;
+    Uint64* dst = scratch;
+    for (int b = 0; b < 8; ++b)
+    {
+        int shift = b*8;
+        if (count[b][((src[0] >> shift) & 0xFF) + 1] == n) continue;
+        for (int d = 0; d < 256; ++d) count[b][d + 1] += count[b][d];
+        for (int i = 0; i < n; ++i) dst[count[b][(src[i] >> shift) & 0xFF]++] = src[i];
+        Uint64* t = src; src = dst; dst = t;
+    }
+    if (src != keys) memcpy(keys, src, sizeof(Uint64)*n);
+}
+
+static bool NDL_InsertionSort64_G(Uint64* keys, int n, int maxMoves)
+{
+    int moves = 0;
+    for (int i = 1; i < n; ++i)
+    {
+        Uint64 k = keys[i];
+        int j = i - 1;
+        while (j >= 0 && keys[j] > k)
+        {
+            keys[j + 1] = keys[j];
+            --j;
+            if (++moves > maxMoves) return false;
+        }
+        keys[j + 1] = k;
+    }
+    return true;
+}
+
+void NDL_SortRenderQueue(NDL_RenderQueue* queue)
+{
+    int n = queue->count;
+    bool unchanged = n == queue->lastCount && memcmp(queue->entities, queue->lastEntities, sizeof(NDL_Entity*)*n) == 0;
+    if (unchanged)
+    {
+        // keys still hold last frame's sorted order; refresh each key's high bits in place
+        for (int i = 0; i < n; ++i)
+        {
+            Uint64 seq = queue->keys[i] & NDL_RENDER_KEY_SEQUENCE_MASK;
+            queue->keys[i] = NDL_RenderKey_G(queue, queue->entities[seq]->sprite) | seq;
+        }
+        if (NDL_InsertionSort64_G(queue->keys, n, n*4 + 64))
+        {
+            ++queue->incrementalSorts;
+            return;
+        }
+    } else {
+        for (int i = 0; i < n; ++i) queue->keys[i] = NDL_RenderKey_G(queue, queue->entities[i]->sprite) | (Uint64)i;
+        memcpy(queue->lastEntities, queue->entities, sizeof(NDL_Entity*)*n);
+        queue->lastCount = n;
+    }
+    NDL_RadixSort64_G(queue->keys, queue->scratch, n);
+    ++queue->radixSorts;
+}
+
+void NDL_ClearRenderQueue(NDL_RenderQueue* queue)
+{
+    queue->count = 0;
+}
+
+NDL_Tilemap* NDL_CreateTilemap(Renderer renderer, NDL_Texture* tileset, int tileW, int tileH, int widthTiles, int heightTiles, int chunkTiles)
+{
+    if (tileset == NULL)
+    {
+        printf("Tilemap needs a tileset texture!\n");
+        return NULL;
+    }
+    int tilesetW;
+    SDL_QueryTexture(tileset, NULL, NULL, &tilesetW, NULL);
+
+    NDL_Tilemap* map = malloc(sizeof(NDL_Tilemap));
+    map->sdlRenderer = renderer;
+    map->tileset = tileset;
+    map->tilesetColumns = tilesetW / tileW;
+    map->tileW = tileW;
+    map->tileH = tileH;
+    map->widthTiles = widthTiles;
+    map->heightTiles = heightTiles;
+    map->chunkTiles = chunkTiles;
+    map->chunksX = (widthTiles + chunkTiles - 1) / chunkTiles;
+    map->chunksY = (heightTiles + chunkTiles - 1) / chunkTiles;
+    int chunkCount = map->chunksX*map->chunksY;
+    map->chunks = malloc(sizeof(NDL_TileChunk)*chunkCount);
+    map->tileData = calloc((size_t)chunkCount*chunkTiles*chunkTiles, sizeof(Uint16));
+    for (int c = 0; c < chunkCount; ++c)
+    {
+        map->chunks[c].tiles = map->tileData + (size_t)c*chunkTiles*chunkTiles;
+        map->chunks[c].tileCount = 0;
+        map->chunks[c].texture = NULL;
+        map->chunks[c].dirty = true;
+        map->chunks[c].lastUsedFrame = 0;
+    }
+    map->residentChunks = 0;
+    map->maxResidentChunks = 64;
+    map->frame = 0;
+    map->chunksDrawn = 0;
+    map->chunksBaked = 0;
+    return map;
+}
+
+void NDL_DestroyTilemap(NDL_Tilemap* map)
+{
+    for (int c = 0; c < map->chunksX*map->chunksY; ++c)
+    {
+        if (map->chunks[c].texture != NULL) SDL_DestroyTexture(map->chunks[c].texture);
+    }
+    free(map->chunks);
+    free(map->tileData);
+    free(map);
+}
+
+void NDL_SetTile(NDL_Tilemap* map, int x, int y, Uint16 tile)
+{
+    if (x < 0 || y < 0 || x >= map->widthTiles || y >= map->heightTiles) return;
+    NDL_TileChunk* chunk = &map->chunks[(y / map->chunkTiles)*map->chunksX + x / map->chunkTiles];
+    Uint16* slot = &chunk->tiles[(y % map->chunkTiles)*map->chunkTiles + x % map->chunkTiles];
+    if (*slot == tile) return;
+    chunk->tileCount += (tile != 0) - (*slot != 0);
+    *slot = tile;
+    chunk->dirty = true;
+}
+
+Uint16 NDL_GetTile(NDL_Tilemap* map, int x, int y)
+{
+    if (x < 0 || y < 0 || x >= map->widthTiles || y >= map->heightTiles) return 0;
+    NDL_TileChunk* chunk = &map->chunks[(y / map->chunkTiles)*map->chunksX + x / map->chunkTiles];
+    return chunk->tiles[(y % map->chunkTiles)*map->chunkTiles + x % map->chunkTiles];
+}
+
+void NDL_SetTilemapChunkBudget(NDL_Tilemap* map, int maxResidentChunks)
+{
+    map->maxResidentChunks = maxResidentChunks;
+}
+
+void NDL_InvalidateTilemap(NDL_Tilemap* map)
+{
+    for (int c = 0; c < map->chunksX*map->chunksY; ++c) map->chunks[c].dirty = true;
+}
+
+/*
+ * Sprites blended with SDL_BLENDMODE_BLEND over a target cleared to transparent black leave
+ * premultiplied colour behind (rgb = s*a). Compositing such a target with plain BLEND would apply
+ * alpha a second time and darken soft edges, so it is drawn with (ONE, ONE_MINUS_SRC_ALPHA).
+ */
+static SDL_BlendMode NDL_PremultipliedBlendMode_G()
+{
+    return SDL_ComposeCustomBlendMode(SDL_BLENDFACTOR_ONE, SDL_BLENDFACTOR_ONE_MINUS_SRC_ALPHA, SDL_BLENDOPERATION_ADD,
+                                      SDL_BLENDFACTOR_ONE, SDL_BLENDFACTOR_ONE_MINUS_SRC_ALPHA, SDL_BLENDOPERATION_ADD);
+}
+
+// Renderers without custom blend modes fall back to BLEND, which only darkens translucent edges
+static void NDL_SetPremultipliedBlend_G(NDL_Texture* texture)
+{
+    if (SDL_SetTextureBlendMode(texture, NDL_PremultipliedBlendMode_G()) != 0) SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_BLEND);
+}
+
+static NDL_Texture* NDL_AcquireChunkTexture_G(NDL_Tilemap* map)
+{
+    if (map->residentChunks >= map->maxResidentChunks)
+    {
+        // Take the texture of the least recently drawn chunk that is not on screen this frame
+        NDL_TileChunk* victim = NULL;
+        for (int c = 0; c < map->chunksX*map->chunksY; ++c)
+        {
+            NDL_TileChunk* chunk = &map->chunks[c];
+            if (chunk->texture == NULL || chunk->lastUsedFrame == map->frame) continue;
+            if (victim == NULL || chunk->lastUsedFrame < victim->lastUsedFrame) victim = chunk;
+        }
+        if (victim != NULL)
+        {
+            NDL_Texture* texture = victim->texture;
+            victim->texture = NULL;
+            victim->dirty = true;
+            return texture;
+        }
+        // Everything resident is on screen; go over budget rather than leave holes
+    }
+    NDL_Texture* texture = SDL_CreateTexture(map->sdlRenderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_TARGET, map->chunkTiles*map->tileW, map->chunkTiles*map->tileH);
+    if (texture == NULL)
+    {
+        printf("Error creating chunk texture: %s\n", SDL_GetError());
+        return NULL;
+    }
+    NDL_SetPremultipliedBlend_G(texture);
+    ++map->residentChunks;
+    return texture;
+}
+
+static void NDL_BakeChunk_G(NDL_Tilemap* map, NDL_TileChunk* chunk, NDL_SpriteBatch* batch)
+{
+    float tileU = (float)map->tileW, tileV = (float)map->tileH;
+    int tilesetW, tilesetH;
+    SDL_QueryTexture(map->tileset, NULL, NULL, &tilesetW, &tilesetH);
+    // Tiles in a chunk never overlap, so grouping by texture is safe here
+    bool ordered = batch->ordered;
+    NDL_SetSpriteBatchGrouped(batch, true);
+    for (int ty = 0; ty < map->chunkTiles; ++ty)
+    {
+        for (int tx = 0; tx < map->chunkTiles; ++tx)
+        {
+            Uint16 tile = chunk->tiles[ty*map->chunkTiles + tx];
+            if (tile == 0) continue;
+            int index = tile - 1;
+            SDL_FRect uv = {(index % map->tilesetColumns)*tileU/tilesetW, (index / map->tilesetColumns)*tileV/tilesetH, tileU/tilesetW, tileV/tilesetH};
+            SDL_FRect dst = {tx*tileU, ty*tileV, tileU, tileV};
+            NDL_BatchSprite(batch, map->tileset, &uv, &dst, (NDL_Color){255, 255, 255, 255});
+        }
+    }
+
+    NDL_Texture* previous = NDL_GetRenderTarget(map->sdlRenderer);
+    NDL_SetRenderTarget(map->sdlRenderer, chunk->texture);
+    NDL_SetDrawColor(map->sdlRenderer, (NDL_Color){0, 0, 0, 0});
+    SDL_RenderClear(map->sdlRenderer);
+    NDL_CountDraw_G(map->sdlRenderer, NULL, 0);
+    NDL_FlushSpriteBatch(batch);
+    NDL_SetRenderTarget(map->sdlRenderer, previous);
+    batch->ordered = ordered;
+    chunk->dirty = false;
+}
+
+// Halves an RGBA32 surface with a 2x2 box filter, weighting colour by alpha so edges do not darken
+static NDL_Surface* NDL_HalveSurface_G(NDL_Surface* src)
+{
+    int w = SDL_max(1, src->w/2), h = SDL_max(1, src->h/2);
+    NDL_Surface* dst = SDL_CreateRGBSurfaceWithFormat(0, w, h, 32, SDL_PIXELFORMAT_RGBA32);
+    if (dst == NULL) return NULL;
+    for (int y = 0; y < h; ++y)
+    {
+        const Uint8* row0 = (const Uint8*)src->pixels + SDL_min(2*y, src->h - 1)*src->pitch;
+        const Uint8* row1 = (const Uint8*)src->pixels + SDL_min(2*y + 1, src->h - 1)*src->pitch;
+        Uint8* out = (Uint8*)dst->pixels + y*dst->pitch;
+        for (int x = 0; x < w; ++x, out += 4)
+        {
+            int x0 = SDL_min(2*x, src->w - 1)*4, x1 = SDL_min(2*x + 1, src->w - 1)*4;
+            const Uint8* q[4] = {row0 + x0, row0 + x1, row1 + x0, row1 + x1};
+            Uint32 r = 0, g = 0, b = 0, a = 0;
+            for (int i = 0; i < 4; ++i)
+            {
+                r += q[i][0]*q[i][3];
+                g += q[i][1]*q[i][3];
+                b += q[i][2]*q[i][3];
+                a += q[i][3];
+            }
+            out[0] = a > 0 ? (Uint8)((r + a/2)/a) : 0;
+            out[1] = a > 0 ? (Uint8)((g + a/2)/a) : 0;
+            out[2] = a > 0 ? (Uint8)((b + a/2)/a) : 0;
+            out[3] = (Uint8)((a + 2)/4);
+        }
+    }
+    return dst;
+}
+
+bool NDL_BuildTextureLOD(Renderer ren, NDL_Texture* texture, NDL_Surface* pixels, int levels)
+{
+    NDL_TextureLOD* existing = SDL_GetTextureUserData(texture);
+    if (existing != NULL && existing->atlasPage)
+    {
+        printf("Atlas pages cannot have LOD levels; their regions would bleed into each other!\n");
+        return false;
+    }
+    NDL_DestroyTextureLOD(texture);
+    if (levels > NDL_MAX_TEXTURE_LODS) levels = NDL_MAX_TEXTURE_LODS;
+    NDL_Surface* level = SDL_ConvertSurfaceFormat(pixels, SDL_PIXELFORMAT_RGBA32, 0);
+    if (level == NULL)
+    {
+        printf("Error converting texture for LOD levels: %s\n", SDL_GetError());
+        return false;
+    }
+    NDL_TextureLOD* lod = malloc(sizeof(NDL_TextureLOD));
+    lod->levels[0] = texture;
+    lod->levelCount = 1;
+    lod->atlasPage = false;
+    SDL_BlendMode blend = SDL_BLENDMODE_BLEND;
+    SDL_ScaleMode scale = SDL_ScaleModeLinear;
+    SDL_GetTextureBlendMode(texture, &blend);
+    SDL_GetTextureScaleMode(texture, &scale);
+    while (lod->levelCount < levels && (level->w > 1 || level->h > 1))
+    {
+        NDL_Surface* half = NDL_HalveSurface_G(level);
+        SDL_FreeSurface(level);
+        level = half;
+        NDL_Texture* t = level != NULL ? SDL_CreateTextureFromSurface(ren, level) : NULL;
+        if (t == NULL)
+        {
+            printf("Error creating texture LOD level %d: %s\n", lod->levelCount, SDL_GetError());
+            break;
+        }
+        SDL_SetTextureBlendMode(t, blend);
+        SDL_SetTextureScaleMode(t, scale);
+        lod->levels[lod->levelCount++] = t;
+    }
+    if (level != NULL) SDL_FreeSurface(level);
+    SDL_SetTextureUserData(texture, lod);
+    return lod->levelCount > 1;
+}
+
+NDL_Texture* NDL_LoadTextureLOD(Renderer ren, const char* fp, int levels)
+{
+    NDL_Surface* surface = IMG_Load(fp);
+    if (surface == NULL)
+    {
+        printf("Error loading texture %s: %s\n", fp, IMG_GetError());
+        return NULL;
+    }
+    NDL_Texture* texture = SDL_CreateTextureFromSurface(ren, surface);
+    if (texture != NULL) NDL_BuildTextureLOD(ren, texture, surface, levels);
+    SDL_FreeSurface(surface);
+    return texture;
+}
+
+void NDL_DestroyTextureLOD(NDL_Texture* texture)
+{
+    NDL_TextureLOD* lod = SDL_GetTextureUserData(texture);
+    // The atlas frees its pages' entries with the pages
+    if (lod == NULL || lod->atlasPage) return;
+    for (int i = 1; i < lod->levelCount; ++i) SDL_DestroyTexture(lod->levels[i]);
+    free(lod);
+    SDL_SetTextureUserData(texture, NULL);
+}
+
+NDL_Texture* NDL_GetTextureLOD(NDL_Texture* texture, float scale, int* level)
+{
+    int k = 0;
+    // Level k is drawn from scale 2^-(k + 0.5) down, so the closest level always wins
+    if (texture != NULL && scale < 0.7071f)
+    {
+        NDL_TextureLOD* lod = SDL_GetTextureUserData(texture);
+        if (lod != NULL)
+        {
+            float limit = 0.7071f;
+            while (k + 1 < lod->levelCount && scale < limit)
+            {
+                ++k;
+                limit *= 0.5f;
+            }
+            texture = lod->levels[k];
+        }
+    }
+    if (level != NULL) *level = k;
+    return texture;
+}
+
+static inline float NDL_CameraZoom_G(const NDL_Camera* camera)
+{
+    return camera != NULL ? camera->zoom : 1.0f;
+}
+
+// Size of the active viewport, or of the whole output outside NDL_BeginRenderViewport
+static void NDL_GetViewSize_G(NDL_RenderSystem* renSys, int* w, int* h)
+{
+    if (renSys->activeViewport >= 0)
+    {
+        *w = renSys->viewports[renSys->activeViewport].rect.w;
+        *h = renSys->viewports[renSys->activeViewport].rect.h;
+        return;
+    }
+    SDL_GetRendererOutputSize(renSys->sdlRenderer, w, h);
+}
+
+void NDL_RenderTilemap(NDL_RenderSystem* renSys, NDL_Tilemap* map)
+{
+    Renderer ren = renSys->sdlRenderer;
+    int viewW, viewH;
+    NDL_GetViewSize_G(renSys, &viewW, &viewH);
+    Vector2F cam = renSys->camera != NULL ? renSys->camera->position : (Vector2F){0,0};
+    float zoom = NDL_CameraZoom_G(renSys->camera);
+
+    float chunkW = (float)map->chunkTiles*map->tileW;
+    float chunkH = (float)map->chunkTiles*map->tileH;
+    int cx0 = (int)floorf(cam.x / chunkW), cy0 = (int)floorf(cam.y / chunkH);
+    int cx1 = (int)floorf((cam.x + viewW/zoom) / chunkW), cy1 = (int)floorf((cam.y + viewH/zoom) / chunkH);
+    if (cx0 < 0) cx0 = 0;
+    if (cy0 < 0) cy0 = 0;
+    if (cx1 > map->chunksX - 1) cx1 = map->chunksX - 1;
+    if (cy1 > map->chunksY - 1) cy1 = map->chunksY - 1;
+
+    ++map->frame;
+    map->chunksDrawn = 0;
+    map->chunksBaked = 0;
+    // Mark the whole view first so eviction never steals a texture that is about to be drawn
+    for (int cy = cy0; cy <= cy1; ++cy)
+    {
+        for (int cx = cx0; cx <= cx1; ++cx) map->chunks[cy*map->chunksX + cx].lastUsedFrame = map->frame;
+    }
+    for (int cy = cy0; cy <= cy1; ++cy)
+    {
+        for (int cx = cx0; cx <= cx1; ++cx)
+        {
+            NDL_TileChunk* chunk = &map->chunks[cy*map->chunksX + cx];
+            if (chunk->tileCount == 0) continue;
+            if (chunk->texture == NULL)
+            {
+                chunk->texture = NDL_AcquireChunkTexture_G(map);
+                if (chunk->texture == NULL) continue;
+                chunk->dirty = true;
+            }
+            if (chunk->dirty)
+            {
+                NDL_BakeChunk_G(map, chunk, renSys->batch);
+                ++map->chunksBaked;
+            }
+            SDL_FRect dst = {(cx*chunkW - cam.x)*zoom, (cy*chunkH - cam.y)*zoom, chunkW*zoom, chunkH*zoom};
+            SDL_RenderCopyF(ren, chunk->texture, NULL, &dst);
+            NDL_CountDraw_G(ren, chunk->texture, 4);
+            ++map->chunksDrawn;
+            ++renSys->drawCalls;
+        }
+    }
+}
+
+NDL_StaticLayer* NDL_CreateStaticLayer()
+{
+    NDL_StaticLayer* layer = malloc(sizeof(NDL_StaticLayer));
+    layer->w = 0;
+    layer->h = 0;
+    layer->camera = (Vector2F){0,0};
+    layer->zoom = 1.0f;
+    layer->valid = false;
+    layer->compositeMode = NDL_PremultipliedBlendMode_G();
+    layer->planeCount = 0;
+    layer->queue = NDL_CreateRenderQueue(256);
+    layer->count = 0;
+    layer->capacity = 256;
+    layer->entries = malloc(sizeof(NDL_StaticEntry)*layer->capacity);
+    layer->previousCount = 0;
+    layer->previousCapacity = 256;
+    layer->previous = malloc(sizeof(NDL_StaticEntry)*layer->previousCapacity);
+    layer->spritesRedrawn = 0;
+    layer->dirtyRects = 0;
+    return layer;
+}
+
+void NDL_DestroyStaticLayer(NDL_StaticLayer* layer)
+{
+    for (int p = 0; p < layer->planeCount; ++p)
+    {
+        if (layer->planes[p].target != NULL) SDL_DestroyTexture(layer->planes[p].target);
+        free(layer->planes[p].dirty);
+    }
+    NDL_DestroyRenderQueue(layer->queue);
+    free(layer->entries);
+    free(layer->previous);
+    free(layer);
+}
+
+void NDL_InvalidateStaticLayer(NDL_StaticLayer* layer)
+{
+    layer->valid = false;
+}
+
+static NDL_StaticPlane* NDL_FindStaticPlane_G(NDL_StaticLayer* layer, Uint8 spriteLayer)
+{
+    for (int p = 0; p < layer->planeCount; ++p)
+    {
+        if (layer->planes[p].layer == spriteLayer) return &layer->planes[p];
+    }
+    return NULL;
+}
+
+// Finds or adds the plane for a sprite layer, keeping the planes sorted; NULL when all are taken
+static NDL_StaticPlane* NDL_AcquireStaticPlane_G(NDL_StaticLayer* layer, Uint8 spriteLayer)
+{
+    NDL_StaticPlane* plane = NDL_FindStaticPlane_G(layer, spriteLayer);
+    if (plane != NULL || layer->planeCount == NDL_STATIC_LAYER_PLANES) return plane;
+    int p = layer->planeCount++;
+    for (; p > 0 && layer->planes[p - 1].layer > spriteLayer; --p) layer->planes[p] = layer->planes[p - 1];
+    plane = &layer->planes[p];
+    plane->layer = spriteLayer;
+    plane->target = NULL;
+    plane->valid = false;
+    plane->count = 0;
+    plane->dirtyCount = 0;
+    plane->dirtyCapacity = 32;
+    plane->dirty = malloc(sizeof(SDL_Rect)*plane->dirtyCapacity);
+    return plane;
+}
+
+/*
+ * Where the sprite is drawn: alpha of the way from its previous physics tick to its latest one.
+ * position is only kept by NDL_SyncSpriteTransform, the transform system and NDL_SetSpritePosition,
+ * which mark the sprite interpolated. Any other sprite is placed through imageRect, drawn as is.
+ */
+static inline Vector2F NDL_DrawPosition_G(const NDL_SpriteComponent* sprite, float alpha)
+{
+    if (!sprite->interpolated)
+    {
+        return (Vector2F){(float)sprite->imageRect.x, (float)sprite->imageRect.y};
+    }
+    return (Vector2F){
+        sprite->previousPosition.x + (sprite->position.x - sprite->previousPosition.x)*alpha,
+        sprite->previousPosition.y + (sprite->position.y - sprite->previousPosition.y)*alpha
+    };
+}
+
+// Scaled destination rect in view space; rotation is applied about its centre when drawn
+static inline SDL_FRect NDL_SpriteDst_G(const NDL_SpriteComponent* sprite, float alpha, Vector2F cam, float zoom)
+{
+    Vector2F p = NDL_DrawPosition_G(sprite, alpha);
+    return (SDL_FRect){(p.x - cam.x)*zoom, (p.y - cam.y)*zoom, sprite->imageRect.w*sprite->scale.x*zoom, sprite->imageRect.h*sprite->scale.y*zoom};
+}
+
+// Returns false when the sprite's layer has no plane left, and the sprite must be drawn dynamically
+static bool NDL_AddStaticEntry_G(NDL_StaticLayer* layer, NDL_Entity* e, float zoom)
+{
+    if (NDL_AcquireStaticPlane_G(layer, e->sprite->layer) == NULL) return false;
+    if (layer->count == layer->capacity)
+    {
+        layer->capacity *= 2;
+        layer->entries = realloc(layer->entries, sizeof(NDL_StaticEntry)*layer->capacity);
+    }
+    NDL_SpriteComponent* sprite = e->sprite;
+    NDL_StaticEntry* entry = &layer->entries[layer->count++];
+    entry->entity = e;
+    // Zoomed world space for now; NDL_UpdateStaticLayer_G moves it into plane space
+    entry->dst = NDL_SpriteDst_G(sprite, 1.0f, (Vector2F){0,0}, zoom);
+    entry->image = NDL_SpriteTexture_G(sprite, zoom, NULL);
+    entry->uv = sprite->uv;
+    entry->color = sprite->color;
+    entry->layer = sprite->layer;
+    return true;
+}
+
+static int NDL_CompareStaticEntries_G(const void* a, const void* b)
+{
+    uintptr_t ea = (uintptr_t)((const NDL_StaticEntry*)a)->entity;
+    uintptr_t eb = (uintptr_t)((const NDL_StaticEntry*)b)->entity;
+    return (ea > eb) - (ea < eb);
+}
+
+static void NDL_AddDirtyRect_G(NDL_StaticLayer* layer, Uint8 spriteLayer, SDL_FRect r)
+{
+    NDL_StaticPlane* plane = NDL_FindStaticPlane_G(layer, spriteLayer);
+    if (plane == NULL) return;
+    SDL_Rect rect;
+    rect.x = (int)floorf(r.x);
+    rect.y = (int)floorf(r.y);
+    rect.w = (int)ceilf(r.x + r.w) - rect.x;
+    rect.h = (int)ceilf(r.y + r.h) - rect.y;
+    SDL_Rect screen = {0, 0, layer->w, layer->h};
+    if (!SDL_IntersectRect(&rect, &screen, &rect)) return;
+
+    // Fold into any rect it touches so overlapping areas are only redrawn once
+    for (int i = 0; i < plane->dirtyCount; ++i)
+    {
+        if (SDL_HasIntersection(&rect, &plane->dirty[i]))
+        {
+            SDL_UnionRect(&rect, &plane->dirty[i], &rect);
+            plane->dirty[i] = plane->dirty[--plane->dirtyCount];
+            i = -1;
+        }
+    }
+    if (plane->dirtyCount == plane->dirtyCapacity)
+    {
+        // Too many scattered rects: one bounding rect is cheaper than many small passes
+        for (int i = 0; i < plane->dirtyCount; ++i) SDL_UnionRect(&rect, &plane->dirty[i], &rect);
+        plane->dirtyCount = 0;
+    }
+    plane->dirty[plane->dirtyCount++] = rect;
+}
+
+static bool NDL_StaticEntryChanged_G(const NDL_StaticEntry* a, const NDL_StaticEntry* b)
+{
+    return a->dst.x != b->dst.x || a->dst.y != b->dst.y || a->dst.w != b->dst.w || a->dst.h != b->dst.h ||
+           a->image != b->image || a->layer != b->layer ||
+           a->uv.x != b->uv.x || a->uv.y != b->uv.y || a->uv.w != b->uv.w || a->uv.h != b->uv.h ||
+           a->color.r != b->color.r || a->color.g != b->color.g || a->color.b != b->color.b || a->color.a != b->color.a;
+}
+
+static void NDL_UpdateStaticLayer_G(NDL_RenderSystem* renSys, NDL_StaticLayer* layer, Vector2F cam, int viewW, int viewH)
+{
+    Renderer ren = renSys->sdlRenderer;
+    int margin = NDL_STATIC_LAYER_MARGIN;
+    float zoom = NDL_CameraZoom_G(renSys->camera);
+    layer->spritesRedrawn = 0;
+    layer->dirtyRects = 0;
+    if (layer->w != viewW + 2*margin || layer->h != viewH + 2*margin)
+    {
+        layer->w = viewW + 2*margin;
+        layer->h = viewH + 2*margin;
+        layer->valid = false;
+    }
+    // Within the margin the planes are only shifted; past it, or at a new zoom, they are rebaked
+    bool scrolledOut = fabsf((cam.x - layer->camera.x)*zoom) > margin || fabsf((cam.y - layer->camera.y)*zoom) > margin;
+    if (scrolledOut || layer->zoom != zoom) layer->valid = false;
+    if (!layer->valid)
+    {
+        layer->camera = cam;
+        layer->zoom = zoom;
+    }
+
+    for (int p = 0; p < layer->planeCount; ++p)
+    {
+        NDL_StaticPlane* plane = &layer->planes[p];
+        plane->dirtyCount = 0;
+        plane->count = 0;
+        int w = 0, h = 0;
+        if (plane->target != NULL) SDL_QueryTexture(plane->target, NULL, NULL, &w, &h);
+        if (plane->target == NULL || w != layer->w || h != layer->h)
+        {
+            if (plane->target != NULL) SDL_DestroyTexture(plane->target);
+            plane->target = SDL_CreateTexture(ren, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_TARGET, layer->w, layer->h);
+            if (plane->target == NULL) printf("Error creating static layer: %s\n", SDL_GetError());
+            else if (SDL_SetTextureBlendMode(plane->target, layer->compositeMode) != 0) SDL_SetTextureBlendMode(plane->target, SDL_BLENDMODE_BLEND);
+            plane->valid = false;
+        }
+        if (!layer->valid) plane->valid = false;
+        if (!plane->valid) NDL_AddDirtyRect_G(layer, plane->layer, (SDL_FRect){0, 0, (float)layer->w, (float)layer->h});
+    }
+
+    Vector2F origin = {layer->camera.x*zoom - margin, layer->camera.y*zoom - margin};
+    for (int i = 0; i < layer->count; ++i)
+    {
+        layer->entries[i].dst.x -= origin.x;
+        layer->entries[i].dst.y -= origin.y;
+        ++NDL_FindStaticPlane_G(layer, layer->entries[i].layer)->count;
+    }
+    qsort(layer->entries, layer->count, sizeof(NDL_StaticEntry), NDL_CompareStaticEntries_G);
+    if (layer->valid)
+    {
+        // Merge walk of two pointer-sorted lists
+        int i = 0, j = 0;
+        while (i < layer->count || j < layer->previousCount)
+        {
+            NDL_StaticEntry* now = i < layer->count ? &layer->entries[i] : NULL;
+            NDL_StaticEntry* before = j < layer->previousCount ? &layer->previous[j] : NULL;
+            if (before == NULL || (now != NULL && (uintptr_t)now->entity < (uintptr_t)before->entity))
+            {
+                NDL_AddDirtyRect_G(layer, now->layer, now->dst);
+                ++i;
+            } else if (now == NULL || (uintptr_t)before->entity < (uintptr_t)now->entity) {
+                NDL_AddDirtyRect_G(layer, before->layer, before->dst);
+                ++j;
+            } else {
+                if (NDL_StaticEntryChanged_G(now, before))
+                {
+                    NDL_AddDirtyRect_G(layer, before->layer, before->dst);
+                    NDL_AddDirtyRect_G(layer, now->layer, now->dst);
+                }
+                ++i;
+                ++j;
+            }
+        }
+    }
+
+    // Keep this frame's entries for next frame's diff
+    if (layer->previousCapacity < layer->count)
+    {
+        layer->previousCapacity = layer->capacity;
+        layer->previous = realloc(layer->previous, sizeof(NDL_StaticEntry)*layer->previousCapacity);
+    }
+    memcpy(layer->previous, layer->entries, sizeof(NDL_StaticEntry)*layer->count);
+    layer->previousCount = layer->count;
+    layer->valid = true;
+    for (int p = 0; p < layer->planeCount; ++p) layer->dirtyRects += layer->planes[p].dirtyCount;
+    if (layer->dirtyRects == 0) return;
+
+    NDL_ClearRenderQueue(layer->queue);
+    for (int i = 0; i < layer->count; ++i) NDL_SubmitRenderQueue(layer->queue, layer->entries[i].entity);
+    layer->queue->zoom = layer->zoom;
+    NDL_SortRenderQueue(layer->queue);
+
+    // Baking changes the draw state; the caller's is put back afterwards
+    NDL_Color previousColor = NDL_GetDrawColor_G(ren);
+    SDL_BlendMode previousBlend = NDL_GetDrawBlendMode_G(ren);
+    NDL_Texture* previousTarget = NDL_GetRenderTarget(ren);
+    renSys->batch->ordered = true;
+    for (int p = 0; p < layer->planeCount; ++p)
+    {
+        NDL_StaticPlane* plane = &layer->planes[p];
+        if (plane->dirtyCount == 0 || plane->target == NULL) continue;
+        NDL_SetRenderTarget(ren, plane->target);
+        for (int d = 0; d < plane->dirtyCount; ++d)
+        {
+            SDL_Rect* clip = &plane->dirty[d];
+            SDL_RenderSetClipRect(ren, clip);
+            NDL_SetDrawBlendMode(ren, SDL_BLENDMODE_NONE);
+            NDL_SetDrawColor(ren, (NDL_Color){0, 0, 0, 0});
+            SDL_RenderFillRect(ren, clip);
+            NDL_CountDraw_G(ren, NULL, 4);
+            NDL_SetDrawBlendMode(ren, SDL_BLENDMODE_BLEND);
+            SDL_FRect clipF = {(float)clip->x, (float)clip->y, (float)clip->w, (float)clip->h};
+            for (int k = 0; k < layer->queue->count; ++k)
+            {
+                NDL_StaticEntry* entry = &layer->entries[layer->queue->keys[k] & NDL_RENDER_KEY_SEQUENCE_MASK];
+                if (entry->layer != plane->layer || !SDL_HasIntersectionF(&entry->dst, &clipF)) continue;
+                if (entry->image == NULL) NDL_BatchFillRect(renSys->batch, &entry->dst, entry->color);
+                else NDL_BatchSprite(renSys->batch, entry->image, &entry->uv, &entry->dst, (NDL_Color){255, 255, 255, 255});
+                ++layer->spritesRedrawn;
+            }
+            NDL_FlushSpriteBatch(renSys->batch);
+        }
+        SDL_RenderSetClipRect(ren, NULL);
+        plane->valid = true;
+    }
+    NDL_SetRenderTarget(ren, previousTarget);
+    NDL_SetDrawBlendMode(ren, previousBlend);
+    NDL_SetDrawColor(ren, previousColor);
+}
+
+// Draws a plane under the camera; pending batched sprites go first so they stay beneath it
+static void NDL_CompositeStaticPlane_G(NDL_RenderSystem* renSys, NDL_StaticLayer* layer, NDL_StaticPlane* plane, Vector2F cam, float zoom)
+{
+    if (plane->target == NULL || plane->count == 0) return;
+    NDL_FlushSpriteBatch(renSys->batch);
+    SDL_FRect dst = {(layer->camera.x - cam.x)*zoom - NDL_STATIC_LAYER_MARGIN, (layer->camera.y - cam.y)*zoom - NDL_STATIC_LAYER_MARGIN, (float)layer->w, (float)layer->h};
+    SDL_RenderCopyF(renSys->sdlRenderer, plane->target, NULL, &dst);
+    NDL_CountDraw_G(renSys->sdlRenderer, plane->target, 4);
+    ++renSys->drawCalls;
+}
+
+static void NDL_ApplyAnimationFrame_G(NDL_SpriteComponent* sprite, NDL_AnimationComponent* anim)
+{
+    sprite->image = anim->imageSet->images[anim->currentFrame];
+    if (anim->imageSet->regions != NULL) NDL_SetSpriteRegion(sprite, &anim->imageSet->regions[anim->currentFrame]);
+}
+
+// Steps an animation not owned by an NDL_AnimationSystem; a custom flip method's texture is drawn whole.
+// Returns whether it is still running, so the render system can keep an idle scheduler drawing.
+static bool NDL_StepLegacyAnimation_G(NDL_SpriteComponent* sprite, NDL_AnimationComponent* anim, float deltaTime)
+{
+    NDL_Texture* image = anim->flip(anim, deltaTime);
+    NDL_ApplyAnimationFrame_G(sprite, anim);
+    if (image != NULL && image != sprite->image)
+    {
+        sprite->image = image;
+        sprite->srcRect = (Rect){0,0,0,0};
+        sprite->uv = (SDL_FRect){0,0,1,1};
+    }
+    return !anim->finished;
+}
+
+// World-space bounds of the drawn sprite; a rotated sprite uses the circle through its corners
+static inline SDL_FRect NDL_SpriteBounds_G(const NDL_SpriteComponent* sprite, float alpha)
+{
+    SDL_FRect b = NDL_SpriteDst_G(sprite, alpha, (Vector2F){0, 0}, 1.0f);
+    if (sprite->angle != 0.0f)
+    {
+        float r = 0.5f*sqrtf(b.w*b.w + b.h*b.h);
+        b = (SDL_FRect){b.x + b.w*0.5f - r, b.y + b.h*0.5f - r, 2.0f*r, 2.0f*r};
+    }
+    return b;
+}
+
+static inline bool NDL_BoundsInView_G(SDL_FRect b, SDL_FRect view)
+{
+    return !(b.x + b.w <= view.x || b.x >= view.x + view.w ||
+             b.y + b.h <= view.y || b.y >= view.y + view.h);
+}
+
+static inline bool NDL_SpriteInView_G(NDL_Entity* e, SDL_FRect view, float alpha)
+{
+    if (!NDL_HasComponent(e, SPRITE_COMPONENT)) return false;
+    return NDL_BoundsInView_G(NDL_SpriteBounds_G(e->sprite, alpha), view);
+}
+
+// Entities that may be visible: grid query results (stored in renSys->visible) or the whole pool
+static int NDL_GatherCandidates_G(NDL_RenderSystem* renSys, SDL_FRect view, NDL_Entity*** out)
+{
+    NDL_Entity** candidates = renSys->pool->entities;
+    int candidateCount = renSys->pool->size;
+    if (renSys->cullGrid != NULL)
+    {
+        candidateCount = NDL_QueryGridRect(renSys->cullGrid, view, renSys->visible, renSys->visibleCapacity);
+        if (candidateCount > renSys->visibleCapacity)
+        {
+            renSys->visibleCapacity = candidateCount*2;
+            renSys->visible = realloc(renSys->visible, sizeof(NDL_Entity*)*renSys->visibleCapacity);
+            candidateCount = NDL_QueryGridRect(renSys->cullGrid, view, renSys->visible, renSys->visibleCapacity);
+        }
+        candidates = renSys->visible;
+    } else if (candidateCount > renSys->visibleCapacity) {
+        renSys->visibleCapacity = candidateCount*2;
+        renSys->visible = realloc(renSys->visible, sizeof(NDL_Entity*)*renSys->visibleCapacity);
+    }
+    *out = candidates;
+    return candidateCount;
+}
+
+static void NDL_CollectVisible_G(NDL_RenderSystem* renSys, SDL_FRect view)
+{
+    NDL_Entity** candidates;
+    int candidateCount = NDL_GatherCandidates_G(renSys, view, &candidates);
+
+    // Exact test against the sprite bounds; compacts in place when the candidates are the grid results
+    int visibleCount = 0;
+    for (int i = 0; i < candidateCount; ++i)
+    {
+        NDL_Entity* e = candidates[i];
+        if (!NDL_SpriteInView_G(e, view, renSys->interpolationAlpha)) continue;
+        e->sprite->visibleFrame = renSys->frame;
+        renSys->visible[visibleCount++] = e;
+    }
+    renSys->visibleCount = visibleCount;
+}
+
+static void NDL_ReserveVisible_G(NDL_RenderSystem* renSys, int count)
+{
+    if (count > renSys->visibleCapacity)
+    {
+        renSys->visibleCapacity = count*2;
+        renSys->visible = realloc(renSys->visible, sizeof(NDL_Entity*)*renSys->visibleCapacity);
+    }
+}
+
+/*
+ * Split-screen culling. Each candidate is bounded once and tested against every view once,
+ * and the views it falls in are kept as a bitmask on its sprite. With a cull grid
+ * each view is queried on its own, so views far apart never pull in the map between them.
+ */
+static void NDL_CollectVisibleViews_G(NDL_RenderSystem* renSys, const SDL_FRect* views, int viewCount)
+{
+    int visibleCount = 0;
+    int queries = renSys->cullGrid != NULL ? viewCount : 1;
+    for (int q = 0; q < queries; ++q)
+    {
+        NDL_Entity** candidates = renSys->pool->entities;
+        int candidateCount = renSys->pool->size;
+        if (renSys->cullGrid != NULL)
+        {
+            candidateCount = NDL_QueryGridRect(renSys->cullGrid, views[q], renSys->viewCandidates, renSys->viewCandidateCapacity);
+            if (candidateCount > renSys->viewCandidateCapacity)
+            {
+                renSys->viewCandidateCapacity = candidateCount*2;
+                renSys->viewCandidates = realloc(renSys->viewCandidates, sizeof(NDL_Entity*)*renSys->viewCandidateCapacity);
+                candidateCount = NDL_QueryGridRect(renSys->cullGrid, views[q], renSys->viewCandidates, renSys->viewCandidateCapacity);
+            }
+            candidates = renSys->viewCandidates;
+        }
+        NDL_ReserveVisible_G(renSys, visibleCount + candidateCount);
+        for (int i = 0; i < candidateCount; ++i)
+        {
+            NDL_Entity* e = candidates[i];
+            // Already taken from an overlapping view's query, with every view tested
+            if (!NDL_HasComponent(e, SPRITE_COMPONENT) || e->sprite->visibleFrame == renSys->frame) continue;
+            SDL_FRect b = NDL_SpriteBounds_G(e->sprite, renSys->interpolationAlpha);
+            Uint8 mask = 0;
+            for (int v = 0; v < viewCount; ++v)
+            {
+                if (NDL_BoundsInView_G(b, views[v])) mask |= (Uint8)(1 << v);
+            }
+            if (mask == 0) continue;
+            e->sprite->visibleFrame = renSys->frame;
+            e->sprite->viewMask = mask;
+            renSys->visible[visibleCount++] = e;
+        }
+    }
+    renSys->visibleCount = visibleCount;
+}
+
+NDL_RenderRecorder* NDL_CreateRenderRecorder(NDL_ThreadPool* pool)
+{
+    NDL_RenderRecorder* recorder = malloc(sizeof(NDL_RenderRecorder));
+    recorder->pool = pool;
+    recorder->jobSize = 2048;
+    recorder->bufferCount = 0;
+    recorder->buffers = NULL;
+    recorder->vertexCapacity = 0;
+    recorder->vertices = NULL;
+    recorder->renSys = NULL;
+    recorder->candidates = NULL;
+    recorder->candidateCount = 0;
+    recorder->view = (SDL_FRect){0, 0, 0, 0};
+    recorder->camera = (Vector2F){0, 0};
+    recorder->zoom = 1.0f;
+    return recorder;
+}
+
+void NDL_DestroyRenderRecorder(NDL_RenderRecorder* recorder)
+{
+    for (int b = 0; b < recorder->bufferCount; ++b)
+    {
+        free(recorder->buffers[b].entities);
+        free(recorder->buffers[b].misses);
+    }
+    free(recorder->buffers);
+    free(recorder->vertices);
+    free(recorder);
+}
+
+static int NDL_ReserveRecorderJobs_G(NDL_RenderRecorder* recorder, int count)
+{
+    int jobs = (count + recorder->jobSize - 1) / recorder->jobSize;
+    if (jobs > recorder->bufferCount)
+    {
+        recorder->buffers = realloc(recorder->buffers, sizeof(NDL_RenderCommandBuffer)*jobs);
+        for (int b = recorder->bufferCount; b < jobs; ++b)
+        {
+            recorder->buffers[b].count = 0;
+            recorder->buffers[b].entities = malloc(sizeof(NDL_Entity*)*recorder->jobSize);
+            recorder->buffers[b].missCount = 0;
+            recorder->buffers[b].misses = malloc(sizeof(int)*recorder->jobSize);
+        }
+        recorder->bufferCount = jobs;
+    }
+    return jobs;
+}
+
+static void NDL_RecordCullJob_G(void* data, int job)
+{
+    NDL_RenderRecorder* recorder = data;
+    NDL_RenderCommandBuffer* buffer = &recorder->buffers[job];
+    int begin = job*recorder->jobSize;
+    int end = SDL_min(begin + recorder->jobSize, recorder->candidateCount);
+    Uint32 frame = recorder->renSys->frame;
+    buffer->count = 0;
+    for (int i = begin; i < end; ++i)
+    {
+        NDL_Entity* e = recorder->candidates[i];
+        if (!NDL_SpriteInView_G(e, recorder->view, recorder->renSys->interpolationAlpha)) continue;
+        e->sprite->visibleFrame = frame;
+        buffer->entities[buffer->count++] = e;
+    }
+}
+
+static void NDL_RecordKeyJob_G(void* data, int job)
+{
+    NDL_RenderRecorder* recorder = data;
+    NDL_RenderQueue* queue = recorder->renSys->queue;
+    NDL_RenderCommandBuffer* buffer = &recorder->buffers[job];
+    int begin = job*recorder->jobSize;
+    int end = SDL_min(begin + recorder->jobSize, queue->count);
+    buffer->missCount = 0;
+    for (int i = begin; i < end; ++i)
+    {
+        NDL_SpriteComponent* sprite = queue->entities[i]->sprite;
+        int id = NDL_FindTextureId_G(queue, NDL_KeyTexture_G(queue, sprite));
+        if (id < 0)
+        {
+            buffer->misses[buffer->missCount++] = i;
+            id = 0;
+        }
+        queue->keys[i] = NDL_RenderKeyBits_G(queue, sprite, (Uint64)id) | (Uint64)i;
+    }
+}
+
+static void NDL_RecordVertexJob_G(void* data, int job)
+{
+    NDL_RenderRecorder* recorder = data;
+    NDL_RenderQueue* queue = recorder->renSys->queue;
+    Vector2F cam = recorder->camera;
+    float zoom = recorder->zoom;
+    float alpha = recorder->renSys->interpolationAlpha;
+    int begin = job*recorder->jobSize;
+    int end = SDL_min(begin + recorder->jobSize, queue->count);
+    for (int k = begin; k < end; ++k)
+    {
+        NDL_SpriteComponent* sprite = queue->entities[queue->keys[k] & NDL_RENDER_KEY_SEQUENCE_MASK]->sprite;
+        SDL_FRect dst = NDL_SpriteDst_G(sprite, alpha, cam, zoom);
+        if (sprite->image == NULL) NDL_WriteQuadEx_G(recorder->vertices + k*4, NULL, &dst, sprite->color, sprite->angle);
+        else NDL_WriteQuadEx_G(recorder->vertices + k*4, &sprite->uv, &dst, (NDL_Color){255, 255, 255, 255}, sprite->angle);
+    }
+}
+
+// Cull, key, sort and build vertices for the frame, then submit one draw per run of equal textures
+static void NDL_RecordParallel_G(NDL_RenderSystem* renSys, SDL_FRect view, Vector2F cam, float zoom, float deltaTime)
+{
+    NDL_RenderRecorder* recorder = renSys->recorder;
+    NDL_RenderQueue* queue = renSys->queue;
+    recorder->renSys = renSys;
+    recorder->view = view;
+    recorder->camera = cam;
+    recorder->zoom = zoom;
+    recorder->candidateCount = NDL_GatherCandidates_G(renSys, view, &recorder->candidates);
+
+    int jobs = NDL_ReserveRecorderJobs_G(recorder, recorder->candidateCount);
+    NDL_RunParallel(recorder->pool, jobs, NDL_RecordCullJob_G, recorder);
+    // Candidates may be renSys->visible itself; the jobs are done reading it by now
+    int visibleCount = 0;
+    for (int j = 0; j < jobs; ++j)
+    {
+        NDL_RenderCommandBuffer* buffer = &recorder->buffers[j];
+        memcpy(renSys->visible + visibleCount, buffer->entities, sizeof(NDL_Entity*)*buffer->count);
+        visibleCount += buffer->count;
+    }
+    renSys->visibleCount = visibleCount;
+
+    // Animation callbacks are user code, so legacy animations still step on this thread
+    int count = SDL_min(visibleCount, (int)NDL_RENDER_KEY_SEQUENCE_MASK + 1);
+    NDL_ReserveRenderQueue_G(queue, count);
+    bool animating = false;
+    for (int i = 0; i < count; ++i)
+    {
+        NDL_Entity* e = renSys->visible[i];
+        if (NDL_HasComponent(e, ANIMATION_COMPONENT) && e->sprite->animation->system == NULL)
+        {
+            animating |= NDL_StepLegacyAnimation_G(e->sprite, e->sprite->animation, deltaTime);
+        }
+        queue->entities[i] = e;
+    }
+    if (animating && renSys->scheduler != NULL) NDL_RequestAnimation(renSys->scheduler, 0);
+    queue->count = count;
+    queue->zoom = zoom;
+    // The keys are rebuilt from scratch, so the next serial sort must not reuse them
+    queue->lastCount = 0;
+
+    jobs = NDL_ReserveRecorderJobs_G(recorder, count);
+    NDL_RunParallel(recorder->pool, jobs, NDL_RecordKeyJob_G, recorder);
+    for (int j = 0; j < jobs; ++j)
+    {
+        NDL_RenderCommandBuffer* buffer = &recorder->buffers[j];
+        for (int m = 0; m < buffer->missCount; ++m)
+        {
+            int i = buffer->misses[m];
+            queue->keys[i] = NDL_RenderKey_G(queue, queue->entities[i]->sprite) | (Uint64)i;
+        }
+    }
+    NDL_RadixSort64_G(queue->keys, queue->scratch, count);
+    ++queue->radixSorts;
+
+    if (count > recorder->vertexCapacity)
+    {
+        recorder->vertexCapacity = count*2;
+        free(recorder->vertices);
+        recorder->vertices = malloc(sizeof(SDL_Vertex)*4*recorder->vertexCapacity);
+    }
+    NDL_RunParallel(recorder->pool, jobs, NDL_RecordVertexJob_G, recorder);
+
+    int start = 0;
+    for (int k = 1; k <= count; ++k)
+    {
+        NDL_Texture* texture = NDL_SpriteTexture_G(queue->entities[queue->keys[start] & NDL_RENDER_KEY_SEQUENCE_MASK]->sprite, zoom, NULL);
+        if (k < count && NDL_SpriteTexture_G(queue->entities[queue->keys[k] & NDL_RENDER_KEY_SEQUENCE_MASK]->sprite, zoom, NULL) == texture) continue;
+        int quads = k - start;
+        NDL_ReserveBatchIndices_G(renSys->batch, quads);
+        SDL_RenderGeometry(renSys->sdlRenderer, texture, recorder->vertices + start*4, quads*4, renSys->batch->indices, quads*6);
+        NDL_CountDraw_G(renSys->sdlRenderer, texture, quads*4);
+        ++renSys->drawCalls;
+        start = k;
+    }
+}
+
+static void NDL_QueueVisible_G(NDL_RenderSystem* renSys, NDL_StaticLayer* staticLayer, SDL_FRect view, float zoom, float deltaTime);
+
+// Culls against view, steps legacy animations and sorts the survivors into renSys->queue
+static void NDL_BuildRenderQueue_G(NDL_RenderSystem* renSys, NDL_StaticLayer* staticLayer, SDL_FRect view, float zoom, float deltaTime)
+{
+    SDL_FRect cull = view;
+    if (staticLayer != NULL)
+    {
+        // Static sprites are also baked into the planes' margin around the view
+        float margin = NDL_STATIC_LAYER_MARGIN / zoom;
+        cull = (SDL_FRect){view.x - margin, view.y - margin, view.w + 2.0f*margin, view.h + 2.0f*margin};
+    }
+    NDL_CollectVisible_G(renSys, cull);
+    NDL_QueueVisible_G(renSys, staticLayer, view, zoom, deltaTime);
+}
+
+// Steps legacy animations of renSys->visible and sorts them into renSys->queue, or the static layer
+static void NDL_QueueVisible_G(NDL_RenderSystem* renSys, NDL_StaticLayer* staticLayer, SDL_FRect view, float zoom, float deltaTime)
+{
+    NDL_RenderQueue* queue = renSys->queue;
+    if (staticLayer != NULL) staticLayer->count = 0;
+    NDL_ClearRenderQueue(queue);
+    bool animating = false;
+    for (int i = 0; i < renSys->visibleCount; i++)
+    {
+        NDL_SpriteComponent* sprite = renSys->visible[i]->sprite;
+        // Animations owned by an NDL_AnimationSystem were already advanced by its pass
+        if (NDL_HasComponent(renSys->visible[i], ANIMATION_COMPONENT) && sprite->animation->system == NULL)
+        {
+            animating |= NDL_StepLegacyAnimation_G(sprite, sprite->animation, deltaTime);
+        }
+        // The static layer redraws by axis-aligned dirty rects, so rotated sprites stay dynamic
+        if (staticLayer != NULL && sprite->isStatic && sprite->angle == 0.0f && NDL_AddStaticEntry_G(staticLayer, renSys->visible[i], zoom)) continue;
+        if (staticLayer != NULL && !NDL_SpriteInView_G(renSys->visible[i], view, renSys->interpolationAlpha)) continue;
+        NDL_SubmitRenderQueue(queue, renSys->visible[i]);
+    }
+    if (animating && renSys->scheduler != NULL) NDL_RequestAnimation(renSys->scheduler, 0);
+    // The soft renderer samples the full-size image, so its keys must too
+    queue->zoom = renSys->soft == NULL ? zoom : 0.0f;
+    NDL_SortRenderQueue(queue);
+}
+
+/*
+ * Draws the sorted queue through the batch or one call per sprite; a non-zero viewBit only draws
+ * sprites whose viewMask has it. Each static plane is composited before the first
+ * sprite on a higher layer, so it sits at its layer's place in the order.
+ */
+static int NDL_DrawRenderQueue_G(NDL_RenderSystem* renSys, NDL_StaticLayer* staticLayer, Vector2F cam, float zoom, Uint8 viewBit)
+{
+    NDL_RenderQueue* queue = renSys->queue;
+    Renderer ren = renSys->sdlRenderer;
+    bool batched = renSys->useBatching || renSys->soft != NULL;
+    int drawn = 0;
+    int plane = 0;
+    int planeCount = staticLayer != NULL ? staticLayer->planeCount : 0;
+    renSys->batch->ordered = true;
+    for (int k = 0; k < queue->count; k++)
+    {
+        NDL_Entity* e = queue->entities[queue->keys[k] & NDL_RENDER_KEY_SEQUENCE_MASK];
+        NDL_SpriteComponent* sprite = e->sprite;
+        // Every queued sprite was collected this frame, which set its viewMask alongside visibleFrame
+        if (viewBit != 0 && !(sprite->viewMask & viewBit)) continue;
+        for (; plane < planeCount && staticLayer->planes[plane].layer <= sprite->layer; ++plane)
+        {
+            NDL_CompositeStaticPlane_G(renSys, staticLayer, &staticLayer->planes[plane], cam, zoom);
+        }
+        SDL_FRect dst = NDL_SpriteDst_G(sprite, renSys->interpolationAlpha, cam, zoom);
+        // Soft textures are registered by their full-size handle, so LOD levels stay on the SDL path
+        int level = 0;
+        NDL_Texture* image = renSys->soft == NULL ? NDL_SpriteTexture_G(sprite, zoom, &level) : sprite->image;
+        ++drawn;
+        if (batched)
+        {
+            if (image == NULL) NDL_BatchSpriteEx(renSys->batch, NULL, NULL, &dst, sprite->color, sprite->angle);
+            else NDL_BatchSpriteEx(renSys->batch, image, &sprite->uv, &dst, (NDL_Color){255, 255, 255, 255}, sprite->angle);
+            continue;
+        }
+
+        SDL_Rect levelSrc = {sprite->srcRect.x >> level, sprite->srcRect.y >> level, SDL_max(1, sprite->srcRect.w >> level), SDL_max(1, sprite->srcRect.h >> level)};
+        const SDL_Rect* src = sprite->srcRect.w > 0 ? &levelSrc : NULL;
+        if (sprite->image == NULL && sprite->angle != 0.0f)
+        {
+            static const int quadIndices[6] = {0, 1, 2, 0, 2, 3};
+            SDL_Vertex v[4];
+            NDL_WriteQuadEx_G(v, NULL, &dst, sprite->color, sprite->angle);
+            SDL_RenderGeometry(ren, NULL, v, 4, quadIndices, 6);
+        } else if (sprite->image == NULL) {
+            NDL_SetDrawColor(ren, sprite->color);
+            SDL_RenderFillRectF(ren, &dst);
+        } else if (sprite->angle != 0.0f) {
+            SDL_RenderCopyExF(ren, image, src, &dst, sprite->angle, NULL, SDL_FLIP_NONE);
+        } else {
+            SDL_RenderCopyF(ren, image, src, &dst);
+        }
+        NDL_CountDraw_G(ren, image, 4);
+        renSys->drawCalls++;
+    }
+    for (; plane < planeCount; ++plane) NDL_CompositeStaticPlane_G(renSys, staticLayer, &staticLayer->planes[plane], cam, zoom);
+
+    if (batched)
+    {
+        NDL_FlushSpriteBatch(renSys->batch);
+        renSys->drawCalls += renSys->batch->drawCalls;
+    }
+    return drawn;
+}
+
+// Culls, sorts and draws the sprites on the calling thread, through the batch or one call per sprite
+static void NDL_RecordSerial_G(NDL_RenderSystem* renSys, NDL_StaticLayer* staticLayer, Vector2F cam, float zoom, int viewW, int viewH, float deltaTime)
+{
+    Renderer ren = renSys->sdlRenderer;
+    NDL_BuildRenderQueue_G(renSys, staticLayer, (SDL_FRect){cam.x, cam.y, viewW/zoom, viewH/zoom}, zoom, deltaTime);
+
+    if (staticLayer != NULL)
+    {
+        NDL_UpdateStaticLayer_G(renSys, staticLayer, cam, viewW, viewH);
+        // Bakes go through the sprite batch; only count the composites
+        NDL_ResetSpriteBatchStats(renSys->batch);
+    }
+    NDL_DrawRenderQueue_G(renSys, staticLayer, cam, zoom, 0);
+}
+
+static inline SDL_FRect NDL_ViewportWorldRect_G(const NDL_Viewport* vp)
+{
+    Vector2F cam = vp->camera != NULL ? vp->camera->position : (Vector2F){0,0};
+    float zoom = NDL_CameraZoom_G(vp->camera);
+    return (SDL_FRect){cam.x, cam.y, vp->rect.w/zoom, vp->rect.h/zoom};
+}
+
+/*
+ * Function: NDL_RenderViewports_G
+ * -------------------------------
+ * Split-screen path. Culling, animation and the sort run once for all views: each sprite is
+ * tested against every view in the shared pass and tagged with a bitmask of the views it is in.
+ * Each viewport then draws the shared queue filtered by its bit, so extra views cost their draw
+ * calls and not another pass over the scene.
+ */
+static void NDL_RenderViewports_G(NDL_RenderSystem* renSys, float deltaTime)
+{
+    SDL_FRect views[NDL_MAX_VIEWPORTS];
+    for (int v = 0; v < renSys->viewportCount; ++v) views[v] = NDL_ViewportWorldRect_G(&renSys->viewports[v]);
+    NDL_CollectVisibleViews_G(renSys, views, renSys->viewportCount);
+    // Views can zoom differently; the keys batch on the first view's LOD levels
+    NDL_QueueVisible_G(renSys, NULL, views[0], NDL_CameraZoom_G(renSys->viewports[0].camera), deltaTime);
+
+    for (int v = 0; v < renSys->viewportCount; ++v)
+    {
+        NDL_Viewport* vp = &renSys->viewports[v];
+        SDL_FRect view = views[v];
+        Uint8 viewBit = (Uint8)(1 << v);
+        Vector2F cam = {view.x, view.y};
+        float zoom = NDL_CameraZoom_G(vp->camera);
+        NDL_BeginRenderViewport(renSys, v);
+        NDL_ResetSpriteBatchStats(renSys->batch);
+        if (renSys->tilemap != NULL)
+        {
+            NDL_RenderTilemap(renSys, renSys->tilemap);
+            NDL_ResetSpriteBatchStats(renSys->batch);
+        }
+        vp->drawn = NDL_DrawRenderQueue_G(renSys, NULL, cam, zoom, viewBit);
+        if (renSys->showColliders)
+        {
+            for (int i = 0; i < renSys->visibleCount; i++)
+            {
+                NDL_Entity* e = renSys->visible[i];
+                if (NDL_HasComponent(e, COLLIDER_COMPONENT) && (e->sprite->viewMask & viewBit))
+                    NDL_BatchColliderOutlineZoomed_G(renSys->primitives, e->collider, cam, zoom, e->sprite->color);
+            }
+        }
+        renSys->drawCalls += NDL_FlushPrimitiveBatch(renSys->primitives);
+        NDL_EndRenderViewport(renSys);
+    }
+}
+
+void NDL_Render(NDL_RenderSystem* renSys, float deltaTime)
+{
+    Renderer ren = renSys->sdlRenderer;
+    NDL_SoftRenderer* soft = renSys->soft;
+    if (soft != NULL)
+    {
+        NDL_SoftClear(soft, renSys->clearColor);
+    } else {
+        int clearColor[4] = {renSys->clearColor.r, renSys->clearColor.g, renSys->clearColor.b, renSys->clearColor.a};
+        NDL_ClearScreen(renSys->sdlRenderer, clearColor);
+    }
+    renSys->drawCalls = 0;
+    ++renSys->frame;
+    NDL_ResetSpriteBatchStats(renSys->batch);
+    // The soft rasterizer has no clip rects, so it keeps drawing the single full-size view
+    if (renSys->viewportCount > 0 && soft == NULL)
+    {
+        NDL_RenderViewports_G(renSys, deltaTime);
+        return;
+    }
+    // Tilemap chunks and the static layer are render targets, which the soft renderer cannot read
+    if (renSys->tilemap != NULL && soft == NULL)
+    {
+        NDL_RenderTilemap(renSys, renSys->tilemap);
+        // Bakes go through the sprite batch; only count the chunk copies
+        NDL_ResetSpriteBatchStats(renSys->batch);
+    }
+
+    int viewW, viewH;
+    if (soft != NULL)
+    {
+        viewW = soft->target->w;
+        viewH = soft->target->h;
+    } else {
+        SDL_GetRendererOutputSize(ren, &viewW, &viewH);
+    }
+    Vector2F cam = renSys->camera != NULL ? renSys->camera->position : (Vector2F){0,0};
+    float zoom = NDL_CameraZoom_G(renSys->camera);
+    NDL_StaticLayer* staticLayer = soft == NULL ? renSys->staticLayer : NULL;
+    if (renSys->recorder != NULL && staticLayer == NULL && soft == NULL && renSys->useBatching)
+    {
+        NDL_RecordParallel_G(renSys, (SDL_FRect){cam.x, cam.y, viewW/zoom, viewH/zoom}, cam, zoom, deltaTime);
+    } else {
+        NDL_RecordSerial_G(renSys, staticLayer, cam, zoom, viewW, viewH, deltaTime);
+    }
+
+    // Collider outlines go on top of the sprites
+    if (renSys->showColliders)
+    {
+        for (int i = 0; i < renSys->visibleCount; i++)
+        {
+            NDL_Entity* e = renSys->visible[i];
+            if (NDL_HasComponent(e, COLLIDER_COMPONENT)) NDL_BatchColliderOutlineZoomed_G(renSys->primitives, e->collider, cam, zoom, e->sprite->color);
+        }
+    }
+    renSys->drawCalls += NDL_FlushPrimitiveBatch(renSys->primitives);
+    if (soft != NULL) NDL_SoftFlush(soft);
+}
+
+int NDL_AddRenderViewport(NDL_RenderSystem* renSys, SDL_Rect rect, NDL_Camera* camera)
+{
+    if (renSys->viewportCount == NDL_MAX_VIEWPORTS)
+    {
+        printf("Render system already has %d viewports!\n", NDL_MAX_VIEWPORTS);
+        return -1;
+    }
+    int index = renSys->viewportCount++;
+    NDL_SetRenderViewport(renSys, index, rect, camera);
+    return index;
+}
+
+void NDL_SetRenderViewport(NDL_RenderSystem* renSys, int index, SDL_Rect rect, NDL_Camera* camera)
+{
+    NDL_Viewport* vp = &renSys->viewports[index];
+    vp->rect = rect;
+    vp->camera = camera;
+    vp->drawn = 0;
+}
+
+void NDL_ClearRenderViewports(NDL_RenderSystem* renSys)
+{
+    NDL_EndRenderViewport(renSys);
+    renSys->viewportCount = 0;
+}
+
+void NDL_BeginRenderViewport(NDL_RenderSystem* renSys, int index)
+{
+    NDL_Viewport* vp = &renSys->viewports[index];
+    if (renSys->activeViewport < 0) renSys->mainCamera = renSys->camera;
+    renSys->activeViewport = index;
+    renSys->camera = vp->camera;
+    // Drawing is offset into the viewport; the clip rect is relative to it
+    SDL_Rect clip = {0, 0, vp->rect.w, vp->rect.h};
+    SDL_RenderSetViewport(renSys->sdlRenderer, &vp->rect);
+    SDL_RenderSetClipRect(renSys->sdlRenderer, &clip);
+}
+
+void NDL_EndRenderViewport(NDL_RenderSystem* renSys)
+{
+    if (renSys->activeViewport < 0) return;
+    renSys->camera = renSys->mainCamera;
+    renSys->activeViewport = -1;
+    SDL_RenderSetClipRect(renSys->sdlRenderer, NULL);
+    SDL_RenderSetViewport(renSys->sdlRenderer, NULL);
+}
+
+NDL_RenderSystem* NDL_CreateRenderSystem(Renderer sdlRenderer, NDL_Color clearColor)
+{
+    NDL_RenderSystem* renSys = malloc(sizeof(NDL_RenderSystem));
+    renSys->pool = NDL_CreatePool(1);
+    renSys->showColliders = false;
+    renSys->renderSpace = false;
+    renSys->clearColor = clearColor;
+    renSys->sdlRenderer = sdlRenderer;
+    renSys->render = NDL_Render;
+    renSys->useBatching = true;
+    renSys->batch = NDL_CreateSpriteBatch(sdlRenderer, 1024);
+    renSys->queue = NDL_CreateRenderQueue(256);
+    renSys->camera = NULL;
+    renSys->cullGrid = NULL;
+    renSys->visibleCapacity = 256;
+    renSys->visible = malloc(sizeof(NDL_Entity*)*renSys->visibleCapacity);
+    renSys->visibleCount = 0;
+    renSys->viewCandidateCapacity = 0;
+    renSys->viewCandidates = NULL;
+    renSys->tilemap = NULL;
+    renSys->staticLayer = NULL;
+    renSys->scheduler = NULL;
+    renSys->primitives = NDL_CreatePrimitiveBatch(sdlRenderer);
+    renSys->frame = 0;
+    renSys->drawCalls = 0;
+    renSys->soft = NULL;
+    renSys->recorder = NULL;
+    renSys->interpolationAlpha = 1.0f;
+    renSys->viewportCount = 0;
+    renSys->activeViewport = -1;
+    renSys->mainCamera = NULL;
+    return renSys;
+}
+
+/*
+ * Counts the .png files in directory fp, then walks them again calling load for each one with
+ * its index and full path. The second walk stops at the counted number of images, so files
+ * added in between are ignored, and paths that don't fit MAX_PATH are skipped.
+ */
+static NDL_ImageSet* NDL_CreateImageSetFromDirectory_G(const char* fp, bool regions, void (*load)(NDL_ImageSet*, int, const char*, void*), void* data)
+{
+    WIN32_FIND_DATA findFileData;
+    HANDLE hFind = INVALID_HANDLE_VALUE;
+    int imageCount = 0;
+    char searchPath[MAX_PATH];
+
+    // Create a search path for .png files
+    if (snprintf(searchPath, MAX_PATH, "%s\\*.png", fp) >= MAX_PATH) {
+        printf("Image directory path is too long: %s\n", fp);
+        return NULL;
+    }
+    hFind = FindFirstFile(searchPath, &findFileData);
+
+    if (hFind == INVALID_HANDLE_VALUE) {
+        printf("No .png files found.\n");
+        return NULL;
+    } 
+
+    // Count .png files
+    do {
+        if (!(findFileData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)) {
+            imageCount++;
+        }
+    } while (FindNextFile(hFind, &findFileData) != 0);
+
+    FindClose(hFind);
+
+    // Allocate memory for NDL_ImageSet and its images array
+    NDL_ImageSet* imageSet = malloc(sizeof(NDL_ImageSet));
+    imageSet->images = malloc(sizeof(NDL_Texture*) * imageCount);
+    imageSet->regions = regions ? malloc(sizeof(NDL_AtlasRegion) * imageCount) : NULL;
+
+    // Iterate over files again to load each image
+    hFind = FindFirstFile(searchPath, &findFileData);
+    int i = 0;
+    if (hFind != INVALID_HANDLE_VALUE) {
+        do {
+            if (!(findFileData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)) {
+                char imagePath[MAX_PATH];
+                if (snprintf(imagePath, MAX_PATH, "%s\\%s", fp, findFileData.cFileName) >= MAX_PATH) {
+                    printf("Image path is too long: %s\\%s\n", fp, findFileData.cFileName);
+                    continue;
+                }
+                load(imageSet, i, imagePath, data);
+                i++;
+            }
+        } while (i < imageCount && FindNextFile(hFind, &findFileData) != 0);
+        FindClose(hFind);
+    }
+    // Files removed between the two walks leave the set shorter
+    imageSet->imageCount = i;
+    return imageSet;
+}
+
+static void NDL_LoadImageSetTexture_G(NDL_ImageSet* imageSet, int i, const char* path, void* ren)
+{
+    imageSet->images[i] = NDL_CreateTexture((Renderer)ren, path);
+}
+
+static void NDL_LoadImageSetRegion_G(NDL_ImageSet* imageSet, int i, const char* path, void* atlas)
+{
+    if (!NDL_AtlasAddImage((NDL_Atlas*)atlas, path, &imageSet->regions[i]))
+    {
+        printf("Error adding %s to atlas!\n", path);
+        imageSet->regions[i] = (NDL_AtlasRegion){NULL, {0,0,0,0}, {0,0,1,1}};
+    }
+    imageSet->images[i] = imageSet->regions[i].texture;
+}
+
+NDL_ImageSet* NDL_CreateImageSet_PNG(Renderer ren, const char* fp)
+{
+    return NDL_CreateImageSetFromDirectory_G(fp, false, NDL_LoadImageSetTexture_G, ren);
+}
+
+NDL_ImageSet* NDL_CreateImageSet_PNG_Atlas(NDL_Atlas* atlas, const char* fp)
+{
+    return NDL_CreateImageSetFromDirectory_G(fp, true, NDL_LoadImageSetRegion_G, atlas);
+}
+
+NDL_Atlas* NDL_CreateAtlas(Renderer renderer, int pageWidth, int pageHeight)
+{
+    NDL_Atlas* atlas = malloc(sizeof(NDL_Atlas));
+    atlas->sdlRenderer = renderer;
+    atlas->pageWidth = pageWidth;
+    atlas->pageHeight = pageHeight;
+    atlas->padding = 1;
+    atlas->pageCount = 0;
+    atlas->pageCapacity = 4;
+    atlas->pages = malloc(sizeof(NDL_AtlasPage)*atlas->pageCapacity);
+    return atlas;
+}
+
+void NDL_DestroyAtlas(NDL_Atlas* atlas)
+{
+    for (int p = 0; p < atlas->pageCount; ++p)
+    {
+        free(SDL_GetTextureUserData(atlas->pages[p].texture));
+        SDL_DestroyTexture(atlas->pages[p].texture);
+        free(atlas->pages[p].skyline);
+        free(atlas->pages[p].skylineWidth);
+    }
+    free(atlas->pages);
+    free(atlas);
+}
+
+static NDL_AtlasPage* NDL_AddAtlasPage_G(NDL_Atlas* atlas)
+{
+    NDL_Texture* texture = SDL_CreateTexture(atlas->sdlRenderer, SDL_PIXELFORMAT_RGBA32, SDL_TEXTUREACCESS_STATIC, atlas->pageWidth, atlas->pageHeight);
+    if (texture == NULL)
+    {
+        printf("Error creating atlas page: %s\n", SDL_GetError());
+        return NULL;
+    }
+    // Start fully transparent so the padding between images never shows garbage
+    Uint32* clear = calloc((size_t)atlas->pageWidth*atlas->pageHeight, sizeof(Uint32));
+    SDL_UpdateTexture(texture, NULL, clear, atlas->pageWidth*4);
+    free(clear);
+    SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_BLEND);
+    // Marks the page so NDL_BuildTextureLOD refuses it
+    NDL_TextureLOD* lod = malloc(sizeof(NDL_TextureLOD));
+    lod->levels[0] = texture;
+    lod->levelCount = 1;
+    lod->atlasPage = true;
+    SDL_SetTextureUserData(texture, lod);
+
+    if (atlas->pageCount == atlas->pageCapacity)
+    {
+        atlas->pageCapacity *= 2;
+        atlas->pages = realloc(atlas->pages, sizeof(NDL_AtlasPage)*atlas->pageCapacity);
+    }
+    NDL_AtlasPage* page = &atlas->pages[atlas->pageCount++];
+    page->texture = texture;
+    page->skyline = malloc(sizeof(SDL_Point)*(atlas->pageWidth + 1));
+    page->skylineWidth = malloc(sizeof(int)*(atlas->pageWidth + 1));
+    page->nodeCount = 1;
+    page->skyline[0] = (SDL_Point){0, 0};
+    page->skylineWidth[0] = atlas->pageWidth;
+    return page;
+}
+
+// Height at which a w x h rect fits when its left edge sits on skyline node `node`, or -1
+static int NDL_SkylineFit_G(NDL_AtlasPage* page, int node, int w, int h, int pageWidth, int pageHeight)
+{
+    int x = page->skyline[node].x;
+    if (x + w > pageWidth) return -1;
+    int y = 0;
+    int remaining = w;
+    for (int n = node; remaining > 0; ++n)
+    {
+        if (page->skyline[n].y > y) y = page->skyline[n].y;
+        if (y + h > pageHeight) return -1;
+        remaining -= page->skylineWidth[n];
+    }
+    return y;
+}
+
+static void NDL_SkylinePlace_G(NDL_AtlasPage* page, int node, int x, int y, int w)
+{
+    // Insert the new segment, then trim or drop the segments it now covers
+    memmove(&page->skyline[node + 1], &page->skyline[node], sizeof(SDL_Point)*(page->nodeCount - node));
+    memmove(&page->skylineWidth[node + 1], &page->skylineWidth[node], sizeof(int)*(page->nodeCount - node));
+    page->skyline[node] = (SDL_Point){x, y};
+    page->skylineWidth[node] = w;
+    ++page->nodeCount;
+
+    for (int n = node + 1; n < page->nodeCount; )
+    {
+        int covered = x + w - page->skyline[n].x;
+        if (covered <= 0) break;
+        if (covered < page->skylineWidth[n])
+        {
+            page->skyline[n].x += covered;
+            page->skylineWidth[n] -= covered;
+            break;
+        }
+        memmove(&page->skyline[n], &page->skyline[n + 1], sizeof(SDL_Point)*(page->nodeCount - n - 1));
+        memmove(&page->skylineWidth[n], &page->skylineWidth[n + 1], sizeof(int)*(page->nodeCount - n - 1));
+        --page->nodeCount;
+    }
+
+    // Merge neighbours of equal height
+    for (int n = 0; n < page->nodeCount - 1; )
+    {
+        if (page->skyline[n].y == page->skyline[n + 1].y)
+        {
+            page->skylineWidth[n] += page->skylineWidth[n + 1];
+            memmove(&page->skyline[n + 1], &page->skyline[n + 2], sizeof(SDL_Point)*(page->nodeCount - n - 2));
+            memmove(&page->skylineWidth[n + 1], &page->skylineWidth[n + 2], sizeof(int)*(page->nodeCount - n - 2));
+            --page->nodeCount;
+        } else {
+            ++n;
+        }
+    }
+}
+
+static bool NDL_AtlasPack_G(NDL_Atlas* atlas, NDL_AtlasPage* page, int w, int h, SDL_Point* out)
+{
+    int bestNode = -1, bestY = 0, bestBottom = SDL_MAX_SINT32, bestWidth = SDL_MAX_SINT32;
+    for (int n = 0; n < page->nodeCount; ++n)
+    {
+        int y = NDL_SkylineFit_G(page, n, w, h, atlas->pageWidth, atlas->pageHeight);
+        if (y < 0) continue;
+        if (y + h < bestBottom || (y + h == bestBottom && page->skylineWidth[n] < bestWidth))
+        {
+            bestNode = n;
+            bestY = y;
+            bestBottom = y + h;
+            bestWidth = page->skylineWidth[n];
+        }
+    }
+    if (bestNode < 0) return false;
+    out->x = page->skyline[bestNode].x;
+    out->y = bestY;
+    NDL_SkylinePlace_G(page, bestNode, out->x, bestY + h, w);
+    return true;
+}
+
+bool NDL_AtlasAddSurface(NDL_Atlas* atlas, NDL_Surface* surface, NDL_AtlasRegion* region)
+{
+    int w = surface->w + atlas->padding;
+    int h = surface->h + atlas->padding;
+    if (w > atlas->pageWidth || h > atlas->pageHeight)
+    {
+        printf("Image (%dx%d) is larger than an atlas page!\n", surface->w, surface->h);
+        return false;
+    }
+
+    NDL_AtlasPage* page = NULL;
+    SDL_Point at;
+    for (int p = 0; p < atlas->pageCount && page == NULL; ++p)
+    {
+        if (NDL_AtlasPack_G(atlas, &atlas->pages[p], w, h, &at)) page = &atlas->pages[p];
+    }
+    if (page == NULL)
+    {
+        page = NDL_AddAtlasPage_G(atlas);
+        if (page == NULL || !NDL_AtlasPack_G(atlas, page, w, h, &at)) return false;
+    }
+
+    NDL_Surface* rgba = surface;
+    if (surface->format->format != SDL_PIXELFORMAT_RGBA32)
+    {
+        rgba = SDL_ConvertSurfaceFormat(surface, SDL_PIXELFORMAT_RGBA32, 0);
+        if (rgba == NULL)
+        {
+            printf("Error converting surface: %s\n", SDL_GetError());
+            return false;
+        }
+    }
+    region->texture = page->texture;
+    region->src = (Rect){at.x, at.y, surface->w, surface->h};
+    region->uv = (SDL_FRect){(float)at.x/atlas->pageWidth, (float)at.y/atlas->pageHeight, (float)surface->w/atlas->pageWidth, (float)surface->h/atlas->pageHeight};
+    SDL_LockSurface(rgba);
+    SDL_UpdateTexture(page->texture, &region->src, rgba->pixels, rgba->pitch);
+    SDL_UnlockSurface(rgba);
+    if (rgba != surface) SDL_FreeSurface(rgba);
+    return true;
+}
+
+bool NDL_AtlasAddImage(NDL_Atlas* atlas, const char* fp, NDL_AtlasRegion* region)
+{
+    NDL_Surface* surface = IMG_Load(fp);
+    if (surface == NULL)
+    {
+        printf("Error loading %s: %s\n", fp, IMG_GetError());
+        return false;
+    }
+    bool packed = NDL_AtlasAddSurface(atlas, surface, region);
+    SDL_FreeSurface(surface);
+    return packed;
+}
+
+// Value of key=... on a BMFont line, or fallback when the line has no such key
+static int NDL_FontValue_G(const char* line, const char* key, int fallback)
+{
+    size_t n = strlen(key);
+    for (const char* p = strstr(line, key); p != NULL; p = strstr(p + 1, key))
+    {
+        if ((p == line || p[-1] == ' ' || p[-1] == '\t') && p[n] == '=') return atoi(p + n + 1);
+    }
+    return fallback;
+}
+
+static bool NDL_LoadFontPage_G(const char* fp, const char* line, NDL_Surface** pages)
+{
+    int id = NDL_FontValue_G(line, "id", -1);
+    const char* file = strstr(line, "file=\"");
+    if (id < 0 || id >= NDL_FONT_MAX_PAGES || file == NULL) return false;
+    file += 6;
+    const char* slash = SDL_max(strrchr(fp, '/'), strrchr(fp, '\\'));
+    int dirLength = slash != NULL ? (int)(slash - fp) + 1 : 0;
+    int fileLength = (int)strcspn(file, "\"\r\n");
+    char path[MAX_PATH];
+    if (dirLength + fileLength >= MAX_PATH) return false;
+    memcpy(path, fp, dirLength);
+    memcpy(path + dirLength, file, fileLength);
+    path[dirLength + fileLength] = '\0';
+
+    NDL_Surface* loaded = IMG_Load(path);
+    if (loaded == NULL)
+    {
+        printf("Error loading font page %s: %s\n", path, IMG_GetError());
+        return false;
+    }
+    pages[id] = SDL_ConvertSurfaceFormat(loaded, SDL_PIXELFORMAT_RGBA32, 0);
+    SDL_FreeSurface(loaded);
+    if (pages[id] == NULL) return false;
+    SDL_SetSurfaceBlendMode(pages[id], SDL_BLENDMODE_NONE);
+    return true;
+}
+
+static bool NDL_LoadFontGlyph_G(NDL_Font* font, NDL_Atlas* atlas, const char* line, NDL_Surface** pages)
+{
+    int id = NDL_FontValue_G(line, "id", -1);
+    int page = NDL_FontValue_G(line, "page", 0);
+    if (id < 0 || id >= NDL_FONT_GLYPHS || page < 0 || page >= NDL_FONT_MAX_PAGES) return true;
+    NDL_Glyph* glyph = &font->glyphs[id];
+    SDL_Rect src = {NDL_FontValue_G(line, "x", 0), NDL_FontValue_G(line, "y", 0), NDL_FontValue_G(line, "width", 0), NDL_FontValue_G(line, "height", 0)};
+    glyph->w = (float)src.w;
+    glyph->h = (float)src.h;
+    glyph->xOffset = (float)NDL_FontValue_G(line, "xoffset", 0);
+    glyph->yOffset = (float)NDL_FontValue_G(line, "yoffset", 0);
+    glyph->xAdvance = (float)NDL_FontValue_G(line, "xadvance", 0);
+    glyph->region.texture = NULL;
+    glyph->defined = true;
+    if (src.w <= 0 || src.h <= 0) return true;
+    if (pages[page] == NULL) return false;
+
+    // Glyphs are packed one by one so several fonts and sprites can share atlas pages
+    NDL_Surface* pixels = SDL_CreateRGBSurfaceWithFormat(0, src.w, src.h, 32, SDL_PIXELFORMAT_RGBA32);
+    if (pixels == NULL) return false;
+    SDL_BlitSurface(pages[page], &src, pixels, NULL);
+    bool packed = NDL_AtlasAddSurface(atlas, pixels, &glyph->region);
+    SDL_FreeSurface(pixels);
+    return packed;
+}
+
+static int NDL_CompareKernings_G(const void* a, const void* b)
+{
+    return (int)((const NDL_Kerning*)a)->pair - (int)((const NDL_Kerning*)b)->pair;
+}
+
+NDL_Font* NDL_LoadFont(NDL_Atlas* atlas, const char* fp)
+{
+    FILE* file = fopen(fp, "r");
+    if (file == NULL)
+    {
+        printf("Error opening font %s\n", fp);
+        return NULL;
+    }
+    NDL_Font* font = calloc(1, sizeof(NDL_Font));
+    NDL_Surface* pages[NDL_FONT_MAX_PAGES] = {0};
+    int kerningCapacity = 0;
+    bool ok = true;
+    char line[1024];
+    while (ok && fgets(line, sizeof(line), file) != NULL)
+    {
+        if (strncmp(line, "common ", 7) == 0)
+        {
+            font->lineHeight = (float)NDL_FontValue_G(line, "lineHeight", 0);
+            font->base = (float)NDL_FontValue_G(line, "base", 0);
+        } else if (strncmp(line, "page ", 5) == 0) {
+            ok = NDL_LoadFontPage_G(fp, line, pages);
+        } else if (strncmp(line, "char ", 5) == 0) {
+            ok = NDL_LoadFontGlyph_G(font, atlas, line, pages);
+        } else if (strncmp(line, "kerning ", 8) == 0) {
+            int first = NDL_FontValue_G(line, "first", -1), second = NDL_FontValue_G(line, "second", -1);
+            if (first < 0 || first >= NDL_FONT_GLYPHS || second < 0 || second >= NDL_FONT_GLYPHS) continue;
+            if (font->kerningCount == kerningCapacity)
+            {
+                kerningCapacity = kerningCapacity > 0 ? kerningCapacity*2 : 64;
+                font->kernings = realloc(font->kernings, sizeof(NDL_Kerning)*kerningCapacity);
+            }
+            font->kernings[font->kerningCount++] = (NDL_Kerning){(Uint16)(first << 8 | second), (Sint16)NDL_FontValue_G(line, "amount", 0)};
+        }
+    }
+    fclose(file);
+    for (int i = 0; i < NDL_FONT_MAX_PAGES; ++i)
+    {
+        if (pages[i] != NULL) SDL_FreeSurface(pages[i]);
+    }
+    if (!ok)
+    {
+        printf("Error loading font %s\n", fp);
+        NDL_DestroyFont(font);
+        return NULL;
+    }
+    qsort(font->kernings, font->kerningCount, sizeof(NDL_Kerning), NDL_CompareKernings_G);
+    return font;
+}
+
+void NDL_DestroyFont(NDL_Font* font)
+{
+    for (int i = 0; i < NDL_TEXT_CACHE_SETS*NDL_TEXT_CACHE_WAYS; ++i)
+    {
+        free(font->cache[i].text);
+        free(font->cache[i].glyphs);
+    }
+    free(font->kernings);
+    free(font);
+}
+
+static float NDL_FontKerning_G(const NDL_Font* font, int first, int second)
+{
+    Uint16 pair = (Uint16)(first << 8 | second);
+    int lo = 0, hi = font->kerningCount - 1;
+    while (lo <= hi)
+    {
+        int mid = (lo + hi)/2;
+        if (font->kernings[mid].pair == pair) return font->kernings[mid].amount;
+        if (font->kernings[mid].pair < pair) lo = mid + 1;
+        else hi = mid - 1;
+    }
+    return 0.0f;
+}
+
+static void NDL_BuildTextLayout_G(NDL_Font* font, NDL_TextLayout* layout, const char* text, int length)
+{
+    if (layout->glyphCapacity < length)
+    {
+        layout->glyphCapacity = length;
+        layout->glyphs = realloc(layout->glyphs, sizeof(NDL_LayoutGlyph)*layout->glyphCapacity);
+    }
+    layout->glyphCount = 0;
+    float x = 0.0f, y = 0.0f, width = 0.0f;
+    int previous = -1;
+    for (int i = 0; i < length; ++i)
+    {
+        int c = (unsigned char)text[i];
+        if (c == '\n')
+        {
+            width = SDL_max(width, x);
+            x = 0.0f;
+            y += font->lineHeight;
+            previous = -1;
+            continue;
+        }
+        if (!font->glyphs[c].defined)
+        {
+            c = '?';
+            if (!font->glyphs[c].defined) continue;
+        }
+        const NDL_Glyph* glyph = &font->glyphs[c];
+        if (previous >= 0 && font->kerningCount > 0) x += NDL_FontKerning_G(font, previous, c);
+        if (glyph->region.texture != NULL) layout->glyphs[layout->glyphCount++] = (NDL_LayoutGlyph){glyph, x + glyph->xOffset, y + glyph->yOffset};
+        x += glyph->xAdvance;
+        previous = c;
+    }
+    layout->size = (Vector2F){SDL_max(width, x), y + font->lineHeight};
+}
+
+const NDL_TextLayout* NDL_LayoutText(NDL_Font* font, const char* text)
+{
+    // FNV-1a, measuring the string on the way
+    Uint32 hash = 2166136261u;
+    int length = 0;
+    for (; text[length] != '\0'; ++length) hash = (hash ^ (unsigned char)text[length])*16777619u;
+
+    NDL_TextLayout* set = &font->cache[(hash & (NDL_TEXT_CACHE_SETS - 1))*NDL_TEXT_CACHE_WAYS];
+    NDL_TextLayout* victim = &set[0];
+    ++font->useCounter;
+    for (int w = 0; w < NDL_TEXT_CACHE_WAYS; ++w)
+    {
+        NDL_TextLayout* layout = &set[w];
+        if (layout->text != NULL && layout->hash == hash && layout->length == length && memcmp(layout->text, text, length) == 0)
+        {
+            layout->lastUsed = font->useCounter;
+            ++font->layoutHits;
+            return layout;
+        }
+        if (layout->lastUsed < victim->lastUsed) victim = layout;
+    }
+
+    // Replace the least recently used way, reusing its buffers
+    ++font->layoutMisses;
+    if (victim->textCapacity < length + 1)
+    {
+        victim->textCapacity = length + 1;
+        victim->text = realloc(victim->text, victim->textCapacity);
+    }
+    memcpy(victim->text, text, length + 1);
+    victim->hash = hash;
+    victim->length = length;
+    victim->lastUsed = font->useCounter;
+    NDL_BuildTextLayout_G(font, victim, text, length);
+    return victim;
+}
+
+Vector2F NDL_MeasureText(NDL_Font* font, const char* text)
+{
+    return NDL_LayoutText(font, text)->size;
+}
+
+void NDL_DrawText(NDL_SpriteBatch* batch, NDL_Font* font, const char* text, float x, float y, NDL_Color color)
+{
+    const NDL_TextLayout* layout = NDL_LayoutText(font, text);
+    // Whole-pixel origins keep glyph texels aligned with screen pixels
+    x = floorf(x);
+    y = floorf(y);
+    for (int i = 0; i < layout->glyphCount; ++i)
+    {
+        const NDL_LayoutGlyph* g = &layout->glyphs[i];
+        SDL_FRect dst = {x + g->x, y + g->y, g->glyph->w, g->glyph->h};
+        NDL_BatchSprite(batch, g->glyph->region.texture, &g->glyph->region.uv, &dst, color);
+    }
+}
+
+NDL_GuiContext* NDL_CreateGuiContext(Renderer ren, NDL_Atlas* atlas, NDL_Font* font)
+{
+    // 4x4 so bilinear filtering at the sampled centre never reaches a neighbour
+    NDL_Surface* white = SDL_CreateRGBSurfaceWithFormat(0, 4, 4, 32, SDL_PIXELFORMAT_RGBA32);
+    if (white == NULL) return NULL;
+    SDL_FillRect(white, NULL, 0xFFFFFFFF);
+    NDL_AtlasRegion region;
+    bool packed = NDL_AtlasAddSurface(atlas, white, &region);
+    SDL_FreeSurface(white);
+    if (!packed) return NULL;
+
+    NDL_GuiContext* ctx = calloc(1, sizeof(NDL_GuiContext));
+    ctx->sdlRenderer = ren;
+    ctx->font = font;
+    ctx->whiteTexture = region.texture;
+    ctx->whiteUV = (SDL_FRect){region.uv.x + region.uv.w*0.5f, region.uv.y + region.uv.h*0.5f, 0.0f, 0.0f};
+    ctx->panelColor = (NDL_Color){30, 30, 36, 230};
+    ctx->titleColor = (NDL_Color){50, 50, 70, 255};
+    ctx->widgetColor = (NDL_Color){60, 60, 72, 255};
+    ctx->hotColor = (NDL_Color){80, 80, 100, 255};
+    ctx->activeColor = (NDL_Color){100, 110, 150, 255};
+    ctx->textColor = (NDL_Color){230, 230, 235, 255};
+    ctx->padding = 6.0f;
+    ctx->spacing = 4.0f;
+    ctx->rowHeight = font != NULL ? font->lineHeight + 6.0f : 20.0f;
+    ctx->quadCapacity = 1024;
+    ctx->vertices = malloc(sizeof(SDL_Vertex)*4*ctx->quadCapacity);
+    ctx->indices = malloc(sizeof(int)*6*ctx->quadCapacity);
+    for (int q = 0; q < ctx->quadCapacity; ++q)
+    {
+        int* i = ctx->indices + q*6;
+        i[0] = q*4; i[1] = q*4 + 1; i[2] = q*4 + 2;
+        i[3] = q*4 + 2; i[4] = q*4 + 3; i[5] = q*4;
+    }
+    ctx->commandCapacity = 64;
+    ctx->commands = malloc(sizeof(NDL_GuiCommand)*ctx->commandCapacity);
+    ctx->textCapacity = 256;
+    ctx->texts = calloc(ctx->textCapacity, sizeof(NDL_GuiText));
+    return ctx;
+}
+
+void NDL_DestroyGuiContext(NDL_GuiContext* ctx)
+{
+    if (ctx->focused != 0) SDL_StopTextInput();
+    free(ctx->vertices);
+    free(ctx->indices);
+    free(ctx->commands);
+    for (int i = 0; i < ctx->textCapacity; ++i)
+    {
+        free(ctx->texts[i].layout.text);
+        free(ctx->texts[i].layout.glyphs);
+    }
+    free(ctx->texts);
+    free(ctx);
+}
+
+void NDL_GuiHandleEvent(NDL_GuiContext* ctx, const Event* event)
+{
+    switch (event->type)
+    {
+        case SDL_TEXTINPUT:
+            for (const char* c = event->text.text; *c != '\0' && ctx->textLength < NDL_GUI_TEXT_INPUT - 1; ++c) ctx->textInput[ctx->textLength++] = *c;
+            break;
+        case SDL_KEYDOWN:
+            if (event->key.keysym.scancode == SDL_SCANCODE_BACKSPACE) ++ctx->backspaces;
+            if (event->key.keysym.scancode == SDL_SCANCODE_RETURN || event->key.keysym.scancode == SDL_SCANCODE_KP_ENTER) ctx->enterPressed = true;
+            break;
+        case SDL_MOUSEWHEEL:
+            ctx->wheel += (float)event->wheel.y;
+            break;
+    }
+}
+
+static inline bool NDL_GuiContains_G(SDL_FRect r, Vector2F p)
+{
+    return p.x >= r.x && p.x < r.x + r.w && p.y >= r.y && p.y < r.y + r.h;
+}
+
+// FNV-1a of the label, seeded by the current panel so equal labels in different panels differ
+static Uint32 NDL_GuiId_G(NDL_GuiContext* ctx, const char* label)
+{
+    Uint32 hash = ctx->current != NULL ? ctx->current->id : 2166136261u;
+    for (const char* c = label; *c != '\0'; ++c) hash = (hash ^ (unsigned char)*c)*16777619u;
+    return hash != 0 ? hash : 1;
+}
+
+void NDL_GuiBeginFrame(NDL_GuiContext* ctx)
+{
+    int x, y;
+    Uint32 buttons = SDL_GetMouseState(&x, &y);
+    bool down = (buttons & SDL_BUTTON_LMASK) != 0;
+    ctx->mouse = (Vector2F){(float)x, (float)y};
+    ctx->mousePressed = down && !ctx->mouseDown;
+    ctx->mouseReleased = !down && ctx->mouseDown;
+    ctx->mouseDown = down;
+    ctx->hot = 0;
+    ++ctx->frame;
+    ctx->quadCount = 0;
+    ctx->commandCount = 0;
+    ctx->current = NULL;
+
+    // Last frame's rects decide which panel owns the mouse, so overlapped panels ignore it
+    NDL_GuiPanel* top = NULL;
+    for (int i = 0; i < ctx->panelCount; ++i)
+    {
+        NDL_GuiPanel* panel = &ctx->panels[i];
+        if (panel->lastFrame + 1 != ctx->frame || !NDL_GuiContains_G(panel->rect, ctx->mouse)) continue;
+        if (top == NULL || panel->order > top->order) top = panel;
+    }
+    ctx->hoveredPanel = top != NULL ? top->id : 0;
+    if (ctx->mousePressed)
+    {
+        if (top != NULL) top->order = ++ctx->topOrder;
+        if (ctx->focused != 0)
+        {
+            ctx->focused = 0;
+            SDL_StopTextInput();
+        }
+    }
+}
+
+static void NDL_GuiQuad_G(NDL_GuiContext* ctx, NDL_Texture* texture, const SDL_FRect* uv, SDL_FRect dst, NDL_Color color)
+{
+    // Quads wholly outside the panel are never recorded
+    SDL_FRect clip = ctx->current->rect;
+    if (dst.x >= clip.x + clip.w || dst.y >= clip.y + clip.h || dst.x + dst.w <= clip.x || dst.y + dst.h <= clip.y) return;
+    NDL_GuiCommand* command = ctx->commandCount > ctx->current->firstCommand ? &ctx->commands[ctx->commandCount - 1] : NULL;
+    if (command == NULL || command->texture != texture)
+    {
+        if (ctx->commandCount == ctx->commandCapacity)
+        {
+            ctx->commandCapacity *= 2;
+            ctx->commands = realloc(ctx->commands, sizeof(NDL_GuiCommand)*ctx->commandCapacity);
+        }
+        command = &ctx->commands[ctx->commandCount++];
+        *command = (NDL_GuiCommand){texture, ctx->quadCount, 0};
+    }
+    if (ctx->quadCount == ctx->quadCapacity)
+    {
+        int old = ctx->quadCapacity;
+        ctx->quadCapacity *= 2;
+        ctx->vertices = realloc(ctx->vertices, sizeof(SDL_Vertex)*4*ctx->quadCapacity);
+        ctx->indices = realloc(ctx->indices, sizeof(int)*6*ctx->quadCapacity);
+        for (int q = old; q < ctx->quadCapacity; ++q)
+        {
+            int* i = ctx->indices + q*6;
+            i[0] = q*4; i[1] = q*4 + 1; i[2] = q*4 + 2;
+            i[3] = q*4 + 2; i[4] = q*4 + 3; i[5] = q*4;
+        }
+    }
+    NDL_WriteQuad_G(ctx->vertices + ctx->quadCount*4, uv, &dst, color);
+    ++ctx->quadCount;
+    ++command->quadCount;
+}
+
+static void NDL_GuiFill_G(NDL_GuiContext* ctx, SDL_FRect r, NDL_Color color)
+{
+    NDL_GuiQuad_G(ctx, ctx->whiteTexture, &ctx->whiteUV, r, color);
+}
+
+static NDL_GuiText* NDL_GuiFindText_G(NDL_GuiText* texts, int capacity, Uint32 key)
+{
+    int i = (int)(key & (Uint32)(capacity - 1));
+    while (texts[i].key != 0 && texts[i].key != key) i = (i + 1) & (capacity - 1);
+    return &texts[i];
+}
+
+// Rehashes the text table, dropping layouts not drawn for a second and doubling when still half full
+static void NDL_GuiRehashTexts_G(NDL_GuiContext* ctx)
+{
+    int live = 0;
+    for (int i = 0; i < ctx->textCapacity; ++i)
+    {
+        if (ctx->texts[i].key != 0 && ctx->frame - ctx->texts[i].lastFrame <= 60) ++live;
+    }
+    int capacity = ctx->textCapacity;
+    while (live*4 >= capacity) capacity *= 2;
+    NDL_GuiText* texts = calloc(capacity, sizeof(NDL_GuiText));
+    for (int i = 0; i < ctx->textCapacity; ++i)
+    {
+        NDL_GuiText* text = &ctx->texts[i];
+        if (text->key == 0) continue;
+        if (ctx->frame - text->lastFrame <= 60)
+        {
+            *NDL_GuiFindText_G(texts, capacity, text->key) = *text;
+            continue;
+        }
+        free(text->layout.text);
+        free(text->layout.glyphs);
+    }
+    free(ctx->texts);
+    ctx->texts = texts;
+    ctx->textCapacity = capacity;
+    ctx->textCount = live;
+}
+
+// The layout of text for the widget key, redone only when the widget's text changed
+static const NDL_TextLayout* NDL_GuiLayout_G(NDL_GuiContext* ctx, Uint32 key, const char* text, int length)
+{
+    NDL_GuiText* entry = NDL_GuiFindText_G(ctx->texts, ctx->textCapacity, key);
+    if (entry->key == 0)
+    {
+        if ((ctx->textCount + 1)*2 > ctx->textCapacity)
+        {
+            NDL_GuiRehashTexts_G(ctx);
+            entry = NDL_GuiFindText_G(ctx->texts, ctx->textCapacity, key);
+        }
+        entry->key = key;
+        ++ctx->textCount;
+    } else if (entry->layout.text != NULL && entry->layout.length == length && memcmp(entry->layout.text, text, length) == 0) {
+        entry->lastFrame = ctx->frame;
+        return &entry->layout;
+    }
+    NDL_TextLayout* layout = &entry->layout;
+    if (layout->textCapacity < length + 1)
+    {
+        layout->textCapacity = length + 1;
+        layout->text = realloc(layout->text, layout->textCapacity);
+    }
+    memcpy(layout->text, text, length);
+    layout->text[length] = '\0';
+    layout->length = length;
+    entry->lastFrame = ctx->frame;
+    NDL_BuildTextLayout_G(ctx->font, layout, text, length);
+    return layout;
+}
+
+// Draws text up to any "##" suffix, which only feeds the widget id; returns the drawn width
+static float NDL_GuiText_G(NDL_GuiContext* ctx, Uint32 key, const char* text, float x, float y, bool centre, float width)
+{
+    if (ctx->font == NULL) return 0.0f;
+    const char* hidden = strstr(text, "##");
+    int length = hidden != NULL ? (int)(hidden - text) : (int)strlen(text);
+    const NDL_TextLayout* layout = NDL_GuiLayout_G(ctx, key, text, length);
+    if (centre) x += (width - layout->size.x)*0.5f;
+    x = floorf(x);
+    y = floorf(y + (ctx->rowHeight - ctx->font->lineHeight)*0.5f);
+    for (int i = 0; i < layout->glyphCount; ++i)
+    {
+        const NDL_LayoutGlyph* g = &layout->glyphs[i];
+        NDL_GuiQuad_G(ctx, g->glyph->region.texture, &g->glyph->region.uv, (SDL_FRect){x + g->x, y + g->y, g->glyph->w, g->glyph->h}, ctx->textColor);
+    }
+    return layout->size.x;
+}
+
+// Claims the next row; returns false when it is scrolled out of view and needs no work
+static bool NDL_GuiRow_G(NDL_GuiContext* ctx, SDL_FRect* row)
+{
+    *row = (SDL_FRect){ctx->content.x + ctx->padding, ctx->cursorY, ctx->content.w - 2.0f*ctx->padding, ctx->rowHeight};
+    ctx->cursorY += ctx->rowHeight + ctx->spacing;
+    ++ctx->row;
+    return row->y + row->h > ctx->content.y && row->y < ctx->content.y + ctx->content.h;
+}
+
+// Hot/active tracking shared by the widgets; returns true when a press is released over it
+static bool NDL_GuiInteract_G(NDL_GuiContext* ctx, Uint32 id, SDL_FRect r)
+{
+    bool over = ctx->current->id == ctx->hoveredPanel && NDL_GuiContains_G(r, ctx->mouse) && NDL_GuiContains_G(ctx->content, ctx->mouse);
+    if (over) ctx->hot = id;
+    if (over && ctx->mousePressed) ctx->active = id;
+    return ctx->active == id && ctx->mouseReleased && over;
+}
+
+static NDL_Color NDL_GuiWidgetColor_G(NDL_GuiContext* ctx, Uint32 id)
+{
+    if (ctx->active == id) return ctx->activeColor;
+    return ctx->hot == id ? ctx->hotColor : ctx->widgetColor;
+}
+
+static NDL_GuiPanel* NDL_GuiFindPanel_G(NDL_GuiContext* ctx, Uint32 id, SDL_FRect rect)
+{
+    for (int i = 0; i < ctx->panelCount; ++i)
+    {
+        if (ctx->panels[i].id == id) return &ctx->panels[i];
+    }
+    // Full: reuse the panel that has gone unused the longest
+    NDL_GuiPanel* panel = &ctx->panels[0];
+    if (ctx->panelCount < NDL_GUI_MAX_PANELS)
+    {
+        panel = &ctx->panels[ctx->panelCount++];
+    } else {
+        for (int i = 1; i < ctx->panelCount; ++i)
+        {
+            if (ctx->panels[i].lastFrame < panel->lastFrame) panel = &ctx->panels[i];
+        }
+    }
+    *panel = (NDL_GuiPanel){id, rect, 0.0f, 0.0f, ++ctx->topOrder, 0, 0, 0};
+    return panel;
+}
+
+void NDL_GuiBeginPanel(NDL_GuiContext* ctx, const char* title, SDL_FRect rect)
+{
+    ctx->current = NULL;
+    Uint32 id = NDL_GuiId_G(ctx, title);
+    NDL_GuiPanel* panel = NDL_GuiFindPanel_G(ctx, id, rect);
+    ctx->current = panel;
+    ctx->title = title;
+    panel->lastFrame = ctx->frame;
+    panel->firstCommand = ctx->commandCount;
+
+    // Dragging the title bar moves the panel; the wheel scrolls it
+    SDL_FRect titleBar = {panel->rect.x, panel->rect.y, panel->rect.w, ctx->rowHeight};
+    Uint32 titleId = id ^ 0x9E3779B9u;
+    ctx->content = panel->rect;
+    if (panel->id == ctx->hoveredPanel && NDL_GuiContains_G(titleBar, ctx->mouse))
+    {
+        ctx->hot = titleId;
+        if (ctx->mousePressed)
+        {
+            ctx->active = titleId;
+            ctx->dragOffset = (Vector2F){ctx->mouse.x - panel->rect.x, ctx->mouse.y - panel->rect.y};
+        }
+    }
+    if (ctx->active == titleId)
+    {
+        panel->rect.x = ctx->mouse.x - ctx->dragOffset.x;
+        panel->rect.y = ctx->mouse.y - ctx->dragOffset.y;
+    }
+    if (panel->id == ctx->hoveredPanel && ctx->wheel != 0.0f)
+    {
+        panel->scroll -= ctx->wheel*ctx->rowHeight;
+        ctx->wheel = 0.0f;
+    }
+    float viewHeight = panel->rect.h - ctx->rowHeight;
+    panel->scroll = SDL_max(0.0f, SDL_min(panel->scroll, panel->contentHeight - viewHeight));
+
+    NDL_GuiFill_G(ctx, panel->rect, ctx->panelColor);
+    ctx->content = (SDL_FRect){panel->rect.x, panel->rect.y + ctx->rowHeight, panel->rect.w, viewHeight};
+    ctx->cursorY = ctx->content.y + ctx->padding - panel->scroll;
+    ctx->row = 0;
+}
+
+void NDL_GuiEndPanel(NDL_GuiContext* ctx)
+{
+    NDL_GuiPanel* panel = ctx->current;
+    if (panel == NULL) return;
+    panel->contentHeight = ctx->cursorY + panel->scroll + ctx->padding - ctx->content.y;
+    // Drawn last so scrolled rows slide under it
+    SDL_FRect titleBar = {panel->rect.x, panel->rect.y, panel->rect.w, ctx->rowHeight};
+    NDL_GuiFill_G(ctx, titleBar, ctx->titleColor);
+    NDL_GuiText_G(ctx, panel->id, ctx->title, titleBar.x + ctx->padding, titleBar.y, false, titleBar.w);
+    panel->commandCount = ctx->commandCount - panel->firstCommand;
+    ctx->current = NULL;
+}
+
+void NDL_GuiLabel(NDL_GuiContext* ctx, const char* text)
+{
+    SDL_FRect row;
+    if (!NDL_GuiRow_G(ctx, &row)) return;
+    // Labels have no id; their row keeps the layout when the text changes every frame
+    Uint32 key = ctx->current->id ^ ((Uint32)ctx->row*0x85EBCA6Bu);
+    NDL_GuiText_G(ctx, key != 0 ? key : 1, text, row.x, row.y, false, row.w);
+}
+
+bool NDL_GuiButton(NDL_GuiContext* ctx, const char* label)
+{
+    SDL_FRect row;
+    if (!NDL_GuiRow_G(ctx, &row)) return false;
+    Uint32 id = NDL_GuiId_G(ctx, label);
+    bool clicked = NDL_GuiInteract_G(ctx, id, row);
+    NDL_GuiFill_G(ctx, row, NDL_GuiWidgetColor_G(ctx, id));
+    NDL_GuiText_G(ctx, id, label, row.x, row.y, true, row.w);
+    return clicked;
+}
+
+bool NDL_GuiSlider(NDL_GuiContext* ctx, const char* label, float* value, float min, float max)
+{
+    SDL_FRect row;
+    if (!NDL_GuiRow_G(ctx, &row)) return false;
+    Uint32 id = NDL_GuiId_G(ctx, label);
+    NDL_GuiInteract_G(ctx, id, row);
+    bool changed = false;
+    if (ctx->active == id && ctx->mouseDown && max > min)
+    {
+        float t = SDL_max(0.0f, SDL_min(1.0f, (ctx->mouse.x - row.x)/row.w));
+        float v = min + t*(max - min);
+        changed = v != *value;
+        *value = v;
+    }
+    float t = max > min ? SDL_max(0.0f, SDL_min(1.0f, (*value - min)/(max - min))) : 0.0f;
+    NDL_GuiFill_G(ctx, row, ctx->widgetColor);
+    NDL_GuiFill_G(ctx, (SDL_FRect){row.x, row.y, row.w*t, row.h}, ctx->active == id ? ctx->activeColor : ctx->hotColor);
+
+    // "label: value", formatted without allocating
+    char text[128];
+    const char* hidden = strstr(label, "##");
+    int length = SDL_min(hidden != NULL ? (int)(hidden - label) : (int)strlen(label), 96);
+    memcpy(text, label, length);
+    text[length++] = ':';
+    text[length++] = ' ';
+    NDL_FormatFloat(text + length, (int)sizeof(text) - length, *value, 2);
+    NDL_GuiText_G(ctx, id, text, row.x, row.y, true, row.w);
+    return changed;
+}
+
+bool NDL_GuiTextField(NDL_GuiContext* ctx, const char* label, char* buffer, int size)
+{
+    SDL_FRect row;
+    if (!NDL_GuiRow_G(ctx, &row)) return false;
+    Uint32 id = NDL_GuiId_G(ctx, label);
+    if (NDL_GuiInteract_G(ctx, id, row) && ctx->focused != id)
+    {
+        ctx->focused = id;
+        SDL_StartTextInput();
+    }
+    bool submitted = false;
+    int length = (int)strlen(buffer);
+    if (ctx->focused == id)
+    {
+        for (; ctx->backspaces > 0 && length > 0; --ctx->backspaces) buffer[--length] = '\0';
+        for (int i = 0; i < ctx->textLength && length < size - 1; ++i) buffer[length++] = ctx->textInput[i];
+        buffer[length] = '\0';
+        ctx->textLength = 0;
+        ctx->backspaces = 0;
+        if (ctx->enterPressed)
+        {
+            submitted = true;
+            ctx->enterPressed = false;
+            ctx->focused = 0;
+            SDL_StopTextInput();
+        }
+    }
+    NDL_GuiFill_G(ctx, row, ctx->focused == id ? ctx->activeColor : NDL_GuiWidgetColor_G(ctx, id));
+    float textWidth = NDL_GuiText_G(ctx, id, buffer, row.x + ctx->padding, row.y, false, row.w);
+    if (ctx->focused == id && ctx->font != NULL && (ctx->frame/30) % 2 == 0)
+    {
+        float caret = row.x + ctx->padding + textWidth;
+        NDL_GuiFill_G(ctx, (SDL_FRect){caret, row.y + 3.0f, 1.0f, row.h - 6.0f}, ctx->textColor);
+    }
+    return submitted;
+}
+
+void NDL_GuiRender(NDL_GuiContext* ctx)
+{
+    Renderer ren = ctx->sdlRenderer;
+    ctx->drawCalls = 0;
+    NDL_GuiPanel* order[NDL_GUI_MAX_PANELS];
+    int count = 0;
+    for (int i = 0; i < ctx->panelCount; ++i)
+    {
+        NDL_GuiPanel* panel = &ctx->panels[i];
+        if (panel->lastFrame != ctx->frame) continue;
+        // Insertion sort by stacking order; there are only a handful of panels
+        int j = count++;
+        for (; j > 0 && order[j - 1]->order > panel->order; --j) order[j] = order[j - 1];
+        order[j] = panel;
+    }
+    // Panels clip to their rect within the caller's clip, which is put back afterwards
+    bool clipped = SDL_RenderIsClipEnabled(ren);
+    SDL_Rect previousClip = {0, 0, 0, 0};
+    if (clipped) SDL_RenderGetClipRect(ren, &previousClip);
+    for (int p = 0; p < count; ++p)
+    {
+        NDL_GuiPanel* panel = order[p];
+        SDL_Rect clip = {(int)floorf(panel->rect.x), (int)floorf(panel->rect.y), (int)ceilf(panel->rect.w), (int)ceilf(panel->rect.h)};
+        if (clipped && !SDL_IntersectRect(&clip, &previousClip, &clip)) continue;
+        SDL_RenderSetClipRect(ren, &clip);
+        for (int c = panel->firstCommand; c < panel->firstCommand + panel->commandCount; ++c)
+        {
+            NDL_GuiCommand* command = &ctx->commands[c];
+            SDL_RenderGeometry(ren, command->texture, ctx->vertices + command->firstQuad*4, command->quadCount*4, ctx->indices, command->quadCount*6);
+            NDL_CountDraw_G(ren, command->texture, command->quadCount*4);
+            ++ctx->drawCalls;
+        }
+    }
+    SDL_RenderSetClipRect(ren, clipped ? &previousClip : NULL);
+
+    // Input not consumed this frame is dropped
+    if (!ctx->mouseDown) ctx->active = 0;
+    ctx->textLength = 0;
+    ctx->backspaces = 0;
+    ctx->enterPressed = false;
+    ctx->wheel = 0.0f;
+}
+
+#define NDL_ANIM_CHANGED (1 << 3)
+
+// Advances one timeline; returns NDL_ANIM_CHANGED plus a bit per NDL_ANIMATION_EVENTS raised
+static int NDL_StepAnimation_G(float* time, int* frame, int* direction, bool* finished, float deltaTime, float frameDuration, int frameCount, int mode)
+{
+    if (*finished || frameCount <= 1 || frameDuration <= 0.0f) return 0;
+    *time += deltaTime;
+    int events = 0;
+    while (*time >= frameDuration)
+    {
+        *time -= frameDuration;
+        int next = *frame + *direction;
+        if (next >= frameCount || next < 0)
+        {
+            if (mode == ANIMATION_ONCE)
+            {
+                *finished = true;
+                *time = 0.0f;
+                events |= 1 << ANIMATION_EVENT_FINISHED;
+                break;
+            } else if (mode == ANIMATION_PINGPONG) {
+                *direction = -*direction;
+                next = *frame + *direction;
+            } else {
+                next = 0;
+            }
+            events |= 1 << ANIMATION_EVENT_LOOP;
+        }
+        *frame = next;
+        events |= NDL_ANIM_CHANGED;
+    }
+    return events;
+}
+
+NDL_Texture* NDL_AnimationFlip(NDL_AnimationComponent* anim, float deltaTime)
+{
+    // Each component keeps its own timer; frames are kept in step with the time that passed
+    NDL_StepAnimation_G(&anim->time, &anim->currentFrame, &anim->direction, &anim->finished, deltaTime,
+                        1.0f / anim->rate, anim->imageSet->imageCount, anim->mode);
+    return anim->imageSet->images[anim->currentFrame];
+}
+
+NDL_AnimationClock* NDL_CreateAnimationClock(NDL_ImageSet* imageSet, float framesPerSecond, NDL_ANIMATION_MODES mode)
+{
+    NDL_AnimationClock* clock = malloc(sizeof(NDL_AnimationClock));
+    clock->rate = framesPerSecond;
+    clock->time = 0.0f;
+    clock->frame = 0;
+    clock->frameCount = imageSet != NULL ? imageSet->imageCount : 0;
+    clock->mode = mode;
+    clock->direction = 1;
+    clock->finished = false;
+    clock->pass = 0;
+    clock->events = 0;
+    return clock;
+}
+
+NDL_AnimationSystem* NDL_CreateAnimationSystem(int capacity)
+{
+    NDL_AnimationSystem* system = malloc(sizeof(NDL_AnimationSystem));
+    system->count = 0;
+    system->capacity = capacity > 0 ? capacity : 64;
+    system->entities = malloc(sizeof(NDL_Entity*)*system->capacity);
+    system->components = malloc(sizeof(NDL_AnimationComponent*)*system->capacity);
+    system->time = malloc(sizeof(float)*system->capacity);
+    system->frameDuration = malloc(sizeof(float)*system->capacity);
+    system->frame = malloc(sizeof(int)*system->capacity);
+    system->frameCount = malloc(sizeof(int)*system->capacity);
+    system->mode = malloc(sizeof(Uint8)*system->capacity);
+    system->direction = malloc(sizeof(Sint8)*system->capacity);
+    system->clocks = malloc(sizeof(NDL_AnimationClock*)*system->capacity);
+    system->pass = 0;
+    system->advanced = 0;
+    system->skipped = 0;
+    return system;
+}
+
+void NDL_DestroyAnimationSystem(NDL_AnimationSystem* system)
+{
+    for (int i = 0; i < system->count; ++i)
+    {
+        system->components[i]->system = NULL;
+        system->components[i]->slot = -1;
+    }
+    free(system->entities);
+    free(system->components);
+    free(system->time);
+    free(system->frameDuration);
+    free(system->frame);
+    free(system->frameCount);
+    free(system->mode);
+    free(system->direction);
+    free(system->clocks);
+    free(system);
+}
+
+void NDL_AddToAnimationSystem(NDL_AnimationSystem* system, NDL_Entity* e)
+{
+    if (!NDL_HasComponent(e, ANIMATION_COMPONENT))
+    {
+        printf("Entity has no animation component!\n");
+        return;
+    }
+    NDL_AnimationComponent* anim = e->sprite->animation;
+    if (anim->system != NULL) return;
+    if (system->count == system->capacity)
+    {
+        system->capacity *= 2;
+        system->entities = realloc(system->entities, sizeof(NDL_Entity*)*system->capacity);
+        system->components = realloc(system->components, sizeof(NDL_AnimationComponent*)*system->capacity);
+        system->time = realloc(system->time, sizeof(float)*system->capacity);
+        system->frameDuration = realloc(system->frameDuration, sizeof(float)*system->capacity);
+        system->frame = realloc(system->frame, sizeof(int)*system->capacity);
+        system->frameCount = realloc(system->frameCount, sizeof(int)*system->capacity);
+        system->mode = realloc(system->mode, sizeof(Uint8)*system->capacity);
+        system->direction = realloc(system->direction, sizeof(Sint8)*system->capacity);
+        system->clocks = realloc(system->clocks, sizeof(NDL_AnimationClock*)*system->capacity);
+    }
+    int slot = system->count++;
+    system->entities[slot] = e;
+    system->components[slot] = anim;
+    system->time[slot] = anim->time;
+    system->frameDuration[slot] = 1.0f / anim->rate;
+    system->frame[slot] = anim->currentFrame;
+    system->frameCount[slot] = anim->imageSet != NULL ? anim->imageSet->imageCount : 0;
+    system->mode[slot] = (Uint8)anim->mode;
+    system->direction[slot] = (Sint8)anim->direction;
+    system->clocks[slot] = anim->clock;
+    anim->system = system;
+    anim->slot = slot;
+}
+
+void NDL_RemoveFromAnimationSystem(NDL_AnimationSystem* system, NDL_Entity* e)
+{
+    NDL_AnimationComponent* anim = e->sprite->animation;
+    if (anim == NULL || anim->system != system) return;
+    int slot = anim->slot;
+    anim->time = system->time[slot];
+    anim->currentFrame = system->frame[slot];
+    anim->direction = system->direction[slot];
+    anim->system = NULL;
+    anim->slot = -1;
+
+    // Swap-remove; the component that moves into the hole learns its new slot
+    int last = --system->count;
+    if (slot == last) return;
+    system->entities[slot] = system->entities[last];
+    system->components[slot] = system->components[last];
+    system->time[slot] = system->time[last];
+    system->frameDuration[slot] = system->frameDuration[last];
+    system->frame[slot] = system->frame[last];
+    system->frameCount[slot] = system->frameCount[last];
+    system->mode[slot] = system->mode[last];
+    system->direction[slot] = system->direction[last];
+    system->clocks[slot] = system->clocks[last];
+    system->components[slot]->slot = slot;
+}
+
+static void NDL_RaiseAnimationEvents_G(NDL_Entity* e, NDL_AnimationComponent* anim, int events, int frame)
+{
+    if (anim->onEvent == NULL) return;
+    if ((events & (1 << ANIMATION_EVENT_LOOP))) anim->onEvent(e, anim, ANIMATION_EVENT_LOOP, frame);
+    if ((events & NDL_ANIM_CHANGED) && frame < 64 && ((anim->eventFrames >> frame) & 1)) anim->onEvent(e, anim, ANIMATION_EVENT_FRAME, frame);
+    if ((events & (1 << ANIMATION_EVENT_FINISHED))) anim->onEvent(e, anim, ANIMATION_EVENT_FINISHED, frame);
+}
+
+int NDL_UpdateAnimationSystem(NDL_AnimationSystem* system, NDL_RenderSystem* renSys, float deltaTime)
+{
+    ++system->pass;
+    system->advanced = 0;
+    system->skipped = 0;
+    for (int i = 0; i < system->count; ++i)
+    {
+        NDL_Entity* e = system->entities[i];
+        NDL_AnimationComponent* anim = system->components[i];
+        NDL_AnimationClock* clock = system->clocks[i];
+        if (clock != NULL)
+        {
+            if (clock->pass != system->pass)
+            {
+                clock->pass = system->pass;
+                clock->events = NDL_StepAnimation_G(&clock->time, &clock->frame, &clock->direction, &clock->finished,
+                                                    deltaTime, 1.0f / clock->rate, clock->frameCount, clock->mode);
+            }
+            // Components on a clock follow it even while hidden, so they are never out of step
+            if (system->frame[i] != clock->frame)
+            {
+                system->frame[i] = clock->frame;
+                anim->currentFrame = clock->frame;
+                anim->finished = clock->finished;
+                NDL_ApplyAnimationFrame_G(e->sprite, anim);
+            }
+            if (clock->events) NDL_RaiseAnimationEvents_G(e, anim, clock->events, clock->frame);
+            // A finished clock still counts on the pass that raised its last events
+            if (!clock->finished || clock->events) ++system->advanced;
+            continue;
+        }
+
+        if (e->isSleeping || anim->finished || (renSys != NULL && e->sprite->visibleFrame != renSys->frame))
+        {
+            ++system->skipped;
+            continue;
+        }
+        int direction = system->direction[i];
+        int events = NDL_StepAnimation_G(&system->time[i], &system->frame[i], &direction, &anim->finished,
+                                         deltaTime, system->frameDuration[i], system->frameCount[i], system->mode[i]);
+        system->direction[i] = (Sint8)direction;
+        ++system->advanced;
+        if (events == 0) continue;
+        anim->currentFrame = system->frame[i];
+        NDL_ApplyAnimationFrame_G(e->sprite, anim);
+        NDL_RaiseAnimationEvents_G(e, anim, events, system->frame[i]);
+    }
+    if (system->advanced > 0 && renSys != NULL && renSys->scheduler != NULL) NDL_RequestAnimation(renSys->scheduler, 0);
+    return system->advanced;
+}
+
+NDL_AnimationComponent* NDL_CreateAnimation(bool loop, int flipRate)
+{
+    NDL_AnimationComponent* anim = malloc(sizeof(NDL_AnimationComponent));
+    anim->loop = loop;
+    anim->imageSet = NULL;
+    anim->currentFrame = 0;
+    anim->flipRate = flipRate;
+    anim->flip = NDL_AnimationFlip;
+    anim->time = 0.0f;
+    anim->rate = (float)flipRate;
+    anim->mode = loop ? ANIMATION_LOOP : ANIMATION_ONCE;
+    anim->direction = 1;
+    anim->finished = false;
+    anim->eventFrames = 0;
+    anim->onEvent = NULL;
+    anim->clock = NULL;
+    anim->system = NULL;
+    anim->slot = -1;
+    return anim;
+}
+
+void NDL_RenderParticleEmitter(NDL_RenderSystem* renSys, NDL_ParticleEmitter* em)
+{
+    if (em->count == 0) return;
+    if (em->count > em->vertexCapacity)
+    {
+        int old = em->vertexCapacity;
+        em->vertexCapacity = em->capacity;
+        em->vertices = realloc(em->vertices, sizeof(SDL_Vertex)*4*em->vertexCapacity);
+        em->indices = realloc(em->indices, sizeof(int)*6*em->vertexCapacity);
+        for (int q = old; q < em->vertexCapacity; ++q)
+        {
+            int* i = em->indices + q*6;
+            i[0] = q*4; i[1] = q*4 + 1; i[2] = q*4 + 2;
+            i[3] = q*4 + 2; i[4] = q*4 + 3; i[5] = q*4;
+        }
+    }
+    Vector2F cam = renSys->camera != NULL ? renSys->camera->position : (Vector2F){0,0};
+    float zoom = NDL_CameraZoom_G(renSys->camera);
+    float u0 = em->uv.x, v0 = em->uv.y, u1 = em->uv.x + em->uv.w, v1 = em->uv.y + em->uv.h;
+    for (int p = 0; p < em->count; ++p)
+    {
+        // Quads are centred on the particle
+        float h = em->size[p]*0.5f;
+        float x0 = (em->x[p] - cam.x - h)*zoom, y0 = (em->y[p] - cam.y - h)*zoom;
+        float x1 = x0 + em->size[p]*zoom, y1 = y0 + em->size[p]*zoom;
+        NDL_Color c;
+        memcpy(&c, &em->color[p], sizeof(NDL_Color));
+        SDL_Vertex* v = em->vertices + p*4;
+        v[0] = (SDL_Vertex){{x0, y0}, c, {u0, v0}};
+        v[1] = (SDL_Vertex){{x1, y0}, c, {u1, v0}};
+        v[2] = (SDL_Vertex){{x1, y1}, c, {u1, v1}};
+        v[3] = (SDL_Vertex){{x0, y1}, c, {u0, v1}};
+    }
+    NDL_Texture* texture = NDL_GetTextureLOD(em->texture, zoom, NULL);
+    SDL_RenderGeometry(renSys->sdlRenderer, texture, em->vertices, em->count*4, em->indices, em->count*6);
+    NDL_CountDraw_G(renSys->sdlRenderer, texture, em->count*4);
+    ++renSys->drawCalls;
+}
+
+void NDL_RenderVerletSystem(NDL_RenderSystem* renSys, NDL_VerletSystem* vs)
+{
+    Renderer ren = renSys->sdlRenderer;
+    Vector2F cam = renSys->camera != NULL ? renSys->camera->position : (Vector2F){0,0};
+    float zoom = NDL_CameraZoom_G(renSys->camera);
+    NDL_SetDrawColor(ren, vs->color);
+    for (int s = 0; s < vs->stripCount; ++s)
+    {
+        const int* indices = vs->stripIndices + vs->stripStart[s];
+        int count = vs->stripLength[s];
+        for (int i = 0; i < count; ++i)
+        {
+            vs->stripPoints[i].x = (vs->x[indices[i]] - cam.x)*zoom;
+            vs->stripPoints[i].y = (vs->y[indices[i]] - cam.y)*zoom;
+        }
+        SDL_RenderDrawLinesF(ren, vs->stripPoints, count);
+        NDL_CountDraw_G(ren, NULL, count);
+    }
 }
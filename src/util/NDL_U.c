@@ -156,6 +156,254 @@ void NDL_CapFPS(NDL_Clock* clock) {
     }
 }
 
+void NDL_InitFrameScheduler(NDL_FrameScheduler* scheduler, bool idle)
+{
+    *scheduler = (NDL_FrameScheduler){0};
+    scheduler->idle = idle;
+    // The first frame always renders
+    scheduler->dirty = true;
+}
+
+void NDL_SetIdleRendering(NDL_FrameScheduler* scheduler, bool idle)
+{
+    scheduler->idle = idle;
+    scheduler->dirty = true;
+}
+
+void NDL_RequestRedraw(NDL_FrameScheduler* scheduler)
+{
+    scheduler->dirty = true;
+}
+
+void NDL_ScheduleRedraw(NDL_FrameScheduler* scheduler, Uint32 delayMs)
+{
+    Uint32 due = SDL_GetTicks() + delayMs;
+    // Kept sorted; when full, a timer due before the last one replaces it
+    int i = scheduler->timerCount;
+    if (i == NDL_SCHEDULER_TIMERS)
+    {
+        if (SDL_TICKS_PASSED(due, scheduler->timers[i - 1])) return;
+        --i;
+    } else {
+        ++scheduler->timerCount;
+    }
+    for (; i > 0 && !SDL_TICKS_PASSED(due, scheduler->timers[i - 1]); --i) scheduler->timers[i] = scheduler->timers[i - 1];
+    scheduler->timers[i] = due;
+}
+
+void NDL_RequestAnimation(NDL_FrameScheduler* scheduler, Uint32 durationMs)
+{
+    Uint32 until = SDL_GetTicks() + durationMs;
+    if (!SDL_TICKS_PASSED(scheduler->animateUntil, until)) scheduler->animateUntil = until;
+    scheduler->dirty = true;
+}
+
+// Milliseconds until the scheduler next needs a frame: 0 if now, -1 if only input can wake it
+static int NDL_SchedulerTimeout_U(NDL_FrameScheduler* scheduler, Uint32 now)
+{
+    if (!scheduler->idle || scheduler->dirty || !SDL_TICKS_PASSED(now, scheduler->animateUntil)) return 0;
+    if (scheduler->timerCount == 0) return -1;
+    if (SDL_TICKS_PASSED(now, scheduler->timers[0])) return 0;
+    return (int)(scheduler->timers[0] - now);
+}
+
+bool NDL_GetScheduledEvent(NDL_FrameScheduler* scheduler, Event* event, Window window, Renderer renderer)
+{
+    bool got = false;
+    if (!scheduler->waited)
+    {
+        scheduler->waited = true;
+        Uint32 start = SDL_GetTicks();
+        int timeout = NDL_SchedulerTimeout_U(scheduler, start);
+        if (timeout != 0)
+        {
+            got = SDL_WaitEventTimeout(event, timeout) != 0;
+            scheduler->idleTime = SDL_GetTicks() - start;
+            if (got && event->type == SDL_QUIT)
+            {
+                // Same handling as NDL_GetEvent
+                SDL_DestroyWindow(window);
+                SDL_DestroyRenderer(renderer);
+                SDL_Quit();
+            }
+        }
+    }
+    if (!got) got = NDL_GetEvent(event, window, renderer);
+    if (got) scheduler->dirty = true;
+    return got;
+}
+
+bool NDL_BeginScheduledFrame(NDL_FrameScheduler* scheduler, NDL_Clock* clock)
+{
+    Uint32 now = SDL_GetTicks();
+    int due = 0;
+    while (due < scheduler->timerCount && SDL_TICKS_PASSED(now, scheduler->timers[due])) ++due;
+    bool timerDue = due > 0;
+    bool render = !scheduler->idle || scheduler->dirty || timerDue || !SDL_TICKS_PASSED(now, scheduler->animateUntil);
+    scheduler->waited = false;
+    if (!render)
+    {
+        ++scheduler->skippedFrames;
+        return false;
+    }
+    // Fired timers are dropped; later ones stay pending
+    if (timerDue)
+    {
+        scheduler->timerCount -= due;
+        memmove(scheduler->timers, scheduler->timers + due, sizeof(Uint32)*scheduler->timerCount);
+    }
+    scheduler->dirty = false;
+    if (clock != NULL && scheduler->idleTime > 0 && clock->deltaTime > clock->TPF / 1000.0f) clock->deltaTime = clock->TPF / 1000.0f;
+    scheduler->idleTime = 0;
+    ++scheduler->renderedFrames;
+    return true;
+}
+
+double NDL_GetElapsedMs(Uint64 startCounter)
+{
+    return (double)(SDL_GetPerformanceCounter() - startCounter) * 1000.0 / (double)SDL_GetPerformanceFrequency();
+}
+
+// CPU feature queries are cached, since the SIMD paths check them on every call
+bool NDL_HasSSE2()
+{
+    static int hasSSE2 = -1;
+    if (hasSSE2 < 0) hasSSE2 = SDL_HasSSE2() ? 1 : 0;
+    return hasSSE2;
+}
+
+bool NDL_HasAVX2()
+{
+    static int hasAVX2 = -1;
+    if (hasAVX2 < 0) hasAVX2 = SDL_HasAVX2() ? 1 : 0;
+    return hasAVX2;
+}
+
+static int NDL_ThreadPoolWorker_U(void* data)
+{
+    NDL_ThreadPool* pool = data;
+    for (;;)
+    {
+        SDL_SemWait(pool->start);
+        if (SDL_AtomicGet(&pool->quit)) break;
+        int i;
+        while ((i = SDL_AtomicAdd(&pool->next, 1)) < pool->jobCount) pool->job(pool->userData, i);
+        SDL_SemPost(pool->done);
+    }
+    return 0;
+}
+
+NDL_ThreadPool* NDL_CreateThreadPool(int threadCount)
+{
+    if (threadCount <= 0) threadCount = SDL_GetCPUCount() - 1;
+    if (threadCount < 0) threadCount = 0;
+    NDL_ThreadPool* pool = malloc(sizeof(NDL_ThreadPool));
+    pool->threadCount = 0;
+    pool->threads = malloc(sizeof(SDL_Thread*)*(threadCount > 0 ? threadCount : 1));
+    pool->start = SDL_CreateSemaphore(0);
+    pool->done = SDL_CreateSemaphore(0);
+    SDL_AtomicSet(&pool->next, 0);
+    SDL_AtomicSet(&pool->quit, 0);
+    pool->jobCount = 0;
+    pool->job = NULL;
+    pool->userData = NULL;
+    for (int t = 0; t < threadCount; ++t)
+    {
+        SDL_Thread* thread = SDL_CreateThread(NDL_ThreadPoolWorker_U, "NDL_Worker", pool);
+        if (thread == NULL)
+        {
+            printf("Error creating worker thread: %s\n", SDL_GetError());
+            break;
+        }
+        pool->threads[pool->threadCount++] = thread;
+    }
+    return pool;
+}
+
+void NDL_DestroyThreadPool(NDL_ThreadPool* pool)
+{
+    SDL_AtomicSet(&pool->quit, 1);
+    for (int t = 0; t < pool->threadCount; ++t) SDL_SemPost(pool->start);
+    for (int t = 0; t < pool->threadCount; ++t) SDL_WaitThread(pool->threads[t], NULL);
+    SDL_DestroySemaphore(pool->start);
+    SDL_DestroySemaphore(pool->done);
+    free(pool->threads);
+    free(pool);
+}
+
+void NDL_RunParallel(NDL_ThreadPool* pool, int jobCount, NDL_JobMethod job, void* userData)
+{
+    if (jobCount <= 0) return;
+    if (pool == NULL || pool->threadCount == 0 || jobCount == 1)
+    {
+        for (int i = 0; i < jobCount; ++i) job(userData, i);
+        return;
+    }
+    pool->job = job;
+    pool->userData = userData;
+    pool->jobCount = jobCount;
+    SDL_AtomicSet(&pool->next, 0);
+    // Semaphore posts/waits order these writes before the workers read them
+    for (int t = 0; t < pool->threadCount; ++t) SDL_SemPost(pool->start);
+    int i;
+    while ((i = SDL_AtomicAdd(&pool->next, 1)) < jobCount) job(userData, i);
+    for (int t = 0; t < pool->threadCount; ++t) SDL_SemWait(pool->done);
+}
+
+int NDL_FormatInt(char* buffer, int size, long long value)
+{
+    if (size <= 0) return 0;
+    char digits[24];
+    int n = 0;
+    unsigned long long v = value < 0 ? 0ull - (unsigned long long)value : (unsigned long long)value;
+    do
+    {
+        digits[n++] = (char)('0' + v % 10);
+        v /= 10;
+    } while (v != 0);
+    if (value < 0) digits[n++] = '-';
+    int length = 0;
+    while (n > 0 && length < size - 1) buffer[length++] = digits[--n];
+    buffer[length] = '\0';
+    return length;
+}
+
+int NDL_FormatFloat(char* buffer, int size, double value, int decimals)
+{
+    if (size <= 0) return 0;
+    char text[64];
+    int length = 0;
+    decimals = SDL_clamp(decimals, 0, 9);
+    unsigned long long scale = 1;
+    for (int d = 0; d < decimals; ++d) scale *= 10;
+    if (value != value)
+    {
+        length = snprintf(text, sizeof(text), "nan");
+    } else if (fabs(value)*scale >= 9.0e18) {
+        // Beyond fixed point in 64 bits; snprintf does not allocate either, just slower
+        length = snprintf(text, sizeof(text), "%.*g", decimals + 1, value);
+    } else {
+        unsigned long long rounded = (unsigned long long)(fabs(value)*scale + 0.5);
+        if (value < 0 && rounded != 0) text[length++] = '-';
+        length += NDL_FormatInt(text + length, (int)sizeof(text) - length, (long long)(rounded/scale));
+        if (decimals > 0)
+        {
+            unsigned long long fraction = rounded % scale;
+            text[length++] = '.';
+            for (int d = decimals - 1; d >= 0; --d)
+            {
+                text[length + d] = (char)('0' + fraction % 10);
+                fraction /= 10;
+            }
+            length += decimals;
+        }
+    }
+    length = SDL_min(length, size - 1);
+    memcpy(buffer, text, length);
+    buffer[length] = '\0';
+    return length;
+}
+
 int NDL_IsMouseHover(int mouseX, int mouseY, int pointX, int pointY, int size)
 {
     return (mouseX >= pointX - size/2 && mouseX <= pointX + size/2 &&
@@ -240,9 +488,19 @@ NDL_Camera* NDL_CreateCamera(Vector2F position, float panSpeed, float interpolat
     cam->cameraSpeed = panSpeed;
     cam->scrollInterpolation = interpolation;
     cam->position = position;
+    cam->zoom = 1.0f;
     return cam;
 }
 
+void NDL_SetCameraZoom(NDL_Camera* cam, float zoom, Vector2F anchor)
+{
+    if (zoom <= 0.0f) return;
+    // Keep the world point under the anchor (in screen pixels) where it is
+    cam->position.x += anchor.x/cam->zoom - anchor.x/zoom;
+    cam->position.y += anchor.y/cam->zoom - anchor.y/zoom;
+    cam->zoom = zoom;
+}
+
 void NDL_CenterCameraOnEntity(Window win, NDL_Camera* cam, NDL_Entity* entity, float deltaTime)
 {
     Vector2F targetCenter = {entity->position.x + entity->sprite->imageRect.w / 2, entity->position.y + entity->sprite->imageRect.h / 2};